@@ -0,0 +1,87 @@
+#!/usr/bin/python
+
+from dataclasses import dataclass
+import os
+
+import backend
+
+
+@dataclass
+class SweepPoint:
+	deletion_probability: float
+	# The rate of the BAA's distribution and its derivatives by the deletion probability at that distribution (in bits).
+	rate: float
+	derivative: float
+	second_derivative: float
+
+
+def hermite_interpolate(a: SweepPoint, b: SweepPoint, deletion_probability: float):
+	"""
+	The cubic Hermite interpolation of the rate between two points of a sweep, from their rates and first derivatives.
+	"""
+	width = b.deletion_probability - a.deletion_probability
+	t = (deletion_probability - a.deletion_probability) / width
+	return ((2 * t**3 - 3 * t**2 + 1) * a.rate + (t**3 - 2 * t**2 + t) * width * a.derivative +
+		(-2 * t**3 + 3 * t**2) * b.rate + (t**3 - t**2) * width * b.derivative)
+
+
+def interval_error_estimate(a: SweepPoint, b: SweepPoint):
+	"""
+	Estimates the error of the interpolation between two neighbouring points by how far apart the second order Taylor
+	expansions around either end land at the middle of the interval. Both are accurate to the third order where the
+	curve is smooth over the interval, so they only disagree where the interval is too wide for the interpolation.
+	"""
+	half_width = (b.deletion_probability - a.deletion_probability) / 2
+	from_a = a.rate + a.derivative * half_width + a.second_derivative * half_width**2 / 2
+	from_b = b.rate - b.derivative * half_width + b.second_derivative * half_width**2 / 2
+	return abs(from_a - from_b) / 2
+
+
+def run_sweep_points(deletion_probabilities: list, in_len: int, out_len: int, up_to: bool, work_folder: str,
+	round_index: int, num_threads: int, accuracy: float):
+	"""
+	Runs the batch scheduler on the deletion probabilities of a round of the sweep and returns their points.
+	"""
+	manifest_filename = os.path.join(work_folder, "sweep_manifest_%d.txt" % round_index)
+	results_filename = os.path.join(work_folder, "sweep_results_%d.txt" % round_index)
+	with open(manifest_filename, "w") as manifest_file:
+		for deletion_probability in deletion_probabilities:
+			manifest_file.write("%d %d %r %d\n" % (in_len, out_len, deletion_probability, int(up_to)))
+	if os.path.exists(results_filename):
+		os.remove(results_filename)
+	results = backend.run_batch(manifest_filename, results_filename, num_threads, accuracy)
+	return [SweepPoint(float(result["deletion_probability"]), float(result["rate"]), float(result["derivative"]),
+		float(result["second_derivative"])) for result in results]
+
+
+def adaptive_sweep(in_len: int, out_len: int, up_to: bool, min_deletion_probability: float, max_deletion_probability: float,
+	target_error: float, work_folder: str, num_initial_points: int = 5, max_points: int = 64, num_threads: int = 0,
+	accuracy: float = 0.05):
+	"""
+	Sweeps the rate of the (in_len, out_len) channel over the deletion probabilities in [min, max], placing the points
+	where the curve bends rather than on a uniform grid.
+	Starts from a uniform grid of num_initial_points, and in every round runs the BAA (through the batch scheduler, which
+	warm starts the neighbouring points from each other) at the middle of every interval whose interval_error_estimate
+	is above target_error (in bits), the worst intervals first, until every interval is below the target or max_points
+	were run. Returns the points sorted by the deletion probability, to be interpolated by hermite_interpolate.
+	Only the up_to channels depend on the deletion probability. Note that the derivatives are those of the rate at the
+	BAA's final distribution (see compute_bit_rate_derivative_sums in the backend), which miss how that distribution moves
+	with the deletion probability; the error estimate picks the mismatch up, so it costs points rather than accuracy.
+	"""
+	assert up_to, "Without up_to, the channel does not depend on the deletion probability."
+	assert num_initial_points >= 2 and max_points >= num_initial_points
+	os.makedirs(work_folder, exist_ok=True)
+	step = (max_deletion_probability - min_deletion_probability) / (num_initial_points - 1)
+	new_deletion_probabilities = [min_deletion_probability + i * step for i in range(num_initial_points)]
+	points = []
+	round_index = 0
+	while new_deletion_probabilities:
+		points += run_sweep_points(new_deletion_probabilities, in_len, out_len, up_to, work_folder, round_index,
+			num_threads, accuracy)
+		points.sort(key=lambda point: point.deletion_probability)
+		round_index += 1
+		errors = [(interval_error_estimate(points[i], points[i + 1]), i) for i in range(len(points) - 1)]
+		errors = sorted([error for error in errors if error[0] > target_error], reverse=True)
+		new_deletion_probabilities = [(points[i].deletion_probability + points[i + 1].deletion_probability) / 2
+			for _, i in errors[:max_points - len(points)]]
+	return points
@@ -3,16 +3,47 @@
 import subprocess
 import communicate_with_cpp
 import logging
+import os
 BINARY_PATH = "/mnt/d/Work/Current Projects/BDC/Better Lower Bounds/BAA_in_cpp/backend/bit_channel_slave.out"
+SCHEDULER_BINARY_PATH = os.path.join(os.path.dirname(BINARY_PATH), "baa_scheduler.out")
+# Bumped whenever a change to the backend may change its results, so that stored results of older engines are not reused.
+ENGINE_VERSION = 2
+# The symmetries that gen_codewords uses to reduce the transmitted alphabet (only the NOT symmetry for now).
+TRANSMITTED_SYMMETRIES = "complement"
 GENERATE_CODEWORDS = "gen_codewords";
 COMPUTE_DENOMS = "denominators";
+COMPUTE_DENOMS_DELTA = "denominators_delta";
 COMPUTE_ALPHAS = "alphas";
 COMPUTE_RATE = "rate";
+PLAN_RESOURCES = "plan";
+ESTIMATE_RATE_MONTE_CARLO = "mc_rate";
+SIMULATE_CHANNEL = "simulate";
+MERGE_SUMS = "merge_sums";
+DUAL_BOUND = "dual_bound";
+CERTIFY = "certify";
 
-def run_backend(*params):
+def run_backend(*params, shard_index: int = -1):
 	logging.info('Backend called with the following args:'.encode('utf-8'))
 	logging.info(' '.join(["'" + BINARY_PATH + "'"] + [str(x) for x in params]).encode('utf-8'))
-	return subprocess.Popen([BINARY_PATH] + [str(x) for x in params])
+	env = None
+	if shard_index >= 0:
+		# Used by the backend to place the shard on a NUMA node (see backend/numa_placement.h).
+		env = dict(os.environ, BDC_SHARD_INDEX=str(shard_index))
+	return subprocess.Popen([BINARY_PATH] + [str(x) for x in params], env=env)
+
+def plan_resources(input_len: int, output_len: int, up_to: bool, num_workers: int):
+	"""
+	Uses the backend to predict the memory and runtime of a BAA run with the given number of workers.
+	Returns the plan as a dictionary, or raises a RuntimeError if the configuration cannot run on this node.
+	"""
+	params = [PLAN_RESOURCES, input_len, output_len, int(up_to), num_workers]
+	logging.info(' '.join(["'" + BINARY_PATH + "'"] + [str(x) for x in params]).encode('utf-8'))
+	proc = subprocess.run([BINARY_PATH] + [str(x) for x in params], capture_output=True, text=True)
+	plan = dict(line.split(' = ', 1) for line in proc.stdout.splitlines() if ' = ' in line)
+	if proc.returncode != 0:
+		raise RuntimeError(f"Refusing to run BAA on (in_len={input_len}, out_len={output_len}, up_to={up_to}): " +
+			plan.get('reason', proc.stderr.strip()))
+	return plan
 
 def generate_codewords(up_to: bool, max_len: int, output_filename: str, transmitted: int):
 	"""
@@ -20,35 +51,122 @@ def generate_codewords(up_to: bool, max_len: int, output_filename: str, transmit
 	"""
 	run_backend(GENERATE_CODEWORDS, int(up_to), max_len, output_filename, transmitted).wait()
 
-def compute_log_dens(transmitted_codewords_filename: str, received_codewords_filename: str, 
+def compute_den_sums(transmitted_codewords_filename: str, received_codewords_filename: str, 
 	start: int, end: int, Q_array_filename: str, deletion_probability: float, output_file_name: str, 
-	input_len: int, output_len: int, up_to: bool):
+	input_len: int, output_len: int, up_to: bool, shard_index: int = -1):
 	"""
-	Uses the backend to compute a part of the log_den arrays.
+	Uses the backend to compute the partial sums of the denominators over a part of the transmitted codewords.
+	The partial sums are saved to the output file, to be merged by merge_sums.
 	"""
 	run_backend(COMPUTE_DENOMS, transmitted_codewords_filename, received_codewords_filename, 
-		start, end, Q_array_filename, deletion_probability, output_file_name, input_len, output_len, int(up_to)).wait()
-	result = communicate_with_cpp.load_1d_array(output_file_name)
-	return result
+		start, end, Q_array_filename, deletion_probability, output_file_name, input_len, output_len, int(up_to),
+		shard_index=shard_index).wait()
+	return output_file_name
+
+def compute_den_sums_incremental(transmitted_codewords_filename: str, received_codewords_filename: str, 
+	start: int, end: int, Q_array_filename: str, deletion_probability: float, output_file_name: str, 
+	input_len: int, output_len: int, up_to: bool, Q_applied_filename: str, dens_state_filename: str, tolerance: float,
+	shard_index: int = -1):
+	"""
+	Uses the backend to update the partial sums of the denominators of a part of the transmitted codewords with the entries
+	of Q that changed by more than the tolerance.
+	"""
+	run_backend(COMPUTE_DENOMS_DELTA, transmitted_codewords_filename, received_codewords_filename, 
+		start, end, Q_array_filename, deletion_probability, output_file_name, input_len, output_len, int(up_to),
+		Q_applied_filename, dens_state_filename, tolerance, shard_index=shard_index).wait()
+	return output_file_name
 
 def compute_alphas(transmitted_codewords_filename: str, received_codewords_filename: str, 
 	start: int, end: int, Q_array_filename: str, deletion_probability: float, output_file_name: str, 
-	input_len: int, output_len: int, up_to: bool, log_dens: str):
+	input_len: int, output_len: int, up_to: bool, log_dens: str, shard_index: int = -1):
 	"""
 	Uses the backend to compute a part of the log_den arrays.
 	"""
 	run_backend(COMPUTE_ALPHAS, transmitted_codewords_filename, received_codewords_filename, 
-		start, end, Q_array_filename, deletion_probability, log_dens, output_file_name, input_len, output_len, int(up_to)).wait()
+		start, end, Q_array_filename, deletion_probability, log_dens, output_file_name, input_len, output_len, int(up_to),
+		shard_index=shard_index).wait()
 	result = communicate_with_cpp.load_1d_array(output_file_name)
 	return result
 
-def compute_rate(transmitted_codewords_filename: str, received_codewords_filename: str, 
+def compute_rate_sum(transmitted_codewords_filename: str, received_codewords_filename: str, 
 	start: int, end: int, Q_array_filename: str, deletion_probability: float, output_file_name: str, 
-	input_len: int, output_len: int, up_to: bool, log_dens: str):
+	input_len: int, output_len: int, up_to: bool, log_dens: str, shard_index: int = -1):
 	"""
-	Uses the backend to compute a part of the log_den arrays.
+	Uses the backend to compute the partial sum of the rate over a part of the transmitted codewords, along with the
+	partial sums of its first and second derivatives by the deletion probability (at the fixed Q).
+	The partial sums are saved to the output file, to be merged by merge_sums.
 	"""
 	run_backend(COMPUTE_RATE, transmitted_codewords_filename, received_codewords_filename, 
-		start, end, Q_array_filename, deletion_probability, log_dens, output_file_name, input_len, output_len, int(up_to)).wait()
+		start, end, Q_array_filename, deletion_probability, log_dens, output_file_name, input_len, output_len, int(up_to),
+		shard_index=shard_index).wait()
+	return output_file_name
+
+def merge_sums(input_filenames, output_filename: str, log_dens: bool):
+	"""
+	Uses the backend to merge the partial sums of the shards. The result is the same for every split of the transmitted
+	codewords into shards. With log_dens the result is the array of log denominators, otherwise the plain sums.
+	"""
+	run_backend(MERGE_SUMS, output_filename, int(log_dens), *input_filenames).wait()
+	return communicate_with_cpp.load_1d_array(output_filename)
+
+def estimate_rate_monte_carlo(input_len: int, output_len: int, up_to: bool, deletion_probability: float,
+	first_one_prob: float, zero_to_one_prob: float, one_to_zero_prob: float, output_file_name: str,
+	target_half_width: float = 1E-3, max_samples: int = 1 << 24, seed: int = 0, num_threads: int = 0):
+	"""
+	Uses the backend to estimate the rate (in nats) of a Markov input distribution by sampling.
+	Returns (rate, half width of the confidence interval, number of samples, whether it converged).
+	"""
+	run_backend(ESTIMATE_RATE_MONTE_CARLO, input_len, output_len, int(up_to), deletion_probability,
+		first_one_prob, zero_to_one_prob, one_to_zero_prob, target_half_width, max_samples, seed, num_threads,
+		output_file_name).wait()
+	result = communicate_with_cpp.load_1d_array(output_file_name)
+	return result[0], result[2], int(result[3]), bool(result[4])
+
+def simulate_channel(transmitted_codewords_filename: str, deletion_probability: float, input_len: int, output_len: int,
+	up_to: bool, samples_per_codeword: int, seed: int, output_file_name: str):
+	"""
+	Uses the backend to transmit every codeword of the given file samples_per_codeword times through the deletion channel.
+	The received codewords are saved to the output file, in the same format as the codeword files.
+	"""
+	run_backend(SIMULATE_CHANNEL, transmitted_codewords_filename, deletion_probability, input_len, output_len, int(up_to),
+		samples_per_codeword, seed, output_file_name).wait()
+
+def dual_bound(transmitted_codewords_filename: str, received_codewords_filename: str, R_array_filename: str,
+	deletion_probability: float, input_len: int, output_len: int, up_to: bool, output_file_name: str,
+	num_maximisers: int = 10, num_threads: int = 0):
+	"""
+	Uses the backend to upper bound the capacity by max_t D(P_t || R) for the output distribution R (an array aligned with
+	the received codewords), in a single pass over the transmitted codewords and without running the BAA.
+	Returns the bound (in nats) and the maximising inputs as (index into the transmitted codewords, divergence) pairs.
+	"""
+	run_backend(DUAL_BOUND, transmitted_codewords_filename, received_codewords_filename, R_array_filename,
+		deletion_probability, input_len, output_len, int(up_to), num_maximisers, num_threads, output_file_name).wait()
+	result = communicate_with_cpp.load_1d_array(output_file_name)
+	return result[0], [(int(result[i]), result[i + 1]) for i in range(2, len(result), 2)]
+
+def certify(transmitted_codewords_filename: str, received_codewords_filename: str, Q_array_filename: str,
+	deletion_probability: float, input_len: int, output_len: int, up_to: bool, output_file_name: str, num_threads: int = 0):
+	"""
+	Uses the backend to evaluate the rate and the dual bound of the distribution Q with interval arithmetic.
+	Returns ((rate_lo, rate_hi), (bound_lo, bound_hi)) in nats: the capacity is certified to lie in [rate_lo, bound_hi].
+	"""
+	run_backend(CERTIFY, transmitted_codewords_filename, received_codewords_filename, Q_array_filename,
+		deletion_probability, input_len, output_len, int(up_to), num_threads, output_file_name).wait()
 	result = communicate_with_cpp.load_1d_array(output_file_name)
-	return result[0]
+	return (result[0], result[1]), (result[2], result[3])
+
+def run_batch(manifest_filename: str, results_filename: str, num_threads: int = 0, accuracy: float = 0.05,
+	max_iterations: int = 100000, Q_folder: str = None):
+	"""
+	Uses the batch scheduler of the backend to run the BAA on every configuration of the manifest (a line of
+	"in_len out_len deletion_probability up_to" per configuration) in a single process.
+	Returns the results (a dictionary per configuration, in the order in which they finished).
+	"""
+	params = [manifest_filename, results_filename, num_threads, accuracy, max_iterations]
+	if Q_folder is not None:
+		params.append(Q_folder)
+	logging.info(' '.join(["'" + SCHEDULER_BINARY_PATH + "'"] + [str(x) for x in params]).encode('utf-8'))
+	subprocess.run([SCHEDULER_BINARY_PATH] + [str(x) for x in params], check=True)
+	with open(results_filename) as results_file:
+		header = results_file.readline().lstrip('# ').split()
+		return [dict(zip(header, line.split())) for line in results_file if line.strip()]
@@ -0,0 +1,151 @@
+#include "arena_allocator.h"
+#include <sys/mman.h>
+#include <cstring>
+
+
+static inline size_t round_up(size_t size, size_t alignment){
+	return ((size + alignment - 1) / alignment) * alignment;
+}
+
+
+HugePageArena::HugePageArena(HugePageMode mode) : _mode(mode), _mapped_bytes(0), _allocated_bytes(0), _hugetlb_bytes(0) {}
+
+
+HugePageArena::~HugePageArena(){
+	release_all();
+}
+
+
+HugePageArena::Chunk HugePageArena::map_chunk(size_t min_size){
+	size_t size = round_up(std::max(min_size, ARENA_CHUNK_SIZE), HUGE_PAGE_SIZE);
+	if (_mode == HUGE_PAGES_HUGETLB)
+	{
+		void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (ptr != MAP_FAILED)
+		{
+			_hugetlb_bytes += size;
+			return Chunk{static_cast<uint8_t*>(ptr), size, 0};
+		}
+		// The reserved pool (vm.nr_hugepages) is too small, fall back to transparent huge pages.
+	}
+	if (_mode == HUGE_PAGES_OFF)
+	{
+		void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED)
+		{
+			fprintf(stderr, "Failed to map %lu bytes for the engine arena.\n", size);
+			exit(1);
+		}
+		return Chunk{static_cast<uint8_t*>(ptr), size, 0};
+	}
+
+	// Over-map by a huge page so that the chunk can start on a huge page boundary, and trim the ends.
+	void* raw = mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (raw == MAP_FAILED)
+	{
+		fprintf(stderr, "Failed to map %lu bytes for the engine arena.\n", size);
+		exit(1);
+	}
+	uint8_t* raw_base = static_cast<uint8_t*>(raw);
+	uint8_t* base = reinterpret_cast<uint8_t*>(round_up(reinterpret_cast<uintptr_t>(raw_base), HUGE_PAGE_SIZE));
+	if (base > raw_base)
+	{
+		munmap(raw_base, base - raw_base);
+	}
+	munmap(base + size, (raw_base + size + HUGE_PAGE_SIZE) - (base + size));
+	madvise(base, size, MADV_HUGEPAGE);
+	return Chunk{base, size, 0};
+}
+
+
+void* HugePageArena::allocate(size_t size, size_t alignment){
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (size == 0)
+	{
+		size = 1;
+	}
+	if (not _chunks.empty())
+	{
+		Chunk& chunk = _chunks.back();
+		size_t offset = round_up(chunk.used, alignment);
+		if (offset + size <= chunk.size)
+		{
+			chunk.used = offset + size;
+			_allocated_bytes += size;
+			return chunk.base + offset;
+		}
+	}
+	Chunk chunk = map_chunk(size);
+	_mapped_bytes += chunk.size;
+	chunk.used = size;
+	_allocated_bytes += size;
+	// Keep the chunk with the most free space last, so that a large allocation does not end the current chunk.
+	if (not _chunks.empty() and (chunk.size - chunk.used) < (_chunks.back().size - _chunks.back().used))
+	{
+		_chunks.insert(_chunks.end() - 1, chunk);
+		return chunk.base;
+	}
+	_chunks.push_back(chunk);
+	return chunk.base;
+}
+
+
+void HugePageArena::deallocate(void* ptr, size_t size){
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (ptr == NULL or _chunks.empty())
+	{
+		return;
+	}
+	if (size == 0)
+	{
+		size = 1;
+	}
+	// Only the most recent allocation of the current chunk can be given back.
+	Chunk& chunk = _chunks.back();
+	uint8_t* bytes = static_cast<uint8_t*>(ptr);
+	if (bytes + size == chunk.base + chunk.used)
+	{
+		chunk.used -= size;
+		_allocated_bytes -= size;
+	}
+}
+
+
+void HugePageArena::release_all(){
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (const auto& chunk : _chunks)
+	{
+		munmap(chunk.base, chunk.size);
+	}
+	_chunks.clear();
+	_mapped_bytes = 0;
+	_allocated_bytes = 0;
+	_hugetlb_bytes = 0;
+}
+
+
+static HugePageMode huge_page_mode_from_env(){
+	const char* mode = getenv("BDC_HUGE_PAGES");
+	if (mode == NULL or mode[0] == '\0' or !strcmp(mode, "madvise"))
+	{
+		return HUGE_PAGES_MADVISE;
+	} else if (!strcmp(mode, "hugetlb")){
+		return HUGE_PAGES_HUGETLB;
+	} else if (!strcmp(mode, "off")){
+		return HUGE_PAGES_OFF;
+	}
+	fprintf(stderr, "Unknown huge page mode %s (expected madvise, hugetlb or off).\n", mode);
+	exit(1);
+}
+
+
+HugePageArena& get_engine_arena(){
+	// Never destroyed: tables in static storage may still hand their buffers back after main returns.
+	static HugePageArena* arena = new HugePageArena(huge_page_mode_from_env());
+	return *arena;
+}
+
+
+void release_engine_arena(){
+	get_engine_arena().release_all();
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include "utils.h"
+#include <cstdint>
+#include <mutex>
+
+
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+// Enough for the widest SIMD loads (and a cache line).
+constexpr size_t ARENA_ALIGNMENT = 64;
+// The arena maps memory in chunks of at least this size (larger requests get a chunk of their own).
+constexpr size_t ARENA_CHUNK_SIZE = 32 * HUGE_PAGE_SIZE;
+
+/*
+How the arena asks for huge pages (BDC_HUGE_PAGES):
+	- madvise (the default): 2 MB aligned anonymous mappings marked with MADV_HUGEPAGE (transparent huge pages).
+	- hugetlb: MAP_HUGETLB mappings from the reserved huge page pool, falling back to madvise when the pool is empty.
+	- off: plain anonymous mappings.
+*/
+enum HugePageMode
+{
+	HUGE_PAGES_OFF,
+	HUGE_PAGES_MADVISE,
+	HUGE_PAGES_HUGETLB
+};
+
+/*
+A bump allocator over large anonymous mappings, for the big tables of the engine that live until the process exits.
+Freeing is a no-op (except for the most recent allocation, so that a growing vector does not waste its old buffer);
+	all of the memory is returned at once by release_all.
+*/
+class HugePageArena
+{
+public:
+	explicit HugePageArena(HugePageMode mode);
+	~HugePageArena();
+
+	void* allocate(size_t size, size_t alignment = ARENA_ALIGNMENT);
+	void deallocate(void* ptr, size_t size);
+
+	/*
+	Unmaps all of the chunks. Everything that was allocated from the arena is invalid afterwards.
+	*/
+	void release_all();
+
+	size_t mapped_bytes() const { return _mapped_bytes; }
+	size_t allocated_bytes() const { return _allocated_bytes; }
+	// The bytes mapped with MAP_HUGETLB, which are guaranteed to be huge pages (madvise is only a hint).
+	size_t hugetlb_bytes() const { return _hugetlb_bytes; }
+
+private:
+	struct Chunk
+	{
+		uint8_t* base;
+		size_t size;
+		size_t used;
+	};
+
+	Chunk map_chunk(size_t min_size);
+
+	HugePageMode _mode;
+	std::vector<Chunk> _chunks;
+	size_t _mapped_bytes;
+	size_t _allocated_bytes;
+	size_t _hugetlb_bytes;
+	std::mutex _mutex;
+};
+
+/*
+The arena used by the engine's tables, configured from BDC_HUGE_PAGES on first use.
+*/
+HugePageArena& get_engine_arena();
+
+/*
+Frees all of the engine's tables at once (at shutdown).
+*/
+void release_engine_arena();
+
+/*
+A standard allocator on top of the engine arena.
+*/
+template <typename T>
+struct ArenaAllocator
+{
+	typedef T value_type;
+
+	ArenaAllocator() = default;
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>&) {}
+
+	T* allocate(size_t n){
+		return static_cast<T*>(get_engine_arena().allocate(n * sizeof(T), std::max(ARENA_ALIGNMENT, alignof(T))));
+	}
+
+	void deallocate(T* ptr, size_t n){
+		get_engine_arena().deallocate(ptr, n * sizeof(T));
+	}
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>&) const { return true; }
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>&) const { return false; }
+};
+
+/*
+Only the tables that live until the process exits (the transition count tables, see cached_transition_probs.h) belong in
+	the arena. The codeword sets and the Q, denominator and alpha arrays stay std::vector: the BAA allocates the latter
+	anew in every step, and as the frees are no-ops the arena would keep all of them until release_all, while all of
+	them are streamed in order, where huge pages save little.
+*/
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T> >;
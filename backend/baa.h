@@ -1,6 +1,7 @@
 #pragma once
 #include "utils.h"
 #include "channel.h"
+#include "baa_engine.h"
 
 /*
 Performs a full BAA step on the given input and output alphabets, with the given initial distribution Q_i.
@@ -59,3 +60,30 @@ Computes the amount of information from the given distribution on the given tran
 */
 Float compute_rate_naive(const std::vector<CodeWord>& transmitted, const std::vector<CodeWord>& received, 
 	const std::vector<Float>& Q_i);
+
+
+/*
+The run-length representation as a channel of the BAA engine (see baa_engine.h). Its alphabets are not reduced by the
+	NOT symmetry, so the denominators are not pair averaged.
+*/
+struct RunLengthBaaChannel
+{
+	typedef CodeWord Codeword;
+	static constexpr bool HAS_DELETION_DERIVATIVES = false;
+	static constexpr bool HAS_LOG_ROWS = false;
+
+	void compute_row_range(const CodeWord& transmitted, const std::vector<CodeWord>& received, size_t begin, size_t end,
+		Float* out) const{
+		for (size_t j = begin; j < end; ++j)
+		{
+			out[j - begin] = get_transition_prob(transmitted, received[j], false);
+		}
+	}
+	bool averages_received_pairs() const{
+		return false;
+	}
+	BaaTileShape tile_shape(const std::vector<CodeWord>& transmitted, const std::vector<CodeWord>& received) const{
+		// There are no split cache rows to keep in cache, only the received codewords.
+		return choose_baa_tile_shape(0, 0, transmitted.size(), received.size());
+	}
+};
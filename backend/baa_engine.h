@@ -0,0 +1,347 @@
+#pragma once
+#include "utils.h"
+#include "perf_counters.h"
+#include "reproducible_sum.h"
+#include "tiled_baa.h"
+#include "vector_kernels.h"
+#include <cmath>
+
+
+/*
+The BAA passes, written once for every representation of the codewords (the run-length CodeWord of baa.h, the
+	BitCodeWord of bit_baa.h and the EfficientBitCodeWord of bit_baa_fast.h). The representation comes in as a channel
+	type, which provides:
+	typedef ... Codeword;
+	// Writes P(received[j] | transmitted) for every j in [begin, end) to out (the transition kernel).
+	void compute_row_range(const Codeword& transmitted, const std::vector<Codeword>& received, size_t begin, size_t end,
+		Float* out) const;
+	// Whether the received alphabet comes in adjacent (codeword, complement) pairs whose denominators are averaged (the
+	// 	NOT symmetry, when the transmitted alphabet only keeps one of every pair).
+	bool averages_received_pairs() const;
+	// The tiles of the passes over the table (see tiled_baa.h).
+	BaaTileShape tile_shape(const std::vector<Codeword>& transmitted, const std::vector<Codeword>& received) const;
+	// Whether the channel gives the derivatives of P_jk by the deletion probability relative to P_jk, through
+	// 	Float log_derivative(const Codeword& transmitted, const Codeword& received) const and
+	// 	Float second_derivative_ratio(const Codeword& transmitted, const Codeword& received) const.
+	static constexpr bool HAS_DELETION_DERIVATIVES = ...;
+	// Whether the channel gives the logs of the entries of the rows along with the entries (more cheaply than taking
+	// 	them), through
+	// 	void compute_log_row_range(const Codeword& transmitted, const std::vector<Codeword>& received, size_t begin,
+	// 		size_t end, Float* out, Float* log_out) const;
+	static constexpr bool HAS_LOG_ROWS = ...;
+So the thresholds, the handling of vanishing denominators, the pair averaging, the tiling, the vectorized reductions, the
+	order independent sums and the perf regions are the same for all of them.
+*/
+
+// The entries of P_jk below these are skipped in the alphas and in the rate.
+constexpr Float BAA_ALPHA_THRESHOLD = 1E-12;
+constexpr Float BAA_RATE_THRESHOLD = 1E-20;
+// The denominators are clamped from below before their logs are taken: cancellations in the incremental updates may
+// 	leave tiny negative denominators where the true value is (almost) 0.
+constexpr Float BAA_MIN_DENOMINATOR = 1E-300;
+// The skip and the clamp of the reference rate from the full table (baa_rate_from_full_table), which keeps the thresholds
+// 	the straightforward implementations always had, so that its results do not change.
+constexpr Float BAA_REFERENCE_RATE_THRESHOLD = 1E-30;
+constexpr Float BAA_REFERENCE_MIN_DENOMINATOR = 1E-50;
+
+
+/*
+Writes the entries [begin, end) of the row of the transmitted codeword to out and their logs to log_out, from the channel
+	when it has them (HAS_LOG_ROWS) and with the library's log otherwise.
+*/
+template <typename Channel>
+void baa_log_row_range(const Channel& channel, const typename Channel::Codeword& transmitted,
+	const std::vector<typename Channel::Codeword>& received, size_t begin, size_t end, Float* out, Float* log_out){
+	if constexpr (Channel::HAS_LOG_ROWS)
+	{
+		channel.compute_log_row_range(transmitted, received, begin, end, out, log_out);
+	}
+	else{
+		channel.compute_row_range(transmitted, received, begin, end, out);
+		for (size_t j = 0; j < end - begin; ++j)
+		{
+			log_out[j] = log(out[j]);
+		}
+	}
+}
+
+
+/*
+A single tiled pass over P_jk:
+	- If W_den is not NULL, adds Q[i] * P_ij to the sum W_den[j] for every pair (the linear denominators, not pair
+		averaged).
+	- If log_alphas is not NULL, writes sum_j P_ij * (log Q[i] + log P_ij - log_W_den[j]) to log_alphas[i] (the entries
+		with P_ij < BAA_ALPHA_THRESHOLD are skipped).
+The results do not depend on the tile shape: the sums W_den[j] do not depend on the order of their terms, and the alphas
+	are reduced lane by lane, where the entry j always goes to the lane j % VECTOR_KERNEL_LANES.
+*/
+template <typename Channel>
+void baa_tile_pass(const Channel& channel, const std::vector<typename Channel::Codeword>& transmitted,
+	const std::vector<typename Channel::Codeword>& received, const std::vector<Float>& Q, const Float* log_W_den,
+	ReproducibleSum* W_den, Float* log_alphas, BaaTileShape shape){
+	assert(transmitted.size() == Q.size());
+	assert(log_alphas == NULL or log_W_den != NULL);
+	assert(shape.transmitted_rows > 0 and shape.received_cols > 0);
+	size_t num_transmitted = transmitted.size();
+	size_t num_received = received.size();
+
+	std::vector<Float> P_tile_row(std::min(shape.received_cols, num_received));
+	std::vector<Float> log_P_tile_row((log_alphas != NULL) ? P_tile_row.size() : 0);
+	std::vector<Float> lanes(shape.transmitted_rows * VECTOR_KERNEL_LANES);
+	std::vector<Float> log_Q(shape.transmitted_rows);
+	for (size_t row_begin = 0; row_begin < num_transmitted; row_begin += shape.transmitted_rows)
+	{
+		size_t row_end = std::min(num_transmitted, row_begin + shape.transmitted_rows);
+		std::fill(lanes.begin(), lanes.end(), 0.0);
+		for (size_t i = row_begin; i < row_end; ++i)
+		{
+			log_Q[i - row_begin] = log(Q[i]);
+		}
+		for (size_t col_begin = 0; col_begin < num_received; col_begin += shape.received_cols)
+		{
+			size_t col_end = std::min(num_received, col_begin + shape.received_cols);
+			size_t num_cols = col_end - col_begin;
+			for (size_t i = row_begin; i < row_end; ++i)
+			{
+				if (log_alphas != NULL)
+				{
+					baa_log_row_range(channel, transmitted[i], received, col_begin, col_end, P_tile_row.data(),
+						log_P_tile_row.data());
+				}
+				else{
+					channel.compute_row_range(transmitted[i], received, col_begin, col_end, P_tile_row.data());
+				}
+				if (W_den != NULL)
+				{
+					for (size_t j = 0; j < num_cols; ++j)
+					{
+						W_den[col_begin + j].add(Q[i] * P_tile_row[j]);
+					}
+				}
+				if (log_alphas != NULL)
+				{
+					accumulate_log_alpha_lanes_with_logs(P_tile_row.data(), log_P_tile_row.data(), log_W_den + col_begin,
+						log_Q[i - row_begin], col_begin, num_cols, BAA_ALPHA_THRESHOLD,
+						lanes.data() + (i - row_begin) * VECTOR_KERNEL_LANES);
+				}
+			}
+		}
+		if (log_alphas != NULL)
+		{
+			for (size_t i = row_begin; i < row_end; ++i)
+			{
+				log_alphas[i] = combine_lanes(lanes.data() + (i - row_begin) * VECTOR_KERNEL_LANES);
+			}
+		}
+	}
+}
+
+
+/*
+The linear denominators sum_i Q_i * P_ij of a part of the transmitted codewords, as order independent sums (so that the
+	sums of the shards of the transmitted alphabet can be merged with ReproducibleSum::add).
+*/
+template <typename Channel>
+std::vector<ReproducibleSum> baa_denominator_sums(const Channel& channel, const std::vector<typename Channel::Codeword>& transmitted,
+	const std::vector<typename Channel::Codeword>& received, const std::vector<Float>& Q){
+	ScopedPerfRegion perf_region(PERF_REGION_DENOMINATORS);
+	std::vector<ReproducibleSum> W_den(received.size());
+	baa_tile_pass(channel, transmitted, received, Q, NULL, W_den.data(), NULL, channel.tile_shape(transmitted, received));
+	return W_den;
+}
+
+
+/*
+The logs of the denominators, averaged over the complement pairs when average_received_pairs is set.
+*/
+inline std::vector<Float> baa_log_denominators(const std::vector<ReproducibleSum>& W_den, bool average_received_pairs){
+	std::vector<Float> log_W_den;
+	log_W_den.reserve(W_den.size());
+	if (not average_received_pairs)
+	{
+		for (const auto& den : W_den)
+		{
+			log_W_den.push_back(log(std::max(den.value(), BAA_MIN_DENOMINATOR)));
+		}
+		return log_W_den;
+	}
+	assert(W_den.size() % 2 == 0);
+	for (size_t j = 0; j < W_den.size(); j += 2)
+	{
+		ReproducibleSum pair = W_den[j];
+		pair.add(W_den[j + 1]);
+		Float entry = log(std::max(pair.value() / 2, BAA_MIN_DENOMINATOR));
+		log_W_den.push_back(entry);
+		log_W_den.push_back(entry);
+	}
+	return log_W_den;
+}
+
+
+/*
+The log alphas of the transmitted codewords (which determine their probabilities in the next BAA step).
+*/
+template <typename Channel>
+std::vector<Float> baa_log_alphas(const Channel& channel, const std::vector<typename Channel::Codeword>& transmitted,
+	const std::vector<typename Channel::Codeword>& received, const std::vector<Float>& Q, const std::vector<Float>& log_W_den){
+	ScopedPerfRegion perf_region(PERF_REGION_ALPHAS);
+	std::vector<Float> log_alphas(transmitted.size());
+	baa_tile_pass(channel, transmitted, received, Q, log_W_den.data(), NULL, log_alphas.data(),
+		channel.tile_shape(transmitted, received));
+	return log_alphas;
+}
+
+
+/*
+A full BAA step on the given alphabets, from the distribution Q.
+*/
+template <typename Channel>
+std::vector<Float> baa_step(const Channel& channel, const std::vector<typename Channel::Codeword>& transmitted,
+	const std::vector<typename Channel::Codeword>& received, const std::vector<Float>& Q){
+	auto log_W_den = baa_log_denominators(baa_denominator_sums(channel, transmitted, received, Q), channel.averages_received_pairs());
+	auto log_alphas = baa_log_alphas(channel, transmitted, received, Q, log_W_den);
+	// Align the alphas so that they are not all small and none of them are too huge for more accurate numerics, and
+	// 	normalize them by their sum.
+	exp_normalize(log_alphas.data(), log_alphas.size());
+	return log_alphas;
+}
+
+
+/*
+The rate of a part of the transmitted codewords, as an order independent sum of the contributions of the codewords (the
+	contribution of a codeword is summed in the order of the received alphabet, which is the same in every shard).
+If derivatives is not NULL (which takes a channel with HAS_DELETION_DERIVATIVES), the first and second derivatives of
+	the rate by the deletion probability at the fixed Q are added to derivatives[0] and derivatives[1] (see
+	compute_bit_rate_derivative_sums). The rate is summed in the same order either way.
+*/
+template <typename Channel>
+ReproducibleSum baa_rate_sum(const Channel& channel, const std::vector<typename Channel::Codeword>& transmitted,
+	const std::vector<typename Channel::Codeword>& received, const std::vector<Float>& log_W_den, const std::vector<Float>& Q,
+	ReproducibleSum* derivatives = NULL){
+	ScopedPerfRegion perf_region(PERF_REGION_RATE);
+	assert(transmitted.size() == Q.size());
+	assert(derivatives == NULL or Channel::HAS_DELETION_DERIVATIVES);
+	ReproducibleSum rate;
+	std::vector<Float> row(received.size());
+	std::vector<Float> log_row(received.size());
+	for (size_t i = 0; i < transmitted.size(); ++i)
+	{
+		baa_log_row_range(channel, transmitted[i], received, 0, received.size(), row.data(), log_row.data());
+		Float row_rate = 0.0;
+		Float row_derivative = 0.0;
+		Float row_second_derivative = 0.0;
+		for (size_t j = 0; j < received.size(); ++j)
+		{
+			Float P_jk = row[j];
+			if (P_jk < BAA_RATE_THRESHOLD)
+			{
+				continue;
+			}
+			Float term = Q[i] * P_jk * (log_row[j] - log_W_den[j]);
+			row_rate += term;
+			if constexpr (Channel::HAS_DELETION_DERIVATIVES)
+			{
+				if (derivatives != NULL)
+				{
+					row_derivative += channel.log_derivative(transmitted[i], received[j]) * term;
+					row_second_derivative += channel.second_derivative_ratio(transmitted[i], received[j]) * term;
+				}
+			}
+		}
+		rate.add(row_rate);
+		if (derivatives != NULL)
+		{
+			derivatives[0].add(row_derivative);
+			derivatives[1].add(row_second_derivative);
+		}
+	}
+	return rate;
+}
+
+
+/*
+The full table of the transition probabilities, and the denominators summed directly from the table (not pair averaged).
+The step and the rate from the full table below are straightforward implementations on it, which are useful only for
+	debugging purposes.
+*/
+template <typename Channel>
+void baa_full_table(const Channel& channel, const std::vector<typename Channel::Codeword>& transmitted,
+	const std::vector<typename Channel::Codeword>& received, const std::vector<Float>& Q,
+	std::vector<std::vector<Float> >& prob_table, std::vector<Float>& denominator){
+	size_t n_I = transmitted.size();
+	size_t n_J = received.size();
+	prob_table.assign(n_I, std::vector<Float>(n_J));
+	for (size_t i = 0; i < n_I; ++i)
+	{
+		channel.compute_row_range(transmitted[i], received, 0, n_J, prob_table[i].data());
+	}
+
+	denominator.assign(n_J, 0.0);
+	for (size_t j = 0; j < n_J; ++j)
+	{
+		for (size_t i = 0; i < n_I; ++i)
+		{
+			denominator[j] += prob_table[i][j] * Q[i];
+		}
+		if (std::isnan(denominator[j]) or denominator[j] < BAA_REFERENCE_MIN_DENOMINATOR)
+		{
+			denominator[j] = BAA_REFERENCE_MIN_DENOMINATOR;
+		}
+	}
+}
+
+
+/*
+A BAA step from the full table.
+*/
+template <typename Channel>
+std::vector<Float> baa_step_from_full_table(const Channel& channel, const std::vector<typename Channel::Codeword>& transmitted,
+	const std::vector<typename Channel::Codeword>& received, const std::vector<Float>& Q){
+	std::vector<std::vector<Float> > prob_table;
+	std::vector<Float> denominator;
+	baa_full_table(channel, transmitted, received, Q, prob_table, denominator);
+
+	// alpha_k = exp(sum_j P_jk * log(Q_k * P_jk / sum_i Q_i * P_ji)), and the next distribution is alpha / sum(alpha).
+	std::vector<Float> log_alphas(transmitted.size(), 0.0);
+	for (size_t k = 0; k < transmitted.size(); ++k)
+	{
+		for (size_t j = 0; j < received.size(); ++j)
+		{
+			if (prob_table[k][j] < BAA_REFERENCE_RATE_THRESHOLD)
+			{
+				continue;
+			}
+			log_alphas[k] += prob_table[k][j] * log(Q[k] * prob_table[k][j] / denominator[j]);
+		}
+	}
+	exp_normalize(log_alphas.data(), log_alphas.size());
+	return log_alphas;
+}
+
+
+/*
+The rate from the full table.
+*/
+template <typename Channel>
+Float baa_rate_from_full_table(const Channel& channel, const std::vector<typename Channel::Codeword>& transmitted,
+	const std::vector<typename Channel::Codeword>& received, const std::vector<Float>& Q){
+	size_t n_I = transmitted.size();
+	size_t n_J = received.size();
+	std::vector<std::vector<Float> > prob_table;
+	std::vector<Float> denominator;
+	baa_full_table(channel, transmitted, received, Q, prob_table, denominator);
+
+	Float rate = 0.0;
+	for (size_t k = 0; k < n_I; ++k)
+	{
+		for (size_t j = 0; j < n_J; ++j)
+		{
+			if (prob_table[k][j] < BAA_REFERENCE_RATE_THRESHOLD)
+			{
+				continue;
+			}
+			rate += Q[k] * prob_table[k][j] * log(prob_table[k][j] / denominator[j]);
+		}
+	}
+	return rate;
+}
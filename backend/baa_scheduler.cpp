@@ -0,0 +1,66 @@
+#include "batch_scheduler.h"
+#include <cstring>
+#include <string>
+
+
+/*
+Runs the BAA on every configuration of a manifest (see load_batch_manifest) in a single process, and appends a line to
+	the results file as every configuration converges:
+	index in_len out_len deletion_probability up_to rate distance iterations warm_started seconds inputs derivative
+	second_derivative
+The derivatives are those of the rate by the deletion probability (see compute_bit_rate_derivative_sums), in bits.
+If a Q folder is given, the final distribution of every configuration is saved there as Q_<index>.arr.
+Setting BDC_MERGE_EQUIVALENT=0 runs the BAA on the whole channel instead of its quotient (see channel_quotient.h).
+*/
+int main(int argc, char const *argv[])
+{
+	if (argc < 3 or argc > 7)
+	{
+		fprintf(stderr, "Usage: %s manifest_file results_file [num_threads] [accuracy] [max_iterations] [Q_folder]\n", argv[0]);
+		exit(1);
+	}
+	const char* manifest_filename = argv[1];
+	const char* results_filename = argv[2];
+	BatchOptions options;
+	if (argc > 3)
+	{
+		options.num_threads = atol(argv[3]);
+	}
+	if (argc > 4)
+	{
+		options.accuracy = atof(argv[4]);
+	}
+	if (argc > 5)
+	{
+		options.max_iterations = atol(argv[5]);
+	}
+	const char* Q_folder = (argc > 6) ? argv[6] : NULL;
+	const char* merge_env = getenv("BDC_MERGE_EQUIVALENT");
+	options.merge_equivalent_codewords = (merge_env == NULL or strcmp(merge_env, "0"));
+
+	auto jobs = load_batch_manifest(manifest_filename);
+	FILE* results_file = try_to_open_file(results_filename, "w");
+	fprintf(results_file, "# index in_len out_len deletion_probability up_to rate distance iterations warm_started seconds inputs derivative second_derivative\n");
+	fflush(results_file);
+	size_t num_done = 0;
+	run_batch(jobs, options, [&](const BatchResult& result){
+		const BatchJob& job = result.job;
+		fprintf(results_file, "%lu %lu %lu %.17g %d %.17g %.17g %lu %d %.3f %lu %.17g %.17g\n", job.index, job.in_len, job.out_len,
+			job.deletion_prob, (int) job.up_to, result.rate, result.distance, result.num_iterations,
+			(int) result.warm_started, result.seconds, result.num_inputs, result.rate_derivative, result.rate_second_derivative);
+		fflush(results_file);
+		if (Q_folder != NULL)
+		{
+			std::string Q_filename = std::string(Q_folder) + "/Q_" + std::to_string(job.index) + ".arr";
+			FILE* Q_file = try_to_open_file(Q_filename.data(), "wb");
+			write_1d_array_to_file(Q_file, result.Q);
+			fclose(Q_file);
+		}
+		++num_done;
+		printf("[%lu/%lu] (%lu, %lu, %g, %d): rate %.6f after %lu iterations (%.1f s)\n", num_done, jobs.size(),
+			job.in_len, job.out_len, job.deletion_prob, (int) job.up_to, result.rate, result.num_iterations, result.seconds);
+		fflush(stdout);
+	});
+	fclose(results_file);
+	return 0;
+}
@@ -0,0 +1,231 @@
+#include "batch_scheduler.h"
+#include "bit_baa_fast.h"
+#include "channel_quotient.h"
+#include "numa_placement.h"
+#include "resource_planner.h"
+#include "transition_kernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unistd.h>
+
+
+std::vector<BatchJob> load_batch_manifest(const char* manifest_filename){
+	FILE* manifest_file = try_to_open_file(manifest_filename, "r");
+	std::vector<BatchJob> jobs;
+	char line[256];
+	size_t line_number = 0;
+	while (fgets(line, sizeof(line), manifest_file) != NULL)
+	{
+		++line_number;
+		const char* start = line;
+		while (*start == ' ' or *start == '\t')
+		{
+			++start;
+		}
+		if (*start == '#' or *start == '\n' or *start == '\r' or *start == '\0')
+		{
+			continue;
+		}
+		BatchJob job;
+		int up_to;
+		if (sscanf(start, "%lu %lu %lf %d", &job.in_len, &job.out_len, &job.deletion_prob, &up_to) != 4)
+		{
+			fprintf(stderr, "Failed to parse line %lu of the manifest %s: %s", line_number, manifest_filename, line);
+			exit(1);
+		}
+		job.up_to = up_to;
+		job.index = jobs.size();
+		jobs.push_back(job);
+	}
+	fclose(manifest_file);
+	return jobs;
+}
+
+
+Float predict_batch_job_cost(const BatchJob& job){
+	return plan_baa_resources(job.in_len, job.out_len, job.up_to, 1).estimated_core_seconds_per_iteration;
+}
+
+
+typedef std::tuple<size_t, size_t, bool> BatchGroupKey;
+
+static BatchGroupKey get_group_key(const BatchJob& job){
+	return BatchGroupKey(job.in_len, job.out_len, job.up_to);
+}
+
+static std::map<BatchGroupKey, std::vector<BatchJob> > group_batch_jobs(const std::vector<BatchJob>& jobs){
+	std::map<BatchGroupKey, std::vector<BatchJob> > groups;
+	for (const auto& job : jobs)
+	{
+		groups[get_group_key(job)].push_back(job);
+	}
+	for (auto& group : groups)
+	{
+		std::sort(group.second.begin(), group.second.end(), [](const BatchJob& job1, const BatchJob& job2){
+			return std::make_pair(job1.deletion_prob, job1.index) < std::make_pair(job2.deletion_prob, job2.index);
+		});
+	}
+	return groups;
+}
+
+
+std::vector<BatchChain> plan_batch(const std::vector<BatchJob>& jobs, size_t num_threads,
+	const std::function<Float(const BatchJob&)>& job_cost){
+	assert(num_threads > 0);
+	auto groups = group_batch_jobs(jobs);
+
+	// The cost of a job only depends on its group.
+	std::map<BatchGroupKey, Float> cold_costs;
+	Float total_cost = 0;
+	Float max_job_cost = 0;
+	for (const auto& group : groups)
+	{
+		Float cold_cost = job_cost(group.second.front());
+		cold_costs[group.first] = cold_cost;
+		total_cost += cold_cost * (1 + WARM_START_COST_FRACTION * (group.second.size() - 1));
+		max_job_cost = std::max(max_job_cost, cold_cost);
+	}
+	// Cutting a chain makes its second part start cold, so the chains are only cut where they would otherwise be the
+	// 	bottleneck of the grid.
+	Float max_chain_cost = std::max(total_cost / num_threads, max_job_cost);
+
+	std::vector<BatchChain> chains;
+	for (const auto& group : groups)
+	{
+		Float cold_cost = cold_costs[group.first];
+		BatchChain chain;
+		chain.predicted_cost = 0;
+		for (const auto& job : group.second)
+		{
+			if (not chain.jobs.empty() and chain.predicted_cost + cold_cost * WARM_START_COST_FRACTION > max_chain_cost)
+			{
+				chains.push_back(std::move(chain));
+				chain = BatchChain();
+				chain.predicted_cost = 0;
+			}
+			chain.predicted_cost += chain.jobs.empty() ? cold_cost : cold_cost * WARM_START_COST_FRACTION;
+			chain.jobs.push_back(job);
+		}
+		chains.push_back(std::move(chain));
+	}
+	std::stable_sort(chains.begin(), chains.end(), [](const BatchChain& chain1, const BatchChain& chain2){
+		return chain1.predicted_cost > chain2.predicted_cost;
+	});
+	return chains;
+}
+
+
+/*
+The alphabets of a group, as produced by the gen_codewords command of the slave.
+*/
+struct BatchAlphabets
+{
+	std::vector<EfficientBitCodeWord> transmitted;
+	std::vector<EfficientBitCodeWord> received;
+	// Only when merging equivalent codewords.
+	std::unique_ptr<ChannelQuotient> quotient;
+};
+
+/*
+Runs the BAA on a single job, from Q (which is updated to the final distribution). On the quotient channel Q is a
+	distribution on the classes.
+*/
+static BatchResult run_batch_job(const BatchJob& job, const BatchAlphabets& alphabets, std::vector<Float>& Q,
+	const BatchOptions& options){
+	auto t0 = std::chrono::steady_clock::now();
+	ChannelContext channel(job.deletion_prob, job.in_len, job.out_len, job.up_to);
+	BatchResult result;
+	result.job = job;
+	result.distance = INFINITY;
+	result.num_iterations = 0;
+	while (result.distance >= options.accuracy and result.num_iterations < options.max_iterations)
+	{
+		auto next_Q = (alphabets.quotient != NULL) ?
+			do_quotient_baa_step(channel, *alphabets.quotient, alphabets.received, Q) :
+			do_full_baa_step(channel, alphabets.transmitted, alphabets.received, Q);
+		result.distance = -INFINITY;
+		for (size_t i = 0; i < Q.size(); ++i)
+		{
+			Float ratio = log2(next_Q[i] / Q[i]);
+			if (not std::isnan(ratio))
+			{
+				result.distance = std::max(result.distance, ratio);
+			}
+		}
+		Q = std::move(next_Q);
+		++result.num_iterations;
+	}
+	std::vector<ReproducibleSum> rate_sums;
+	if (alphabets.quotient != NULL)
+	{
+		// The rate is linear in the probabilities of codewords with identical rows.
+		const ChannelQuotient& quotient = *alphabets.quotient;
+		auto log_dens = compute_quotient_log_Wjk_den(channel, quotient, alphabets.received, Q);
+		rate_sums = compute_bit_rate_derivative_sums(channel, quotient.transmitted_representatives, alphabets.received, log_dens, Q);
+		result.Q = expand_transmitted_distribution(quotient, Q);
+	}
+	else{
+		auto log_dens = compute_all_log_Wjk_den(channel, alphabets.transmitted, alphabets.received, Q);
+		rate_sums = compute_bit_rate_derivative_sums(channel, alphabets.transmitted, alphabets.received, log_dens, Q);
+		result.Q = Q;
+	}
+	result.rate = rate_sums[0].value() / log(2.0);
+	result.rate_derivative = rate_sums[1].value() / log(2.0);
+	result.rate_second_derivative = rate_sums[2].value() / log(2.0);
+	result.num_inputs = Q.size();
+	result.seconds = std::chrono::duration<Float>(std::chrono::steady_clock::now() - t0).count();
+	return result;
+}
+
+
+void run_batch(const std::vector<BatchJob>& jobs, const BatchOptions& options,
+	const std::function<void(const BatchResult&)>& on_result){
+	size_t num_threads = options.num_threads;
+	if (num_threads == 0)
+	{
+		num_threads = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+	}
+	auto chains = plan_batch(jobs, num_threads);
+
+	// Everything that is shared by the jobs of a group is set up once, before the workers start: the alphabets (and
+	// 	their quotient), the cache tables (which the channel contexts of all of the jobs share) and the choice of the
+	// 	transition kernels (which is process wide and must not change under a running job).
+	std::map<BatchGroupKey, BatchAlphabets> alphabets;
+	for (const auto& group : group_batch_jobs(jobs))
+	{
+		const BatchJob& job = group.second.front();
+		BatchAlphabets& group_alphabets = alphabets[group.first];
+		group_alphabets.transmitted = get_transmitted_codewords_symmetries(get_sorted_bit_codewords(job.in_len, false));
+		group_alphabets.received = get_sorted_bit_codewords(job.out_len, job.up_to);
+		ChannelContext channel(job.deletion_prob, job.in_len, job.out_len, job.up_to);
+		autotune_transition_kernels(job.in_len, job.out_len, job.up_to);
+		if (options.merge_equivalent_codewords)
+		{
+			group_alphabets.quotient.reset(new ChannelQuotient(compute_channel_quotient(group_alphabets.transmitted,
+				group_alphabets.received, job.in_len, job.out_len, job.up_to)));
+		}
+	}
+
+	std::mutex result_mutex;
+	run_parallel_tasks(num_threads, chains.size(), [&](size_t c){
+		const auto& chain = chains[c];
+		const BatchAlphabets& chain_alphabets = alphabets.at(get_group_key(chain.jobs.front()));
+		std::vector<Float> Q(chain_alphabets.transmitted.size(), 1.0 / chain_alphabets.transmitted.size());
+		if (chain_alphabets.quotient != NULL)
+		{
+			Q = merge_transmitted_distribution(*chain_alphabets.quotient, Q);
+		}
+		for (size_t j = 0; j < chain.jobs.size(); ++j)
+		{
+			BatchResult result = run_batch_job(chain.jobs[j], chain_alphabets, Q, options);
+			result.warm_started = (j > 0);
+			std::lock_guard<std::mutex> lock(result_mutex);
+			on_result(result);
+		}
+	});
+}
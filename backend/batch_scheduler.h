@@ -0,0 +1,104 @@
+#pragma once
+#include "utils.h"
+#include <functional>
+
+
+/*
+Runs the BAA to convergence on a whole grid of channel configurations in a single process.
+The jobs of a grid share a lot: every configuration with the same (in_len, out_len, up_to) has the same alphabets and
+	transition count tables, and the converged distribution of a deletion probability is a good starting point for
+	the next one. The scheduler groups the jobs accordingly, orders every group by the deletion probability so that
+	every job warm starts from its neighbour, and cuts the groups into chains that are short enough to pack the whole
+	grid onto the cores by their predicted cost (see plan_batch).
+*/
+
+
+/*
+A single configuration of the grid, as in the ChannelDetails of the python driver.
+*/
+struct BatchJob
+{
+	size_t in_len;
+	size_t out_len;
+	Float deletion_prob;
+	bool up_to;
+	// The index of the job in the manifest, which identifies its result.
+	size_t index;
+};
+
+/*
+Reads a manifest with a job per line: "in_len out_len deletion_probability up_to". Empty lines and lines starting
+	with # are skipped.
+*/
+std::vector<BatchJob> load_batch_manifest(const char* manifest_filename);
+
+
+/*
+A sequence of jobs of the same group that runs on a single core, every job starting from the distribution the previous
+	one converged to.
+*/
+struct BatchChain
+{
+	std::vector<BatchJob> jobs;
+	// The predicted single core runtime of the whole chain (in arbitrary units, only used to compare chains).
+	Float predicted_cost;
+};
+
+/*
+A warm started job is predicted to take this fraction of the iterations of a job that starts from the uniform
+	distribution (rough, it only affects how the chains are packed).
+*/
+constexpr Float WARM_START_COST_FRACTION = 0.5;
+
+/*
+Returns the predicted single core cost of an iteration of the job (from the resource planner).
+*/
+Float predict_batch_job_cost(const BatchJob& job);
+
+/*
+Groups the jobs by (in_len, out_len, up_to), sorts every group by the deletion probability and cuts the groups into
+	chains, so that no chain is predicted to take longer than an even share of the whole grid on num_threads cores
+	(or the longest job, if that is longer). The chains are returned in decreasing predicted cost, which is the order in
+	which they should be started (longest processing time first).
+job_cost is the predicted cost of a single cold job.
+*/
+std::vector<BatchChain> plan_batch(const std::vector<BatchJob>& jobs, size_t num_threads,
+	const std::function<Float(const BatchJob&)>& job_cost = predict_batch_job_cost);
+
+
+struct BatchOptions
+{
+	// 0 means all of the online cores.
+	size_t num_threads = 0;
+	// The BAA stops once no probability grows by more than a factor of 2^accuracy in an iteration (as in the python driver).
+	Float accuracy = 0.05;
+	size_t max_iterations = 100000;
+	// Run the BAA on the quotient channel, where the transmitted codewords with identical rows and the received ones with
+	// 	proportional columns are merged (see channel_quotient.h). The classes are found once per group.
+	bool merge_equivalent_codewords = true;
+};
+
+struct BatchResult
+{
+	BatchJob job;
+	// The final distribution, its rate (in bits) and the distance of the last iteration.
+	std::vector<Float> Q;
+	Float rate;
+	// The derivatives of the rate of Q by the deletion probability, at the fixed Q (in bits, see
+	// 	compute_bit_rate_derivative_sums).
+	Float rate_derivative;
+	Float rate_second_derivative;
+	Float distance;
+	size_t num_iterations;
+	bool warm_started;
+	Float seconds;
+	// The size of the transmitted alphabet the BAA ran on (the number of classes on the quotient channel).
+	size_t num_inputs;
+};
+
+/*
+Runs all of the jobs and calls on_result (from the worker threads, but never from two threads at once) as every job
+	finishes, so that the results can be streamed out.
+*/
+void run_batch(const std::vector<BatchJob>& jobs, const BatchOptions& options,
+	const std::function<void(const BatchResult&)>& on_result);
@@ -1,6 +1,7 @@
 #pragma once
 #include "utils.h"
 #include "bit_channel.h"
+#include "baa_engine.h"
 
 
 /*
@@ -49,4 +50,31 @@ std::vector<Float> compute_Pjk_col(const std::vector<BitCodeWord>& transmitted,
 
 Float compute_log_Wjk_den (const std::vector<BitCodeWord>& transmitted, const BitCodeWord& received, const std::vector<Float>& Q_i);
 Float compute_log_alpha_k (const BitCodeWord& transmitted, const std::vector<BitCodeWord>& received, 
-	Float Q_k, const std::vector<Float>& log_W_jk_den);
\ No newline at end of file
+	Float Q_k, const std::vector<Float>& log_W_jk_den);
+
+
+/*
+The BitCodeWord representation as a channel of the BAA engine (see baa_engine.h). Its alphabets are not reduced by the
+	NOT symmetry, so the denominators are not pair averaged.
+*/
+struct BitBaaChannel
+{
+	typedef BitCodeWord Codeword;
+	static constexpr bool HAS_DELETION_DERIVATIVES = false;
+	static constexpr bool HAS_LOG_ROWS = false;
+
+	void compute_row_range(const BitCodeWord& transmitted, const std::vector<BitCodeWord>& received, size_t begin, size_t end,
+		Float* out) const{
+		for (size_t j = begin; j < end; ++j)
+		{
+			out[j - begin] = get_bit_transition_prob(transmitted, received[j], false, true);
+		}
+	}
+	bool averages_received_pairs() const{
+		return false;
+	}
+	BaaTileShape tile_shape(const std::vector<BitCodeWord>& transmitted, const std::vector<BitCodeWord>& received) const{
+		// There are no split cache rows to keep in cache, only the received codewords.
+		return choose_baa_tile_shape(0, 0, transmitted.size(), received.size());
+	}
+};
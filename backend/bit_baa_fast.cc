@@ -1,177 +1,298 @@
 #include "bit_baa_fast.h"
+#include "perf_counters.h"
+#include "transition_kernels.h"
+#include "vector_kernels.h"
+#include "sparse_transition_kernels.h"
+#include "codeword_buckets.h"
+#include "tiled_baa.h"
+#include "log_count_table.h"
 #include <algorithm>
 #include <cmath>
 
 
-struct Sum
-{
-    void operator()(Float n) { sum += n; }
-    Float sum{0};
-};
+static size_t max_codeword_len(const std::vector<EfficientBitCodeWord>& codewords){
+	size_t max_len = 0;
+	for (const auto& word : codewords)
+	{
+		max_len = std::max(max_len, word.len);
+	}
+	return max_len;
+}
+
+BaaTileShape EfficientBitBaaChannel::tile_shape(const std::vector<EfficientBitCodeWord>& transmitted,
+	const std::vector<EfficientBitCodeWord>& received) const{
+	return choose_baa_tile_shape(max_codeword_len(transmitted), max_codeword_len(received), transmitted.size(), received.size());
+}
 
-std::vector<Float> do_full_baa_step(const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
+std::vector<Float> do_full_baa_step(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
 	const std::vector<Float>& Q_i){
-	std::vector<Float> log_W_jk = compute_all_log_Wjk_den (transmitted, received, Q_i);
-	std::vector<Float> log_alphas = compute_all_log_alpha_k (transmitted, received, Q_i, log_W_jk);
+	CodewordBucketIndex received_index(received);
+	return baa_step(EfficientBitBaaChannel{channel, &received_index}, transmitted, received, Q_i);
+}
 
-	// Align alphas so that they are not all small and none of them are too huge for more accurate numerics:
-	Float max_log_alpha = *std::max_element(log_alphas.begin(), log_alphas.end());
-	std::for_each(log_alphas.begin(), log_alphas.end(), [max_log_alpha](Float &log_alpha){ log_alpha = exp(log_alpha - max_log_alpha);});
-	std::vector<Float> alphas = std::move(log_alphas);
+std::vector<Float> compute_all_log_Wjk_den (const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
+	const std::vector<Float>& Q_i){
+	return log_Wjk_den_from_sums(compute_all_Wjk_den_sums(channel, transmitted, received, Q_i));
+}
 
-	// Normalize the alphas by their sum:
-	Float alpha_sum = std::accumulate(alphas.begin(), alphas.end(), 0.0);
-	std::for_each(alphas.begin(), alphas.end(), [alpha_sum](Float &alpha){ alpha /= alpha_sum;});
+std::vector<ReproducibleSum> compute_all_Wjk_den_sums (const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, 
+	const std::vector<EfficientBitCodeWord>& received, const std::vector<Float>& Q_i){
+	// A tiled pass over the rows of P_jk, rather than a column per received codeword, keeps the received codewords and
+	// 	the table rows in cache.
+	CodewordBucketIndex received_index(received);
+	return baa_denominator_sums(EfficientBitBaaChannel{channel, &received_index}, transmitted, received, Q_i);
+}
 
-	return alphas;
+std::vector<Float> log_Wjk_den_from_sums (const std::vector<ReproducibleSum>& W_jk_den){
+	return baa_log_denominators(W_jk_den, true);
 }
 
-std::vector<Float> compute_all_log_Wjk_den (const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
-	const std::vector<Float>& Q_i){
-	// Iteratively call compute_Wjk_den for each possible received codeword.
-	std::vector<Float> log_Wjk_den;
-	log_Wjk_den.reserve(received.size());
-	for(auto rec_iter = received.begin(); rec_iter != received.end(); rec_iter += 2){
-		auto den1 = compute_Wjk_den(transmitted, *rec_iter, Q_i);
-		auto den2 = compute_Wjk_den(transmitted, *(rec_iter + 1), Q_i);
-		Float entry = log((den1 + den2) / 2);
-		log_Wjk_den.push_back(entry);
-		log_Wjk_den.push_back(entry);
+size_t update_Wjk_den_incremental (const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
+	const std::vector<Float>& Q_new, std::vector<Float>& Q_applied, std::vector<ReproducibleSum>& W_jk_den, Float tolerance){
+	ScopedPerfRegion perf_region(PERF_REGION_DENOMINATORS);
+	assert(transmitted.size() == Q_new.size() and Q_new.size() == Q_applied.size());
+	assert(received.size() == W_jk_den.size());
+	size_t num_updated = 0;
+	CodewordBucketIndex received_index(received);
+	for (size_t i = 0; i < transmitted.size(); ++i)
+	{
+		Float delta = Q_new[i] - Q_applied[i];
+		if (std::abs(delta) <= tolerance * Q_applied[i] or delta == 0.0)
+		{
+			continue;
+		}
+		// A sparse update of the denominators with a single row of P_jk:
+		std::vector<Float> probs_row = compute_Pjk_row(channel, transmitted[i], received, &received_index);
+		for (size_t j = 0; j < received.size(); ++j)
+		{
+			W_jk_den[j].add(delta * probs_row[j]);
+		}
+		Q_applied[i] = Q_new[i];
+		++num_updated;
 	}
-	return log_Wjk_den;
+	return num_updated;
 }
 
-std::vector<Float> compute_all_log_alpha_k (const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
+std::vector<Float> compute_all_log_alpha_k (const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
 	const std::vector<Float>& Q_i, const std::vector<Float>& log_W_jk_den){
-	// Iteratively call compute_log_alpha_k for each possible transmitted codeword.
-	std::vector<Float> log_alphas;
-	log_alphas.reserve(transmitted.size());
-	auto Q_iter = Q_i.begin();
-	for(auto trans_iter = transmitted.begin(); trans_iter != transmitted.end(); ++trans_iter){
-		log_alphas.push_back(compute_log_alpha_k(*trans_iter, received, *(Q_iter++), log_W_jk_den));
-	}
-	return log_alphas;
+	// The same as calling compute_log_alpha_k for every transmitted codeword, a tile at a time.
+	CodewordBucketIndex received_index(received);
+	return baa_log_alphas(EfficientBitBaaChannel{channel, &received_index}, transmitted, received, Q_i, log_W_jk_den);
 }
 
 
-Float compute_Wjk_den (const std::vector<EfficientBitCodeWord>& transmitted, const EfficientBitCodeWord& received, const std::vector<Float>& Q_i){
-	std::vector<Float> probs_col = compute_Pjk_col(transmitted, received);
-	Float denominator = std::inner_product(probs_col.begin(), probs_col.end(), Q_i.begin(), 0.0);
+Float compute_Wjk_den (const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const EfficientBitCodeWord& received, const std::vector<Float>& Q_i,
+	const CodewordBucketIndex* transmitted_index){
+	std::vector<Float> probs_col = compute_Pjk_col(channel, transmitted, received, transmitted_index);
+	Float denominator = dot_product(probs_col.data(), Q_i.data(), probs_col.size());
 	return denominator;
 }
 
 
-Float compute_log_alpha_k (const EfficientBitCodeWord& transmitted, const std::vector<EfficientBitCodeWord>& received, 
-	Float Q_k, const std::vector<Float>& log_W_jk_den){
+Float compute_log_alpha_k (const ChannelContext& channel, const EfficientBitCodeWord& transmitted, const std::vector<EfficientBitCodeWord>& received, 
+	Float Q_k, const std::vector<Float>& log_W_jk_den, const CodewordBucketIndex* received_index){
+	// The same reduction as the tiled passes of compute_all_log_alpha_k, on the whole row.
 	Float log_Q_k = log(Q_k);
-	std::vector<Float> probs_row = compute_Pjk_row(transmitted, received);
-	Float log_alpha = 0.0;
-
-	for(size_t i = 0; i < probs_row.size(); ++i){
-		Float P_jk = probs_row[i];
-		Float log_den = log_W_jk_den[i];
-		if (P_jk < 1E-12)
-		{
-			continue;
-		}
-		log_alpha += P_jk * (log_Q_k + log(P_jk) - log_den);
-	}
-	return log_alpha;
+	std::vector<Float> probs_row(received.size());
+	std::vector<Float> log_probs_row(received.size());
+	compute_log_Pjk_row_range(channel, transmitted, received, 0, received.size(), received_index, probs_row.data(),
+		log_probs_row.data());
+	Float lanes[VECTOR_KERNEL_LANES] = {0.0};
+	accumulate_log_alpha_lanes_with_logs(probs_row.data(), log_probs_row.data(), log_W_jk_den.data(), log_Q_k, 0,
+		probs_row.size(), BAA_ALPHA_THRESHOLD, lanes);
+	return combine_lanes(lanes);
 }
 
 
 
-std::vector<Float> compute_Pjk_row(const EfficientBitCodeWord& transmitted, const std::vector<EfficientBitCodeWord>& received){
-	std::vector<Float> res; res.reserve(received.size());
-	for(auto rec_iter = received.begin(); rec_iter != received.end(); ++rec_iter){
-		res.push_back(get_bit_transition_prob_fast(transmitted, *rec_iter));
+// The combine of a run of received codewords is only restricted to the reachable ones when at least this fraction
+// 	(1 / MIN_PRUNED_FRACTION_INVERSE) of the run is pruned, below that copying the candidates costs more than it saves.
+constexpr size_t MIN_PRUNED_FRACTION_INVERSE = 4;
+
+/*
+Computes the transition counts from the transmitted codeword to the given received codewords (all of length k), and
+	writes them multiplied by factor to out (so a factor of 1 gives the counts themselves, and the normalization factor of
+	(transmitted.len, k) gives the transition probabilities, exactly as get_bit_transition_prob_fast computes them).
+*/
+static void compute_Pjk_run(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord* received, size_t count,
+	size_t k, Float factor, Float* out){
+	TransitionKernelKind kind = _transition_kernel_kinds[transmitted.len][k];
+	if ((kind == KERNEL_SPLIT_CACHE or kind == KERNEL_SPECIALIZED_SPLIT_CACHE) and count > 1)
+	{
+		combine_split_cache_row(transmitted, received, count, factor, out);
+		return;
 	}
-	return res;
+	count_transitions_run(transmitted, received, count, factor, out);
 }
 
-std::vector<Float> compute_Pjk_col(const std::vector<EfficientBitCodeWord>& transmitted, const EfficientBitCodeWord& received){
-	std::vector<Float> res; res.reserve(transmitted.size());
-	for(auto trans_iter = transmitted.begin(); trans_iter != transmitted.end(); ++trans_iter){
-		res.push_back(get_bit_transition_prob_fast(*trans_iter, received));
-	}
+/*
+compute_Pjk_row_range, writing the counts rather than the probabilities when counts is set.
+*/
+static void compute_row_range(const ChannelContext& channel, const EfficientBitCodeWord& transmitted, const std::vector<EfficientBitCodeWord>& received,
+	size_t begin, size_t end, const CodewordBucketIndex* received_index, bool counts, Float* out);
+
+std::vector<Float> compute_Pjk_row(const ChannelContext& channel, const EfficientBitCodeWord& transmitted, const std::vector<EfficientBitCodeWord>& received,
+	const CodewordBucketIndex* received_index){
+	std::vector<Float> res; res.resize(received.size());
+	compute_Pjk_row_range(channel, transmitted, received, 0, received.size(), received_index, res.data());
 	return res;
 }
 
+void compute_Pjk_row_range(const ChannelContext& channel, const EfficientBitCodeWord& transmitted, const std::vector<EfficientBitCodeWord>& received,
+	size_t begin, size_t end, const CodewordBucketIndex* received_index, Float* out){
+	compute_row_range(channel, transmitted, received, begin, end, received_index, false, out);
+}
 
-Float compute_bit_rate_efficient(const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
-	const std::vector<Float>& log_W_jk_den, const std::vector<Float>& Q_i){
-	size_t n_I = transmitted.size();
-	size_t n_J = received.size();
-	assert(transmitted.size() == Q_i.size());
-	Float rate = 0.0;
-
-	for(size_t i = 0; i < n_I; ++i){
-		auto probs_row = compute_Pjk_row(transmitted[i], received);
-		// std::vector<Float> log_probs_row = probs_row;
-		// for_each(log_probs_row.begin(), log_probs_row.end(), [](Float& x){x = log(x);});
-		Float Qk = Q_i[i];
-		for(size_t j = 0; j < n_J; ++j){
-			Float log_den = log_W_jk_den[j];
-			Float P_jk = probs_row[j];
-			Float log_P_jk = log(P_jk);
-			if (P_jk < 1E-20)
-			{
-				continue;
-			}
-			// printf("%lu\t%lu\t%.2f%%\t%.2f%%\t%.2f\t%.2f\n", i, j, 100*Qk, 100*P_jk, log_P_jk, log_den);
-			rate += Qk * P_jk * (log_P_jk - log_den);
-		}
+void compute_log_Pjk_row_range(const ChannelContext& channel, const EfficientBitCodeWord& transmitted, const std::vector<EfficientBitCodeWord>& received,
+	size_t begin, size_t end, const CodewordBucketIndex* received_index, Float* out, Float* log_out){
+	compute_row_range(channel, transmitted, received, begin, end, received_index, true, out);
+	for (size_t start = begin, run_end = begin; start < end; start = run_end)
+	{
+		size_t k = received[start].len;
+		for (run_end = start + 1; run_end < end and received[run_end].len == k; ++run_end);
+		counts_to_log_probs(channel.normalization_factor(transmitted.len, k), channel.log_normalization_factor(transmitted.len, k),
+			out + (start - begin), log_out + (start - begin), run_end - start);
 	}
-	return rate;
 }
 
-
-Float compute_rate(const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
-	const std::vector<Float>& Q_i){
-	std::vector<std::vector<Float> > prob_table;
-
-	size_t n_I = transmitted.size();	prob_table.resize(n_I);
-	size_t n_J = received.size();		for_each(prob_table.begin(), prob_table.end(), [n_J](std::vector<Float>& row){
-											row.resize(n_J);
-	});
-
-	for (size_t i = 0; i < n_I; ++i)
+static void compute_row_range(const ChannelContext& channel, const EfficientBitCodeWord& transmitted, const std::vector<EfficientBitCodeWord>& received,
+	size_t begin, size_t end, const CodewordBucketIndex* received_index, bool counts, Float* out){
+	std::fill(out, out + (end - begin), 0.0);
+	Float* res = out - begin;
+	std::vector<SparseTransitionCount> nonzeros;
+	std::vector<size_t> candidates;
+	std::vector<EfficientBitCodeWord> candidate_words;
+	std::vector<Float> candidate_probs;
+	// The received codewords are sorted by length, so the row is made of runs of codewords of the same length.
+	for (size_t start = begin, run_end = begin; start < end; start = run_end)
 	{
-		for (size_t j = 0; j < n_J; ++j)
+		size_t k = received[start].len;
+		for (run_end = start + 1; run_end < end and received[run_end].len == k; ++run_end);
+		size_t run_size = run_end - start;
+		Float factor = counts ? 1.0 : channel.normalization_factor(transmitted.len, k);
+		if (prefer_sparse_row(transmitted.len, k, run_size))
 		{
-			prob_table[i][j] = get_bit_transition_prob_fast(transmitted[i], received[j]);
+			// Most of the run cannot be reached from the transmitted codeword, only visit its subsequences.
+			nonzeros.clear();
+			enumerate_subsequence_counts(transmitted, k, received.data() + start, run_size, nonzeros);
+			for (const auto& entry : nonzeros)
+			{
+				res[start + entry.index] = factor * entry.count;
+			}
+			continue;
 		}
-	}
-
-	std::vector<Float> denominator; denominator.resize(n_J);
-	for (size_t j = 0; j < n_J; ++j)
-	{
-		denominator[j] = 0.0;
-		for (size_t i = 0; i < n_I; ++i)
+		// Only evaluate the codewords that pass the weight and run tests (the rest of the run stays 0), unless too
+		// 	little is pruned to pay for compacting the run.
+		if (received_index == NULL or received_index->count_reachable(transmitted, k) * MIN_PRUNED_FRACTION_INVERSE >
+			received_index->num_codewords(k) * (MIN_PRUNED_FRACTION_INVERSE - 1))
+		{
+			compute_Pjk_run(transmitted, received.data() + start, run_size, k, factor, res + start);
+			continue;
+		}
+		candidates.clear();
+		size_t indexed_run_size = received_index->collect_reachable(transmitted, k, candidates, start, run_end);
+		assert(indexed_run_size == run_size);
+		candidate_words.clear();
+		for (size_t j : candidates)
 		{
-			denominator[j] += prob_table[i][j] * Q_i[i];
+			candidate_words.push_back(received[j]);
+		}
+		candidate_probs.resize(candidates.size());
+		compute_Pjk_run(transmitted, candidate_words.data(), candidate_words.size(), k, factor, candidate_probs.data());
+		for (size_t c = 0; c < candidates.size(); ++c)
+		{
+			res[candidates[c]] = candidate_probs[c];
 		}
 	}
+}
 
-	Float rate = 0.0;
-	for (size_t k = 0; k < n_I; ++k)
+void compute_transition_count_row_range(const ChannelContext& channel, const EfficientBitCodeWord& transmitted,
+	const std::vector<EfficientBitCodeWord>& received, size_t begin, size_t end, const CodewordBucketIndex* received_index, Float* out){
+	compute_row_range(channel, transmitted, received, begin, end, received_index, true, out);
+}
+
+/*
+compute_Pjk_col, writing the counts rather than the probabilities when counts is set.
+*/
+static std::vector<Float> compute_col(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted,
+	const EfficientBitCodeWord& received, const CodewordBucketIndex* transmitted_index, bool counts);
+
+std::vector<Float> compute_Pjk_col(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const EfficientBitCodeWord& received,
+	const CodewordBucketIndex* transmitted_index){
+	return compute_col(channel, transmitted, received, transmitted_index, false);
+}
+
+std::vector<Float> compute_transition_count_col(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted,
+	const EfficientBitCodeWord& received, const CodewordBucketIndex* transmitted_index){
+	return compute_col(channel, transmitted, received, transmitted_index, true);
+}
+
+static std::vector<Float> compute_col(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted,
+	const EfficientBitCodeWord& received, const CodewordBucketIndex* transmitted_index, bool counts){
+	std::vector<Float> res; res.resize(transmitted.size());
+	std::vector<SparseTransitionCount> nonzeros;
+	std::vector<size_t> candidates;
+	for (size_t start = 0, end = 0; start < transmitted.size(); start = end)
 	{
-		for (size_t j = 0; j < n_J; ++j)
+		size_t n = transmitted[start].len;
+		for (end = start + 1; end < transmitted.size() and transmitted[end].len == n; ++end);
+		Float factor = counts ? 1.0 : channel.normalization_factor(n, received.len);
+		if (prefer_sparse_column(n, received.len, end - start))
 		{
-			if (prob_table[k][j] < 1E-30)
+			// Only visit the supersequences of the received codeword.
+			nonzeros.clear();
+			enumerate_supersequence_counts(received, n, transmitted.data() + start, end - start, nonzeros);
+			for (const auto& entry : nonzeros)
 			{
-				continue;
+				res[start + entry.index] = factor * entry.count;
 			}
-			if (std::isnan(denominator[j]) or denominator[j] < 1E-50)
+			continue;
+		}
+		if (transmitted_index == NULL)
+		{
+			for (size_t i = start; i < end; ++i)
 			{
-				denominator[j] = 1E-50;
+				res[i] = factor * count_transitions(transmitted[i], received);
 			}
-			// printf("%lu\t%lu\t%.2f%%\t%.2f%%\t%.2f\t%.2f\n", k, j, 100*Q_i[k], 100*prob_table[k][j], log(prob_table[k][j]), log(denominator[j]));
-			rate += Q_i[k] * prob_table[k][j] * log(prob_table[k][j] / denominator[j]);
+			continue;
+		}
+		candidates.clear();
+		transmitted_index->collect_sources(received, n, candidates);
+		for (size_t i : candidates)
+		{
+			res[i] = factor * count_transitions(transmitted[i], received);
 		}
 	}
+	return res;
+}
+
+
+Float compute_bit_rate_efficient(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
+	const std::vector<Float>& log_W_jk_den, const std::vector<Float>& Q_i){
+	return compute_bit_rate_sum(channel, transmitted, received, log_W_jk_den, Q_i).value();
+}
 
-	return rate;
+
+ReproducibleSum compute_bit_rate_sum(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
+	const std::vector<Float>& log_W_jk_den, const std::vector<Float>& Q_i){
+	CodewordBucketIndex received_index(received);
+	return baa_rate_sum(EfficientBitBaaChannel{channel, &received_index}, transmitted, received, log_W_jk_den, Q_i);
+}
+
+
+std::vector<ReproducibleSum> compute_bit_rate_derivative_sums(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, 
+	const std::vector<EfficientBitCodeWord>& received, const std::vector<Float>& log_W_jk_den, const std::vector<Float>& Q_i){
+	std::vector<ReproducibleSum> sums(3);
+	CodewordBucketIndex received_index(received);
+	sums[0] = baa_rate_sum(EfficientBitBaaChannel{channel, &received_index}, transmitted, received, log_W_jk_den, Q_i,
+		sums.data() + 1);
+	return sums;
+}
+
+
+Float compute_rate(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
+	const std::vector<Float>& Q_i){
+	return baa_rate_from_full_table(EfficientBitBaaChannel{channel, NULL}, transmitted, received, Q_i);
 }
 
 std::vector<EfficientBitCodeWord> get_transmitted_codewords_symmetries(const std::vector<EfficientBitCodeWord>& all_trans_codewords){
@@ -1,12 +1,21 @@
 #pragma once
 #include "utils.h"
 #include "bit_channel.h"
+#include "codeword_buckets.h"
+#include "reproducible_sum.h"
+#include "baa_engine.h"
+
+
+/*
+All of the functions below run in the channel context they are given (see channel_context.h), so several configurations
+	can be evaluated at once.
+*/
 
 
 /*
 Performs a full BAA step on the given input and output alphabets, with the given initial distribution Q_i.
 */
-std::vector<Float> do_full_baa_step(const std::vector<EfficientBitCodeWord>& transmitted, 
+std::vector<Float> do_full_baa_step(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, 
 	const std::vector<EfficientBitCodeWord>& received, 
 	const std::vector<Float>& Q_i);
 
@@ -15,42 +24,156 @@ std::vector<Float> do_full_baa_step(const std::vector<EfficientBitCodeWord>& tra
 Computes the amount of information from the given distribution on the given transmitted codewords.
 This is a straightforward implementation that computes a full transition prob table and is useful only for debugging purposes.
 */
-Float compute_rate(const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
+Float compute_rate(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
 	const std::vector<Float>& Q_i);
 
 /*
 Computes the amount of information from the given distribution on the given transmitted codewords.
 For disributing purposes it is possible to run this with only some of the codewords and then to sum over the possibilities.
 */
-Float compute_bit_rate_efficient(const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
+Float compute_bit_rate_efficient(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
 	const std::vector<Float>& log_W_jk_den, const std::vector<Float>& Q_i);
 
+/*
+The rate as an order independent sum of the contributions of the transmitted codewords, so that the sums of the shards
+	add up to exactly the rate of all of them.
+*/
+ReproducibleSum compute_bit_rate_sum(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
+	const std::vector<Float>& log_W_jk_den, const std::vector<Float>& Q_i);
+
+/*
+The rate and its first and second derivatives by the deletion probability at the fixed distribution Q_i, as the sums
+	{rate, d rate / dd, d^2 rate / dd^2} (merged across the shards as the rate is).
+As P_jk = f(n, k) * count_jk, where only the normalization factor depends on d, and the terms of dW_j cancel out
+	(sum_j dW_j - sum_i Q_i sum_j P_ij dW_j / W_j = 0), every term of the rate only picks up f' / f (and f'' / f for the
+	second derivative) of its received length. So the derivatives cost no more than the rate.
+At a Q that maximises the rate, the first derivative is the derivative of the maximal rate itself (by the envelope
+	theorem), and the second one, which ignores how the maximiser moves with d, a lower bound on its second derivative.
+	Note that the BAA's fixed point only maximises the rate when the rows of P sum to 1. The rows of the up_to alphabet
+	(which keeps the lengths out_len - 1 and out_len only) sum to s < 1, and as every step takes Q_i^s rather than Q_i,
+	its fixed point maximises rate + (1 - s) H(Q) instead. There the derivatives are those of the rate along the fixed Q
+	only, and miss the part of the slope of the BAA's rates that comes from Q moving with d (about a tenth of it at
+	(8, 5) and d = 0.2).
+*/
+std::vector<ReproducibleSum> compute_bit_rate_derivative_sums(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, 
+	const std::vector<EfficientBitCodeWord>& received, const std::vector<Float>& log_W_jk_den, const std::vector<Float>& Q_i);
+
 
 /*
 Computes the denominator of multiple W_jk entries. 
 This is a function that depends on the transition probabilities out of all of the transmitted codewords.
 In general, when distributing, this should be called with all of the transmitted codewords and part of the received ones.
 */
-std::vector<Float> compute_all_log_Wjk_den (const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
+std::vector<Float> compute_all_log_Wjk_den (const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
 	const std::vector<Float>& Q_i);
 
+/*
+The linear denominators sum_i Q_i[i] * P_ij of a part of the transmitted codewords, as order independent sums. The sums of
+	the shards of the transmitted alphabet are merged with ReproducibleSum::add, and the merged sums give exactly the same
+	log denominators (through log_Wjk_den_from_sums) however the alphabet was split.
+*/
+std::vector<ReproducibleSum> compute_all_Wjk_den_sums (const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, 
+	const std::vector<EfficientBitCodeWord>& received, const std::vector<Float>& Q_i);
+
+/*
+Averages the denominators of the received pairs (a codeword and its complement) and takes their logs.
+*/
+std::vector<Float> log_Wjk_den_from_sums (const std::vector<ReproducibleSum>& W_jk_den);
+
+/*
+Incrementally updates the linear denominators (as in compute_all_Wjk_den_sums) W_jk_den = sum_i Q_applied[i] * P_ij to a new distribution.
+Only the transmitted codewords whose probability moved by more than tolerance (relative to the applied probability) are updated,
+	by adding (Q_new[i] - Q_applied[i]) times their row of P_jk. Q_applied is updated for exactly these codewords, so the
+	denominators always match Q_applied and the skipped changes are picked up once they accumulate past the tolerance.
+Starting from Q_applied = 0 and empty sums this gives exactly the sums of compute_all_Wjk_den_sums.
+Returns the number of transmitted codewords whose rows were applied.
+*/
+size_t update_Wjk_den_incremental (const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
+	const std::vector<Float>& Q_new, std::vector<Float>& Q_applied, std::vector<ReproducibleSum>& W_jk_den, Float tolerance);
+
 /*
 Computes the values of alphas (which determine the probabilities in the next BAA step).
 When distributing, this should be called with a subset of the transmitted codewords and all of the received ones.
 */
-std::vector<Float> compute_all_log_alpha_k (const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
+std::vector<Float> compute_all_log_alpha_k (const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received, 
 	const std::vector<Float>& Q_i, const std::vector<Float>& log_W_jk_den);
 
 
 
 
-std::vector<Float> compute_Pjk_row(const EfficientBitCodeWord& transmitted, const std::vector<EfficientBitCodeWord>& received);
+/*
+The row and the column of the transition table. When an index of the alphabet that is iterated over is given, only the
+	pairs that pass its weight and run tests are evaluated (the others are known to be 0).
+*/
+std::vector<Float> compute_Pjk_row(const ChannelContext& channel, const EfficientBitCodeWord& transmitted, const std::vector<EfficientBitCodeWord>& received,
+	const CodewordBucketIndex* received_index = NULL);
 
-std::vector<Float> compute_Pjk_col(const std::vector<EfficientBitCodeWord>& transmitted, const EfficientBitCodeWord& received);
+/*
+Writes the entries [begin, end) of the row of the transmitted codeword to out (used to compute the row a tile at a time).
+*/
+void compute_Pjk_row_range(const ChannelContext& channel, const EfficientBitCodeWord& transmitted, const std::vector<EfficientBitCodeWord>& received,
+	size_t begin, size_t end, const CodewordBucketIndex* received_index, Float* out);
 
-Float compute_Wjk_den (const std::vector<EfficientBitCodeWord>& transmitted, const EfficientBitCodeWord& received, const std::vector<Float>& Q_i);
-Float compute_log_alpha_k (const EfficientBitCodeWord& transmitted, const std::vector<EfficientBitCodeWord>& received, 
-	Float Q_k, const std::vector<Float>& log_W_jk_den);
+/*
+compute_Pjk_row_range, which also writes the logs of the entries to log_out. The logs are assembled from the cached log
+	normalization factors and the logs of the exact transition counts (see log_count_table.h), rather than taken of the
+	entries, which takes the library calls out of the BAA passes. They agree with the logs of the entries up to rounding.
+*/
+void compute_log_Pjk_row_range(const ChannelContext& channel, const EfficientBitCodeWord& transmitted, const std::vector<EfficientBitCodeWord>& received,
+	size_t begin, size_t end, const CodewordBucketIndex* received_index, Float* out, Float* log_out);
 
+std::vector<Float> compute_Pjk_col(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const EfficientBitCodeWord& received,
+	const CodewordBucketIndex* transmitted_index = NULL);
 
-std::vector<EfficientBitCodeWord> get_transmitted_codewords_symmetries(const std::vector<EfficientBitCodeWord>& all_trans_codewords);
\ No newline at end of file
+/*
+The exact transition counts of the entries [begin, end) of the row and of the column: P_jk without the normalization
+	factors. They are in floating point, and exact below 2^53.
+*/
+void compute_transition_count_row_range(const ChannelContext& channel, const EfficientBitCodeWord& transmitted,
+	const std::vector<EfficientBitCodeWord>& received, size_t begin, size_t end, const CodewordBucketIndex* received_index, Float* out);
+std::vector<Float> compute_transition_count_col(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted,
+	const EfficientBitCodeWord& received, const CodewordBucketIndex* transmitted_index = NULL);
+
+Float compute_Wjk_den (const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const EfficientBitCodeWord& received, const std::vector<Float>& Q_i,
+	const CodewordBucketIndex* transmitted_index = NULL);
+Float compute_log_alpha_k (const ChannelContext& channel, const EfficientBitCodeWord& transmitted, const std::vector<EfficientBitCodeWord>& received, 
+	Float Q_k, const std::vector<Float>& log_W_jk_den, const CodewordBucketIndex* received_index = NULL);
+
+
+std::vector<EfficientBitCodeWord> get_transmitted_codewords_symmetries(const std::vector<EfficientBitCodeWord>& all_trans_codewords);
+
+
+/*
+The EfficientBitCodeWord representation as a channel of the BAA engine (see baa_engine.h): the rows come from
+	compute_Pjk_row_range (pruned by the index of the received alphabet, when one is given) and their logs from
+	compute_log_Pjk_row_range, the received alphabet comes in complement pairs, and the derivatives by the deletion
+	probability are those of the normalization factors.
+*/
+struct EfficientBitBaaChannel
+{
+	typedef EfficientBitCodeWord Codeword;
+	static constexpr bool HAS_DELETION_DERIVATIVES = true;
+	static constexpr bool HAS_LOG_ROWS = true;
+
+	const ChannelContext& context;
+	const CodewordBucketIndex* received_index;
+
+	void compute_row_range(const EfficientBitCodeWord& transmitted, const std::vector<EfficientBitCodeWord>& received,
+		size_t begin, size_t end, Float* out) const{
+		compute_Pjk_row_range(context, transmitted, received, begin, end, received_index, out);
+	}
+	void compute_log_row_range(const EfficientBitCodeWord& transmitted, const std::vector<EfficientBitCodeWord>& received,
+		size_t begin, size_t end, Float* out, Float* log_out) const{
+		compute_log_Pjk_row_range(context, transmitted, received, begin, end, received_index, out, log_out);
+	}
+	bool averages_received_pairs() const{
+		return true;
+	}
+	BaaTileShape tile_shape(const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received) const;
+	Float log_derivative(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord& received) const{
+		return context.normalization_factor_log_derivative(transmitted.len, received.len);
+	}
+	Float second_derivative_ratio(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord& received) const{
+		return context.normalization_factor_second_derivative_ratio(transmitted.len, received.len);
+	}
+};
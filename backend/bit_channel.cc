@@ -2,59 +2,6 @@
 #include <cmath>
 
 
-std::vector<std::vector<Float> > _normalization_factors;
-Float _deletion_prob = 0.0;
-
-void initialize_bit_channel(Float deletion_prob, size_t in_len, size_t out_len, bool up_to, bool load_cache){
-	_deletion_prob = deletion_prob;
-	_normalization_factors.resize(in_len+1);
-	for (size_t i_len = 0; i_len < in_len+1; ++i_len)
-	{
-		_normalization_factors[i_len].resize(out_len+1);
-		std::vector<Float> prob_out_len_k;
-		prob_out_len_k.resize(out_len+1);
-		prob_out_len_k[0] = pow(deletion_prob, i_len);
-		std::vector<size_t> num_out_len_k;
-		num_out_len_k.resize(out_len+1);
-		num_out_len_k[0] = 1;
-		for (size_t k = 1; k < out_len+1; ++k)
-		{
-			num_out_len_k[k] = ((i_len - k + 1) * num_out_len_k[k-1]) / (k);
-			if (up_to)
-			{
-				prob_out_len_k[k] = pow(deletion_prob, i_len-k) * pow(1 - deletion_prob, k);
-			}
-		}
-		if (not up_to)
-		{
-			_normalization_factors[i_len][out_len] = 1. / num_out_len_k[out_len];
-			continue;
-		}
-		Float total = std::inner_product(num_out_len_k.begin(), num_out_len_k.end(), prob_out_len_k.begin(), 0.0);
-		for (size_t k = 0; k < out_len+1; ++k)
-		{
-			_normalization_factors[i_len][k] = prob_out_len_k[k] / total;
-		}
-	}
-
-	if (load_cache)
-	{
-		size_t n = in_len;
-		size_t k = out_len;
-		for (size_t n1 = 0; n1 <= (n+1)/2; ++n1)
-		{
-			for (size_t k1 = 0; k1 <= k; ++k1)
-			{
-				load_transition_cache(n1, k1);
-			}
-		}
-	}
-		
-}
-
-
-
-
 CodeWord convert_to_run_word(const BitCodeWord& bit_code){
 	std::vector<Run> res;
 	if (bit_code.size() == 0)
@@ -118,6 +65,26 @@ std::vector<BitCodeWord> get_all_bit_codewords(size_t len, bool up_to){
 	}
 }
 
+std::vector<EfficientBitCodeWord> get_sorted_bit_codewords(size_t len, bool up_to){
+	auto ineff_codewords = get_all_bit_codewords(len, up_to);
+	std::vector<EfficientBitCodeWord> codewords(ineff_codewords.begin(), ineff_codewords.end());
+	std::sort(codewords.begin(), codewords.end());
+	return codewords;
+}
+
+std::vector<EfficientBitCodeWord> get_sorted_bit_codewords_of_lengths(size_t min_len, size_t max_len){
+	std::vector<EfficientBitCodeWord> codewords;
+	for (size_t len = min_len; len <= max_len; ++len)
+	{
+		for (uint64_t num = 0; num < (1ULL << len); ++num)
+		{
+			codewords.push_back(EfficientBitCodeWord(num, len));
+		}
+	}
+	std::sort(codewords.begin(), codewords.end());
+	return codewords;
+}
+
 
 
 
@@ -1,12 +1,16 @@
 #pragma once
 #include "channel.h"
 #include "cached_transition_probs.h"
+#include "channel_context.h"
 
 
 typedef std::vector<uint8_t> BitCodeWord;
 
 struct EfficientBitCodeWord;
 
+/*
+Sets up the default channel context (see channel_context.h) for the given configuration.
+*/
 void initialize_bit_channel(Float deletion_prob, size_t in_len, size_t out_len, bool up_to, bool load_cache=true);
 
 template <typename _InputIter>
@@ -54,6 +58,9 @@ Uses the dynamic programming algorithm to determine the probability that the tra
 Float get_bit_transition_prob(const BitCodeWord& transmitted, const BitCodeWord& recieved, bool verbose=false,
 	bool use_cache=false);
 
+Float get_bit_transition_prob_fast(const ChannelContext& channel, const EfficientBitCodeWord& transmitted,
+	const EfficientBitCodeWord& recieved, bool verbose=false);
+// The same, in the default channel context.
 Float get_bit_transition_prob_fast(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord& recieved, bool verbose=false);
 
 
@@ -80,6 +87,18 @@ size_t get_num_transition_possibilities_using_cache_fast(const EfficientBitCodeW
 
 std::vector<BitCodeWord> get_all_bit_codewords(size_t len, bool up_to=false);
 
+/*
+The codewords of get_all_bit_codewords as EfficientBitCodeWords, sorted as in the codeword files (by length, and then
+	every codeword next to its complement).
+*/
+std::vector<EfficientBitCodeWord> get_sorted_bit_codewords(size_t len, bool up_to=false);
+
+/*
+Every codeword with a length in [min_len, max_len], sorted as above. Without the empty codeword (min_len > 0), the
+	codewords come in (codeword, complement) pairs.
+*/
+std::vector<EfficientBitCodeWord> get_sorted_bit_codewords_of_lengths(size_t min_len, size_t max_len);
+
 
 
 
@@ -2,8 +2,16 @@
 #include "bit_channel.h"
 
 
-extern std::vector<std::vector<Float> > _normalization_factors;
-extern Float _deletion_prob;
+/*
+The transition counting kernel used for every (transmitted length, received length) bucket (see transition_kernels.h).
+*/
+typedef size_t (*TransitionCountKernel)(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord& recieved);
+constexpr size_t MAX_KERNEL_WORD_LEN = 64;
+extern std::array<std::array<TransitionCountKernel, MAX_KERNEL_WORD_LEN + 1>, MAX_KERNEL_WORD_LEN + 1> _transition_count_kernels;
+
+inline size_t count_transitions(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord& recieved){
+	return _transition_count_kernels[transmitted.len][recieved.len](transmitted, recieved);
+}
 
 inline size_t get_num_transition_possibilities(const BitCodeWord& transmitted, const BitCodeWord& recieved, bool verbose){
 	size_t st = transmitted.size() + 1;
@@ -59,7 +67,7 @@ inline Float get_bit_transition_prob(const BitCodeWord& transmitted, const BitCo
 	size_t st = transmitted.size() + 1;
 	size_t sr = recieved.size() + 1;
 
-	Float base_prob = _normalization_factors[st - 1][sr - 1];
+	Float base_prob = default_channel_context().normalization_factor(st - 1, sr - 1);
 	
 	size_t count;
 	if (verbose)
@@ -95,14 +103,21 @@ inline Float get_bit_transition_prob(const BitCodeWord& transmitted, const BitCo
 }
 
 
-inline Float get_bit_transition_prob_fast(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord& recieved, bool verbose){
+inline Float get_bit_transition_prob_fast(const ChannelContext& channel, const EfficientBitCodeWord& transmitted,
+	const EfficientBitCodeWord& recieved, bool verbose){
 	size_t st = transmitted.len + 1;
 	size_t sr = recieved.len + 1;
 
-	Float base_prob = _normalization_factors[st - 1][sr - 1];
+	Float base_prob = channel.normalization_factor(st - 1, sr - 1);
 	
 	size_t count;
-	count = get_num_transition_possibilities_using_cache_fast(transmitted, recieved, verbose);
+	if (verbose)
+	{
+		count = get_num_transition_possibilities_using_cache_fast(transmitted, recieved, verbose);
+	} else {
+		// Dispatch to the kernel chosen for this (transmitted length, received length) bucket by autotune_transition_kernels.
+		count = count_transitions(transmitted, recieved);
+	}
 	if (verbose)
 	{
 		printf("%lu, %lu\n", transmitted.len, recieved.len);
@@ -116,6 +131,11 @@ inline Float get_bit_transition_prob_fast(const EfficientBitCodeWord& transmitte
 }
 
 
+inline Float get_bit_transition_prob_fast(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord& recieved, bool verbose){
+	return get_bit_transition_prob_fast(default_channel_context(), transmitted, recieved, verbose);
+}
+
+
 inline size_t get_num_transition_possibilities_using_cache(const BitCodeWord& transmitted, const BitCodeWord& recieved, bool verbose){
 	size_t n = transmitted.size();
 	size_t k = recieved.size();
@@ -163,7 +183,7 @@ inline size_t get_num_transition_possibilities_using_cache_fast(const EfficientB
 	size_t n2 = n - n1;
 	size_t total = 0;
 	size_t trans_num1 = transmitted.num >> n2;
-	size_t trans_num2 = transmitted.num  & ((1 << n2) - 1);
+	size_t trans_num2 = transmitted.num & ((1ULL << n2) - 1);
 	if (verbose)
 	{
 		printf("n = %lu, k = %lu\n", n, k);
@@ -181,7 +201,7 @@ inline size_t get_num_transition_possibilities_using_cache_fast(const EfficientB
 			continue;
 		}
 		size_t rec_num1 = recieved.num >> k2;
-		size_t rec_num2 = recieved.num & ((1 << k2) - 1);
+		size_t rec_num2 = recieved.num & ((1ULL << k2) - 1);
 		if (verbose)
 		{
 			printf("n1=%lu\t k1=%lu\t n2=%lu\t k2=%lu\t trans_num1=%lu\t trans_num2=%lu\t rec_num1=%lu\t rec_num2=%lu\n", n1, k1, n2, k2,
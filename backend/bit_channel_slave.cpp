@@ -1,11 +1,28 @@
 // #include "bit_baa.h"
 #include "bit_baa_fast.h"
+#include "perf_counters.h"
+#include "resource_planner.h"
+#include "transition_kernels.h"
+#include "monte_carlo_rate.h"
+#include "deletion_channel_simulator.h"
+#include "numa_placement.h"
+#include "dual_bound.h"
+#include "certified_rate.h"
+#include <chrono>
 #include <cstring>
+#include <unistd.h>
 
 const char* GENERATE_CODEWORDS = "gen_codewords";
 const char* COMPUTE_DENOMS = "denominators";
+const char* COMPUTE_DENOMS_DELTA = "denominators_delta";
 const char* COMPUTE_ALPHAS = "alphas";
 const char* COMPUTE_RATE = "rate";
+const char* PLAN_RESOURCES = "plan";
+const char* ESTIMATE_RATE_MONTE_CARLO = "mc_rate";
+const char* SIMULATE_CHANNEL = "simulate";
+const char* MERGE_SUMS = "merge_sums";
+const char* DUAL_BOUND = "dual_bound";
+const char* CERTIFY = "certify";
 
 void generate_codewords(bool up_to, size_t max_len, const char* output_file_name, bool is_transmitted){
 	auto ineff_codewords = get_all_bit_codewords(max_len, up_to);
@@ -44,14 +61,88 @@ void compute_denominators(const char* transmitted_codewords_filename, const char
 		}
 	}
 
-	initialize_bit_channel(deletion_probability, input_len, output_len, up_to);
+	ChannelContext channel(deletion_probability, input_len, output_len, up_to);
+	autotune_transition_kernels(input_len, output_len, up_to);
 
-	auto denominators = compute_all_log_Wjk_den (transmitted_codewords, received_codewords, Q);
-	write_1d_array_to_file(output_file, denominators);
+	auto denominators = compute_all_Wjk_den_sums (channel, transmitted_codewords, received_codewords, Q);
+	write_reproducible_sums_to_file(output_file, denominators);
 	fclose(output_file); fclose(transmitted_codewords_file); fclose(received_codewords_file); fclose(Q_array_file);
 }
 
 
+/*
+Loads a part of the state of the incremental denominators computation.
+A missing state file means that no row was applied yet.
+*/
+std::vector<Float> load_incremental_state(const char* state_filename, size_t size){
+	std::vector<Float> res;
+	FILE* state_file = fopen(state_filename, "rb");
+	if (state_file == NULL)
+	{
+		res.resize(size, 0.0);
+		return res;
+	}
+	res = load_1d_array_from_file(state_file);
+	fclose(state_file);
+	assert(res.size() == size);
+	return res;
+}
+
+void compute_denominators_incremental(const char* transmitted_codewords_filename, const char* received_codewords_filename, 
+	size_t start, size_t end, const char* Q_array_filename, Float deletion_probability, const char* output_file_name, 
+	size_t input_len, size_t output_len, bool up_to, const char* Q_applied_filename, const char* dens_state_filename,
+	Float tolerance){
+
+	FILE* transmitted_codewords_file = try_to_open_file(transmitted_codewords_filename, "rb");
+	FILE* received_codewords_file = try_to_open_file(received_codewords_filename, "rb");
+	FILE* Q_array_file = try_to_open_file(Q_array_filename, "rb");
+
+	auto transmitted_codewords = load_bit_codewords_from_file_fast(transmitted_codewords_file, start, end);
+	auto received_codewords = load_bit_codewords_from_file_fast(received_codewords_file);
+
+	std::vector<Float> Q;
+	Q.resize(end - start);
+	{
+		auto Q_all = load_1d_array_from_file(Q_array_file);
+		assert(Q_all.size() >= end);
+		for (size_t i = 0; i < (end-start); ++i)
+		{
+			Q[i] = Q_all[start+i];
+		}
+	}
+	fclose(transmitted_codewords_file); fclose(received_codewords_file); fclose(Q_array_file);
+
+	// The shard's denominators match the distribution Q_applied, which lags behind Q on the entries that barely moved.
+	auto Q_applied = load_incremental_state(Q_applied_filename, Q.size());
+	std::vector<ReproducibleSum> dens(received_codewords.size());
+	FILE* dens_state_file = fopen(dens_state_filename, "rb");
+	if (dens_state_file != NULL)
+	{
+		dens = load_reproducible_sums_from_file(dens_state_file);
+		fclose(dens_state_file);
+		assert(dens.size() == received_codewords.size());
+	}
+
+	ChannelContext channel(deletion_probability, input_len, output_len, up_to);
+	autotune_transition_kernels(input_len, output_len, up_to);
+
+	size_t num_updated = update_Wjk_den_incremental(channel, transmitted_codewords, received_codewords, Q, Q_applied, dens, tolerance);
+	printf("Updated %lu / %lu transmitted codewords\n", num_updated, Q.size());
+
+	FILE* Q_applied_file = try_to_open_file(Q_applied_filename, "wb");
+	write_1d_array_to_file(Q_applied_file, Q_applied);
+	fclose(Q_applied_file);
+	dens_state_file = try_to_open_file(dens_state_filename, "wb");
+	write_reproducible_sums_to_file(dens_state_file, dens);
+	fclose(dens_state_file);
+
+	// The state is the shard's partial sums, in the same format as the output of the denominators command.
+	FILE* output_file = try_to_open_file(output_file_name, "wb");
+	write_reproducible_sums_to_file(output_file, dens);
+	fclose(output_file);
+}
+
+
 void compute_alphas(const char* transmitted_codewords_filename, const char* received_codewords_filename,
 	size_t start, size_t end, const char* Q_array_filename, const char* denominators_filename, 
 	size_t input_len, size_t output_len, bool up_to, Float deletion_probability, const char* output_file_name){
@@ -78,9 +169,10 @@ void compute_alphas(const char* transmitted_codewords_filename, const char* rece
 
 	auto denominators = load_1d_array_from_file(denominators_file);
 
-	initialize_bit_channel(deletion_probability, input_len, output_len, up_to);
+	ChannelContext channel(deletion_probability, input_len, output_len, up_to);
+	autotune_transition_kernels(input_len, output_len, up_to);
 
-	auto alphas = compute_all_log_alpha_k (transmitted_codewords, received_codewords, Q, denominators);
+	auto alphas = compute_all_log_alpha_k (channel, transmitted_codewords, received_codewords, Q, denominators);
 
 	write_1d_array_to_file(output_file, alphas);
 
@@ -114,18 +206,207 @@ void compute_rate(const char* transmitted_codewords_filename, const char* receiv
 
 	auto denominators = load_1d_array_from_file(denominators_file);
 
-	initialize_bit_channel(deletion_probability, input_len, output_len, up_to);
+	ChannelContext channel(deletion_probability, input_len, output_len, up_to);
+	autotune_transition_kernels(input_len, output_len, up_to);
 
-	Float rate = compute_bit_rate_efficient(transmitted_codewords, received_codewords, denominators, Q);
-	std::vector<Float> rate_as_array = {rate};
+	// The rate and its derivatives by the deletion probability, which come at no extra cost.
+	auto rate_sums = compute_bit_rate_derivative_sums(channel, transmitted_codewords, received_codewords, denominators, Q);
 
-	write_1d_array_to_file(output_file, rate_as_array);
+	write_reproducible_sums_to_file(output_file, rate_sums);
 
 	fclose(output_file); fclose(transmitted_codewords_file); fclose(received_codewords_file); 
 	fclose(Q_array_file); fclose(denominators_file);
 }
 
 
+/*
+Merges the partial sums written by the shards (in any number and order) and saves the merged values: either the log
+	denominators (averaged over the received pairs, as needed by the alphas and rate commands) or the plain sums.
+*/
+void merge_sums(const char* output_file_name, bool log_dens, const std::vector<const char*>& input_file_names){
+	std::vector<ReproducibleSum> merged;
+	for (const char* input_file_name : input_file_names)
+	{
+		FILE* input_file = try_to_open_file(input_file_name, "rb");
+		auto sums = load_reproducible_sums_from_file(input_file);
+		fclose(input_file);
+		if (merged.empty())
+		{
+			merged.resize(sums.size());
+		}
+		if (sums.size() != merged.size())
+		{
+			fprintf(stderr, "Error: %s holds %lu sums rather than %lu.\n", input_file_name, sums.size(), merged.size());
+			exit(1);
+		}
+		for (size_t j = 0; j < sums.size(); ++j)
+		{
+			merged[j].add(sums[j]);
+		}
+	}
+
+	std::vector<Float> values;
+	if (log_dens)
+	{
+		values = log_Wjk_den_from_sums(merged);
+	}
+	else{
+		for (const auto& sum : merged)
+		{
+			values.push_back(sum.value());
+		}
+	}
+	FILE* output_file = try_to_open_file(output_file_name, "wb");
+	write_1d_array_to_file(output_file, values);
+	fclose(output_file);
+}
+
+
+void estimate_rate(size_t input_len, size_t output_len, bool up_to, Float deletion_probability, const MarkovInputDistribution& Q,
+	const MonteCarloRateOptions& options, const char* output_file_name){
+	auto estimate = estimate_rate_monte_carlo(Q, deletion_probability, input_len, output_len, up_to, options);
+	printf("rate = %f +- %f nats (%lu samples%s)\n", estimate.rate, estimate.half_width, estimate.num_samples,
+		estimate.converged ? "" : ", did not converge");
+
+	std::vector<Float> estimate_as_array = {estimate.rate, estimate.standard_error, estimate.half_width, 
+		(Float) estimate.num_samples, (Float) estimate.converged};
+	FILE* output_file = try_to_open_file(output_file_name, "wb");
+	write_1d_array_to_file(output_file, estimate_as_array);
+	fclose(output_file);
+}
+
+
+/*
+Evaluates the dual bound max_t D(P_t || R) of the output distribution in R_array_file (aligned with the received codewords
+	file) over the transmitted codewords file.
+The output file holds (bound, num_early_exits, index, divergence, index, divergence, ...) for the maximisers in decreasing
+	divergence, all in nats.
+*/
+void evaluate_dual_bound(const char* transmitted_codewords_filename, const char* received_codewords_filename,
+	const char* R_array_filename, Float deletion_probability, size_t input_len, size_t output_len, bool up_to,
+	size_t num_maximisers, size_t num_threads, const char* output_file_name){
+	FILE* transmitted_codewords_file = try_to_open_file(transmitted_codewords_filename, "rb");
+	FILE* received_codewords_file = try_to_open_file(received_codewords_filename, "rb");
+	FILE* R_array_file = try_to_open_file(R_array_filename, "rb");
+	auto transmitted_codewords = load_bit_codewords_from_file_fast(transmitted_codewords_file);
+	auto received_codewords = load_bit_codewords_from_file_fast(received_codewords_file);
+	auto R = load_1d_array_from_file(R_array_file);
+	fclose(transmitted_codewords_file); fclose(received_codewords_file); fclose(R_array_file);
+	if (R.size() != received_codewords.size())
+	{
+		fprintf(stderr, "%s has %lu probabilities for %lu received codewords.\n", R_array_filename, R.size(), received_codewords.size());
+		exit(1);
+	}
+
+	ChannelContext channel(deletion_probability, input_len, output_len, up_to);
+	autotune_transition_kernels(input_len, output_len, up_to);
+	DualBoundOptions options;
+	options.num_maximisers = num_maximisers;
+	options.num_threads = num_threads;
+	auto result = compute_dual_bound(channel, transmitted_codewords, received_codewords, R, options);
+
+	printf("bound = %f nats (%f bits), %lu of %lu rows dropped early\n", result.bound, result.bound / log(2),
+		result.num_early_exits, transmitted_codewords.size());
+	std::vector<Float> result_as_array = {result.bound, (Float) result.num_early_exits};
+	for (const auto& maximiser : result.maximisers)
+	{
+		const auto& codeword = transmitted_codewords[maximiser.index];
+		printf("%f\t", maximiser.divergence);
+		for (size_t i = codeword.len; i-- > 0;)
+		{
+			printf("%d", (int) ((codeword.num >> i) & 1));
+		}
+		printf("\n");
+		result_as_array.push_back(maximiser.index);
+		result_as_array.push_back(maximiser.divergence);
+	}
+	FILE* output_file = try_to_open_file(output_file_name, "wb");
+	write_1d_array_to_file(output_file, result_as_array);
+	fclose(output_file);
+}
+
+
+/*
+Certifies the rate and the dual bound of the distribution in Q_array_file with interval arithmetic (see certified_rate.h).
+The output file holds (rate_lo, rate_hi, bound_lo, bound_hi, maximiser), in nats: the capacity of the channel is at least
+	rate_lo and at most bound_hi.
+*/
+void certify(const char* transmitted_codewords_filename, const char* received_codewords_filename,
+	const char* Q_array_filename, Float deletion_probability, size_t input_len, size_t output_len, bool up_to,
+	size_t num_threads, const char* output_file_name){
+	FILE* transmitted_codewords_file = try_to_open_file(transmitted_codewords_filename, "rb");
+	FILE* received_codewords_file = try_to_open_file(received_codewords_filename, "rb");
+	FILE* Q_array_file = try_to_open_file(Q_array_filename, "rb");
+	auto transmitted_codewords = load_bit_codewords_from_file_fast(transmitted_codewords_file);
+	auto received_codewords = load_bit_codewords_from_file_fast(received_codewords_file);
+	auto Q = load_1d_array_from_file(Q_array_file);
+	fclose(transmitted_codewords_file); fclose(received_codewords_file); fclose(Q_array_file);
+	if (Q.size() != transmitted_codewords.size())
+	{
+		fprintf(stderr, "%s has %lu probabilities for %lu transmitted codewords.\n", Q_array_filename, Q.size(), transmitted_codewords.size());
+		exit(1);
+	}
+	if (input_len > MAX_CERTIFIED_LEN)
+	{
+		fprintf(stderr, "The counts of codewords of length %lu are not exact in doubles (at most %lu).\n", input_len, MAX_CERTIFIED_LEN);
+		exit(1);
+	}
+
+	ChannelContext channel(deletion_probability, input_len, output_len, up_to);
+	auto result = certify_rate(channel, transmitted_codewords, received_codewords, Q, num_threads);
+	printf("rate in [%.17g, %.17g] nats\n", result.rate.lo, result.rate.hi);
+	printf("bound in [%.17g, %.17g] nats\n", result.max_divergence.lo, result.max_divergence.hi);
+	std::vector<Float> result_as_array = {result.rate.lo, result.rate.hi, result.max_divergence.lo, result.max_divergence.hi,
+		(Float) result.maximiser};
+	FILE* output_file = try_to_open_file(output_file_name, "wb");
+	write_1d_array_to_file(output_file, result_as_array);
+	fclose(output_file);
+}
+
+
+/*
+Transmits every codeword of the transmitted codewords file samples_per_codeword times through the deletion channel, and
+	saves the received codewords (in the same order) to the output file.
+*/
+void simulate_channel(const char* transmitted_codewords_filename, Float deletion_probability, size_t input_len, size_t output_len,
+	bool up_to, size_t samples_per_codeword, uint64_t seed, const char* output_file_name){
+	FILE* transmitted_codewords_file = try_to_open_file(transmitted_codewords_filename, "rb");
+	auto codewords = load_bit_codewords_from_file_fast(transmitted_codewords_file);
+	fclose(transmitted_codewords_file);
+
+	std::vector<EfficientBitCodeWord> transmitted;
+	transmitted.reserve(codewords.size() * samples_per_codeword);
+	for (const auto& codeword : codewords)
+	{
+		assert(codeword.len == input_len);
+		transmitted.insert(transmitted.end(), samples_per_codeword, codeword);
+	}
+	std::vector<EfficientBitCodeWord> received(transmitted.size(), EfficientBitCodeWord(0, 0));
+
+	auto channel = make_deletion_channel_simulator(deletion_probability, input_len, output_len, up_to, seed);
+	auto t0 = std::chrono::steady_clock::now();
+	simulate_deletion_channel_batch(channel, transmitted.data(), received.data(), transmitted.size(), 0);
+	std::chrono::duration<Float> elapsed = std::chrono::steady_clock::now() - t0;
+	printf("Simulated %lu transmissions in %.3f seconds (%.3g per second)\n", transmitted.size(), elapsed.count(),
+		transmitted.size() / std::max(elapsed.count(), 1E-9));
+
+	FILE* output_file = try_to_open_file(output_file_name, "wb");
+	save_bit_codewords_to_file(output_file, received);
+	fclose(output_file);
+}
+
+
+/*
+Appends the per-region performance counters gathered while running the given command to the stats file.
+*/
+void report_perf_stats(const char* stats_filename, const char* command){
+	FILE* stats_file = try_to_open_file(stats_filename, "a");
+	fprintf(stats_file, "# %s (pid %d)\n", command, getpid());
+	print_perf_stats(stats_file);
+	fclose(stats_file);
+}
+
+
 int main(int argc, char const *argv[])
 {
 	if (argc < 2)
@@ -133,6 +414,10 @@ int main(int argc, char const *argv[])
 		fprintf(stderr, "Usage: %s command [options]\n", argv[0]);
 		exit(1);
 	}
+	// Setting BDC_PERF_STATS=<stats file> turns on the hardware counter instrumentation of the hot kernels.
+	const char* perf_stats_filename = enable_perf_instrumentation_from_env();
+	// Setting BDC_NUMA_POLICY (and BDC_SHARD_INDEX) binds the process to the node of its shard before anything is loaded.
+	configure_numa_placement_from_env();
 	if (!strcmp(argv[1], GENERATE_CODEWORDS))
 	{
 		// Generate a file with all of the codewords. This is done so that different iterations of the computation
@@ -171,6 +456,33 @@ int main(int argc, char const *argv[])
 
 		compute_denominators(transmitted_codewords_filename, received_codewords_filename, start, end, Q_array_filename, 
 			deletion_probability, output_file_name, input_len, output_len, up_to);
+	} else if(!strcmp(argv[1], COMPUTE_DENOMS_DELTA)){
+		// Same as the denominators command, but only updates the shard's denominators with the rows of the transmitted
+		//    codewords whose probability changed by more than the (relative) tolerance since they were last applied.
+		// The state is kept in the Q_applied and dens_state files. Deleting them forces a full recomputation.
+		if (argc != 15)
+		{
+			fprintf(stderr, 
+				"Usage %s %s transmitted_codewords_file received_codewords_file start end Q_array_file deletion_probability output_file input_len output_len up_to Q_applied_file dens_state_file tolerance\n", 
+				argv[0], argv[1]);
+			exit(1);
+		}
+		const char* transmitted_codewords_filename = argv[2];
+		const char* received_codewords_filename = argv[3];
+		size_t start = atol(argv[4]);
+		size_t end = atol(argv[5]);
+		const char* Q_array_filename = argv[6];
+		Float deletion_probability = atof(argv[7]);
+		const char* output_file_name = argv[8];
+		size_t input_len = atol(argv[9]);
+		size_t output_len = atol(argv[10]);
+		bool up_to = atoi(argv[11]);
+		const char* Q_applied_filename = argv[12];
+		const char* dens_state_filename = argv[13];
+		Float tolerance = atof(argv[14]);
+
+		compute_denominators_incremental(transmitted_codewords_filename, received_codewords_filename, start, end, Q_array_filename, 
+			deletion_probability, output_file_name, input_len, output_len, up_to, Q_applied_filename, dens_state_filename, tolerance);
 	} else if(!strcmp(argv[1], COMPUTE_ALPHAS)){
 		if (argc != 13)
 		{
@@ -222,11 +534,136 @@ int main(int argc, char const *argv[])
 			start, end, Q_array_filename, log_dens_filename, input_len, output_len, up_to,
 			deletion_probability, output_file_name);
 
+	} else if(!strcmp(argv[1], MERGE_SUMS)){
+		// Merges the partial sums of the shards from the denominators, denominators_delta and rate commands. The result
+		//    does not depend on how the transmitted codewords were split between the shards.
+		if (argc < 5)
+		{
+			fprintf(stderr, "Usage %s %s output_file log_dens input_file [input_file ...]\n", argv[0], argv[1]);
+			exit(1);
+		}
+		const char* output_file_name = argv[2];
+		bool log_dens = atoi(argv[3]);
+		std::vector<const char*> input_file_names(argv + 4, argv + argc);
+		merge_sums(output_file_name, log_dens, input_file_names);
+	} else if(!strcmp(argv[1], PLAN_RESOURCES)){
+		// Predicts the memory and runtime of a BAA run and recommends how to execute it.
+		// Exits with an error code if the configuration cannot run on this node.
+		if (argc < 5 or argc > 7)
+		{
+			fprintf(stderr, "Usage %s %s input_len output_len up_to [num_workers] [memory_budget_mb]\n", argv[0], argv[1]);
+			exit(1);
+		}
+		size_t input_len = atol(argv[2]);
+		size_t output_len = atol(argv[3]);
+		bool up_to = atoi(argv[4]);
+		size_t num_workers = (argc > 5) ? atol(argv[5]) : 0;
+		size_t memory_budget = (argc > 6) ? atol(argv[6]) * 1024UL * 1024UL : 0;
+
+		ResourcePlan plan = plan_baa_resources(input_len, output_len, up_to, num_workers, memory_budget);
+		print_resource_plan(stdout, plan);
+		if (plan.strategy == STRATEGY_IMPOSSIBLE)
+		{
+			fprintf(stderr, "Refusing to run: %s.\n", plan.refusal_reason);
+			exit(4);
+		}
+	} else if(!strcmp(argv[1], ESTIMATE_RATE_MONTE_CARLO)){
+		// Estimates the rate of a Markov input distribution by sampling, for block lengths that are too long to enumerate.
+		// The output file holds (rate, standard_error, half_width, num_samples, converged), with the rate in nats.
+		if (argc != 14)
+		{
+			fprintf(stderr, 
+				"Usage %s %s input_len output_len up_to deletion_probability first_one_prob zero_to_one_prob one_to_zero_prob target_half_width max_samples seed num_threads output_file\n", 
+				argv[0], argv[1]);
+			exit(1);
+		}
+		size_t input_len = atol(argv[2]);
+		size_t output_len = atol(argv[3]);
+		bool up_to = atoi(argv[4]);
+		Float deletion_probability = atof(argv[5]);
+		MarkovInputDistribution Q = {atof(argv[6]), atof(argv[7]), atof(argv[8])};
+		MonteCarloRateOptions options;
+		options.target_half_width = atof(argv[9]);
+		options.max_samples = atol(argv[10]);
+		options.seed = strtoull(argv[11], NULL, 10);
+		options.num_threads = atol(argv[12]);
+		const char* output_file_name = argv[13];
+
+		estimate_rate(input_len, output_len, up_to, deletion_probability, Q, options, output_file_name);
+	} else if(!strcmp(argv[1], SIMULATE_CHANNEL)){
+		if (argc != 10)
+		{
+			fprintf(stderr, 
+				"Usage %s %s transmitted_codewords_file deletion_probability input_len output_len up_to samples_per_codeword seed output_file\n", 
+				argv[0], argv[1]);
+			exit(1);
+		}
+		const char* transmitted_codewords_filename = argv[2];
+		Float deletion_probability = atof(argv[3]);
+		size_t input_len = atol(argv[4]);
+		size_t output_len = atol(argv[5]);
+		bool up_to = atoi(argv[6]);
+		size_t samples_per_codeword = atol(argv[7]);
+		uint64_t seed = strtoull(argv[8], NULL, 10);
+		const char* output_file_name = argv[9];
+
+		simulate_channel(transmitted_codewords_filename, deletion_probability, input_len, output_len, up_to,
+			samples_per_codeword, seed, output_file_name);
+	} else if(!strcmp(argv[1], DUAL_BOUND)){
+		// Upper bounds the capacity by max_t D(P_t || R) for a candidate output distribution R, without running the BAA.
+		if (argc != 12)
+		{
+			fprintf(stderr, 
+				"Usage %s %s transmitted_codewords_file received_codewords_file R_array_file deletion_probability input_len output_len up_to num_maximisers num_threads output_file\n", 
+				argv[0], argv[1]);
+			exit(1);
+		}
+		const char* transmitted_codewords_filename = argv[2];
+		const char* received_codewords_filename = argv[3];
+		const char* R_array_filename = argv[4];
+		Float deletion_probability = atof(argv[5]);
+		size_t input_len = atol(argv[6]);
+		size_t output_len = atol(argv[7]);
+		bool up_to = atoi(argv[8]);
+		size_t num_maximisers = atol(argv[9]);
+		size_t num_threads = atol(argv[10]);
+		const char* output_file_name = argv[11];
+
+		evaluate_dual_bound(transmitted_codewords_filename, received_codewords_filename, R_array_filename,
+			deletion_probability, input_len, output_len, up_to, num_maximisers, num_threads, output_file_name);
+	} else if(!strcmp(argv[1], CERTIFY)){
+		// Evaluates the final rate and dual bound of a distribution with interval arithmetic, for the published bounds.
+		if (argc != 11)
+		{
+			fprintf(stderr, 
+				"Usage %s %s transmitted_codewords_file received_codewords_file Q_array_file deletion_probability input_len output_len up_to num_threads output_file\n", 
+				argv[0], argv[1]);
+			exit(1);
+		}
+		const char* transmitted_codewords_filename = argv[2];
+		const char* received_codewords_filename = argv[3];
+		const char* Q_array_filename = argv[4];
+		Float deletion_probability = atof(argv[5]);
+		size_t input_len = atol(argv[6]);
+		size_t output_len = atol(argv[7]);
+		bool up_to = atoi(argv[8]);
+		size_t num_threads = atol(argv[9]);
+		const char* output_file_name = argv[10];
+
+		certify(transmitted_codewords_filename, received_codewords_filename, Q_array_filename, deletion_probability,
+			input_len, output_len, up_to, num_threads, output_file_name);
 	} else{
 		fprintf(stderr, "Unknown command %s.\n", argv[1]);
-		fprintf(stderr, "Try running with %s %s %s or %s instead.\n", 
-			GENERATE_CODEWORDS, COMPUTE_DENOMS, COMPUTE_ALPHAS, COMPUTE_RATE);
+		fprintf(stderr, "Try running with %s %s %s %s %s %s %s %s %s or %s instead.\n", 
+			GENERATE_CODEWORDS, COMPUTE_DENOMS, COMPUTE_DENOMS_DELTA, COMPUTE_ALPHAS, COMPUTE_RATE, PLAN_RESOURCES,
+			ESTIMATE_RATE_MONTE_CARLO, SIMULATE_CHANNEL, DUAL_BOUND, CERTIFY);
 		exit(3);
 	}
+	if (perf_stats_filename != NULL)
+	{
+		report_perf_stats(perf_stats_filename, argv[1]);
+	}
+	release_transition_caches();
+	release_engine_arena();
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,270 @@
+#pragma once
+#include "utils.h"
+#include "bit_channel.h"
+#include <cassert>
+#include <cstdint>
+
+
+/*
+Codewords of any width, for evaluations at block lengths beyond the 64 bits of EfficientBitCodeWord (Monte Carlo,
+	parametric distributions). The word type is one of uint64_t, unsigned __int128 or MultiWord<N>, and the helpers
+	below (masks, bits, popcounts) are overloaded for all of them.
+The BAA engine keeps using EfficientBitCodeWord, whose layout is that of the codeword files, so the 64 bit path does not
+	change. As there, the first bit of a codeword is its most significant one.
+*/
+
+
+/*
+An unsigned integer of N 64 bit words, words[0] being the least significant one.
+*/
+template <size_t N>
+struct MultiWord
+{
+	static_assert(N > 0, "A MultiWord has at least one word");
+	uint64_t words[N];
+
+	constexpr MultiWord() : words{} {}
+	constexpr MultiWord(uint64_t x) : words{x} {}
+
+	friend MultiWord operator~ (const MultiWord& a){
+		MultiWord res;
+		for (size_t i = 0; i < N; ++i)
+		{
+			res.words[i] = ~a.words[i];
+		}
+		return res;
+	}
+	friend MultiWord operator& (const MultiWord& a, const MultiWord& b){
+		MultiWord res;
+		for (size_t i = 0; i < N; ++i)
+		{
+			res.words[i] = a.words[i] & b.words[i];
+		}
+		return res;
+	}
+	friend MultiWord operator| (const MultiWord& a, const MultiWord& b){
+		MultiWord res;
+		for (size_t i = 0; i < N; ++i)
+		{
+			res.words[i] = a.words[i] | b.words[i];
+		}
+		return res;
+	}
+	friend MultiWord operator^ (const MultiWord& a, const MultiWord& b){
+		MultiWord res;
+		for (size_t i = 0; i < N; ++i)
+		{
+			res.words[i] = a.words[i] ^ b.words[i];
+		}
+		return res;
+	}
+	// Shifts by 64 * N bits or more give 0.
+	friend MultiWord operator<< (const MultiWord& a, size_t shift){
+		MultiWord res;
+		size_t word_shift = shift / 64;
+		size_t bit_shift = shift % 64;
+		for (size_t i = word_shift; i < N; ++i)
+		{
+			res.words[i] = a.words[i - word_shift] << bit_shift;
+			if (bit_shift != 0 and i > word_shift)
+			{
+				res.words[i] |= a.words[i - word_shift - 1] >> (64 - bit_shift);
+			}
+		}
+		return res;
+	}
+	friend MultiWord operator>> (const MultiWord& a, size_t shift){
+		MultiWord res;
+		size_t word_shift = shift / 64;
+		size_t bit_shift = shift % 64;
+		for (size_t i = 0; i + word_shift < N; ++i)
+		{
+			res.words[i] = a.words[i + word_shift] >> bit_shift;
+			if (bit_shift != 0 and i + word_shift + 1 < N)
+			{
+				res.words[i] |= a.words[i + word_shift + 1] << (64 - bit_shift);
+			}
+		}
+		return res;
+	}
+	friend bool operator== (const MultiWord& a, const MultiWord& b){
+		for (size_t i = 0; i < N; ++i)
+		{
+			if (a.words[i] != b.words[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	friend bool operator!= (const MultiWord& a, const MultiWord& b){
+		return not (a == b);
+	}
+	friend bool operator< (const MultiWord& a, const MultiWord& b){
+		for (size_t i = N; i-- > 0;)
+		{
+			if (a.words[i] != b.words[i])
+			{
+				return a.words[i] < b.words[i];
+			}
+		}
+		return false;
+	}
+};
+
+
+template <typename Word>
+struct BitWordTraits;
+
+template <>
+struct BitWordTraits<uint64_t>
+{
+	static constexpr size_t BITS = 64;
+};
+
+template <>
+struct BitWordTraits<unsigned __int128>
+{
+	static constexpr size_t BITS = 128;
+};
+
+template <size_t N>
+struct BitWordTraits<MultiWord<N> >
+{
+	static constexpr size_t BITS = 64 * N;
+};
+
+
+/*
+The least significant 64 bits of a word.
+*/
+inline uint64_t low_word(uint64_t word){
+	return word;
+}
+
+inline uint64_t low_word(unsigned __int128 word){
+	return (uint64_t) word;
+}
+
+template <size_t N>
+inline uint64_t low_word(const MultiWord<N>& word){
+	return word.words[0];
+}
+
+
+inline size_t word_popcount(uint64_t word){
+	return __builtin_popcountll(word);
+}
+
+inline size_t word_popcount(unsigned __int128 word){
+	return __builtin_popcountll((uint64_t) word) + __builtin_popcountll((uint64_t) (word >> 64));
+}
+
+template <size_t N>
+inline size_t word_popcount(const MultiWord<N>& word){
+	size_t res = 0;
+	for (size_t i = 0; i < N; ++i)
+	{
+		res += __builtin_popcountll(word.words[i]);
+	}
+	return res;
+}
+
+
+/*
+The mask of the len least significant bits. Unlike (1 << len) - 1, this is also right for len = 0 and for the full width.
+*/
+template <typename Word>
+inline Word low_bits_mask(size_t len){
+	assert(len <= BitWordTraits<Word>::BITS);
+	return (len == 0) ? Word(0) : (~Word(0)) >> (BitWordTraits<Word>::BITS - len);
+}
+
+
+/*
+A codeword of at most BitWordTraits<Word>::BITS bits.
+*/
+template <typename Word>
+struct BasicBitCodeWord
+{
+	Word num;
+	size_t len;
+
+	inline BasicBitCodeWord() : num(0), len(0) {}
+	inline BasicBitCodeWord(const Word& n, size_t l) : num(n), len(l) {
+		assert(l <= BitWordTraits<Word>::BITS);
+	}
+	inline explicit BasicBitCodeWord(const EfficientBitCodeWord& word) : num(Word(word.num)), len(word.len) {}
+
+	/*
+	The i'th bit of the codeword (the first bit being the most significant one).
+	*/
+	inline size_t bit(size_t i) const{
+		return low_word(num >> (len - 1 - i)) & 1;
+	}
+
+	/*
+	Splits the codeword after its first prefix_len bits (the prefix and the suffix of the split cache kernels).
+	The empty prefix is special cased, as shifting a full width word by its width is undefined.
+	*/
+	inline BasicBitCodeWord prefix(size_t prefix_len) const{
+		return (prefix_len == 0) ? BasicBitCodeWord() : BasicBitCodeWord(num >> (len - prefix_len), prefix_len);
+	}
+	inline BasicBitCodeWord suffix(size_t prefix_len) const{
+		return BasicBitCodeWord(num & low_bits_mask<Word>(len - prefix_len), len - prefix_len);
+	}
+
+	inline size_t weight() const{
+		return word_popcount(num);
+	}
+
+	/*
+	The complement of every bit of the codeword (the NOT symmetry). Unlike ~EfficientBitCodeWord, the bits above len stay 0.
+	*/
+	friend BasicBitCodeWord operator~ (const BasicBitCodeWord& a){
+		return BasicBitCodeWord((~a.num) & low_bits_mask<Word>(a.len), a.len);
+	}
+
+	friend bool operator== (const BasicBitCodeWord& a, const BasicBitCodeWord& b){
+		return a.len == b.len and a.num == b.num;
+	}
+};
+
+typedef BasicBitCodeWord<unsigned __int128> BitCodeWord128;
+typedef BasicBitCodeWord<MultiWord<4> > BitCodeWord256;
+
+// The widest codewords that the templates are instantiated for.
+constexpr size_t MAX_WIDE_WORD_LEN = BitWordTraits<MultiWord<4> >::BITS;
+
+
+/*
+The number of ways the transmitted codeword can be transformed into the received one (see get_num_transition_possibilities).
+The count is kept in floating point, as it takes up to len(transmitted) bits: it is exact as long as it is below 2^53,
+	and within a relative error of about len(transmitted) ulps beyond that (up to about 1000 bits, where it overflows).
+*/
+template <typename Word>
+inline Float count_transitions_wide(const BasicBitCodeWord<Word>& transmitted, const BasicBitCodeWord<Word>& received){
+	size_t n = transmitted.len;
+	size_t k = received.len;
+	if (k > n)
+	{
+		return 0.0;
+	}
+	// ways[j] is the number of ways to produce the first j received bits from the transmitted bits seen so far.
+	std::vector<Float> ways(k + 1, 0.0);
+	ways[0] = 1.0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		size_t t = transmitted.bit(i);
+		// Only the received prefixes that the remaining transmitted bits can still complete matter.
+		size_t low = (k + i >= n) ? k + i - n : 0;
+		for (size_t j = std::min(i + 1, k); j > low; --j)
+		{
+			if (received.bit(j - 1) == t)
+			{
+				ways[j] += ways[j - 1];
+			}
+		}
+	}
+	return ways[k];
+}
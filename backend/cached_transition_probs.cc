@@ -1,13 +1,47 @@
 #include "cached_transition_probs.h"
 #include "cache_io.h"
 #include <cassert>
+#include <mutex>
 
-std::array<std::array<std::vector<Int>, MAX_BIT_CACHE_SIZE>, MAX_BIT_CACHE_SIZE> cached_transition_probs;
+TransitionCacheTables cached_transition_probs;
+static std::mutex _cache_load_mutex;
 
 void load_transition_cache(size_t n, size_t k){
 	assert(n < MAX_BIT_CACHE_SIZE);
 	assert(k < MAX_BIT_CACHE_SIZE);
+	std::lock_guard<std::mutex> lock(_cache_load_mutex);
+	if (not cached_transition_probs[n][k].empty())
+	{
+		// The tables never change, and the arena would not get the memory of the old copy back.
+		return;
+	}
 
-	cached_transition_probs[n][k] = load_data_from_cache_file(n, k);
+	// Read the file straight into a table of the right size, as every reallocation would leave a hole in the arena.
+	std::string filename = get_cache_filename(n, k);
+	FILE* cache_file = try_to_open_file(filename.data(), "rb");
+	fseek(cache_file, 0, SEEK_END);
+	size_t size = ftell(cache_file) / sizeof(Int);
+	fseek(cache_file, 0, SEEK_SET);
+	CacheTable table(size);
+	size_t num_read = fread(table.data(), sizeof(Int), size, cache_file);
+	fclose(cache_file);
+	if (num_read != size)
+	{
+		fprintf(stderr, "Failed to read the transition cache %s.\n", filename.data());
+		exit(1);
+	}
+	cached_transition_probs[n][k] = std::move(table);
 	// printf("Loaded cache %lu, %lu. It is now of length %lu.\n", n, k, cached_transition_probs[n][k].size());
+}
+
+
+void release_transition_caches(){
+	std::lock_guard<std::mutex> lock(_cache_load_mutex);
+	for (auto& row : cached_transition_probs)
+	{
+		for (auto& table : row)
+		{
+			CacheTable().swap(table);
+		}
+	}
 }
\ No newline at end of file
@@ -1,23 +1,34 @@
 #pragma once
 #include <array>
 #include "utils.h"
+#include "arena_allocator.h"
 
 
 constexpr size_t MAX_BIT_CACHE_SIZE = 40;
-extern std::array<std::array<std::vector<Int>, MAX_BIT_CACHE_SIZE>, MAX_BIT_CACHE_SIZE> cached_transition_probs;
+// The tables are looked up at random, so they are kept in the (huge page backed) engine arena to save on TLB misses.
+typedef ArenaVector<Int> CacheTable;
+typedef std::array<std::array<CacheTable, MAX_BIT_CACHE_SIZE>, MAX_BIT_CACHE_SIZE> TransitionCacheTables;
+// The tables of the whole process. A loaded table never changes, so the channel contexts of all configurations share them.
+extern TransitionCacheTables cached_transition_probs;
 
 /*
 Loads the transition cache from words of length n to works of length k.
+Safe to call from several threads (every table is loaded once).
 */
 void load_transition_cache(size_t n, size_t k);
 
+/*
+Drops all of the loaded transition caches (their memory goes back with release_engine_arena).
+*/
+void release_transition_caches();
+
 /*
 Returns the number of transitions from a word of length n and bitwise representation trans_num to
 	a word of length k and bitwise representation rec_num
 */
 inline size_t get_transition_count_cache(size_t n, size_t trans_num, size_t k, size_t rec_num){
 	// printf("get_transition_count_cache(%lu, %lu, %lu, %lu)\n", n, trans_num, k, rec_num); fflush(stdout);
-	const std::vector<Int>& cache = cached_transition_probs[n][k];
+	const CacheTable& cache = cached_transition_probs[n][k];
 	// printf("cache.size() = %lu\n", cache.size()); fflush(stdout);
 	size_t index = (trans_num << k) ^ rec_num;
 	return cache[index];
@@ -0,0 +1,188 @@
+#include "certified_rate.h"
+#include "numa_placement.h"
+#include "vector_kernels.h"
+#include <unistd.h>
+
+// The rows of the second pass are handed to the threads in blocks of consecutive codewords, which share the split cache
+// 	rows of their first halves.
+constexpr size_t CERTIFIED_ROW_BLOCK_SIZE = 64;
+
+
+/*
+Writes the exact transition counts from the transmitted codeword to the received codewords [begin, end) to out.
+*/
+static void compute_count_range(const EfficientBitCodeWord& transmitted, const std::vector<EfficientBitCodeWord>& received,
+	size_t begin, size_t end, Float* out){
+	// The received codewords are sorted by length, so the range is made of runs of codewords of the same length.
+	for (size_t start = begin, run_end = begin; start < end; start = run_end)
+	{
+		size_t k = received[start].len;
+		for (run_end = start + 1; run_end < end and received[run_end].len == k; ++run_end);
+		if (k > transmitted.len)
+		{
+			std::fill(out + (start - begin), out + (run_end - begin), 0.0);
+			continue;
+		}
+		combine_split_cache_row(transmitted, received.data() + start, run_end - start, 1.0, out + (start - begin));
+	}
+}
+
+
+static uint64_t exact_binomial(size_t n, size_t k){
+	uint64_t res = 1;
+	for (size_t i = 1; i <= k; ++i)
+	{
+		res = (uint64_t) (((unsigned __int128) res * (n - k + i)) / i);
+	}
+	return res;
+}
+
+
+Interval certified_normalization_factor(const ChannelContext& channel, size_t n, size_t k){
+	assert(n <= MAX_CERTIFIED_LEN);
+	if (k > n or k > channel.out_len() or (not channel.up_to() and k != channel.out_len()))
+	{
+		return exact_interval(0.0);
+	}
+	if (not channel.up_to())
+	{
+		return interval_div_positive(exact_interval(1.0), exact_interval((Float) exact_binomial(n, k)));
+	}
+	// The probability of every single way of keeping k' bits is d^(n - k') (1 - d)^k', normalized over k' <= out_len.
+	Interval deletion = exact_interval(channel.deletion_prob());
+	Interval keep = interval_sub(exact_interval(1.0), deletion);
+	keep.lo = std::max(0.0, keep.lo);
+	auto way_prob = [&](size_t kept){
+		Interval res = exact_interval(1.0);
+		for (size_t i = 0; i < n - kept; ++i)
+		{
+			res = interval_mul_nonnegative(res, deletion);
+		}
+		for (size_t i = 0; i < kept; ++i)
+		{
+			res = interval_mul_nonnegative(res, keep);
+		}
+		return res;
+	};
+	Interval total = exact_interval(0.0);
+	for (size_t kept = 0; kept <= std::min(n, channel.out_len()); ++kept)
+	{
+		total = interval_add(total, interval_mul_nonnegative(exact_interval((Float) exact_binomial(n, kept)), way_prob(kept)));
+	}
+	Interval res = interval_div_positive(way_prob(k), total);
+	res.lo = std::max(0.0, res.lo);
+	return res;
+}
+
+
+CertifiedEvaluation certify_rate(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted,
+	const std::vector<EfficientBitCodeWord>& received, const std::vector<Float>& Q, size_t num_threads){
+	size_t n = channel.in_len();
+	size_t num_transmitted = transmitted.size();
+	size_t num_received = received.size();
+	assert(n <= MAX_CERTIFIED_LEN);
+	assert(Q.size() == num_transmitted and num_received % 2 == 0);
+	for (const auto& word : transmitted)
+	{
+		assert(word.len == n);
+	}
+	if (num_threads == 0)
+	{
+		num_threads = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+	}
+
+	// Q, normalized.
+	Interval Q_total = exact_interval(0.0);
+	for (Float q : Q)
+	{
+		assert(q >= 0);
+		Q_total = interval_add(Q_total, exact_interval(q));
+	}
+	std::vector<Interval> Q_hat(num_transmitted, exact_interval(0.0));
+	std::vector<size_t> support;
+	for (size_t i = 0; i < num_transmitted; ++i)
+	{
+		if (Q[i] > 0)
+		{
+			Q_hat[i] = interval_div_positive(exact_interval(Q[i]), Q_total);
+			Q_hat[i].lo = std::max(0.0, Q_hat[i].lo);
+			support.push_back(i);
+		}
+	}
+
+	// The denominators (as sums of counts), a slice of the received codewords per task, so that every sum is taken in
+	// 	the order of the transmitted codewords whatever the number of threads.
+	std::vector<Float> den_lo(num_received, 0.0);
+	std::vector<Float> den_hi(num_received, 0.0);
+	size_t num_slices = std::min(num_received / 2, 4 * num_threads);
+	auto slice_begin = [&](size_t slice){
+		return 2 * ((num_received / 2) * slice / num_slices);
+	};
+	run_parallel_tasks(num_threads, num_slices, [&](size_t slice){
+		size_t begin = slice_begin(slice);
+		size_t end = slice_begin(slice + 1);
+		std::vector<Float> counts(end - begin);
+		for (size_t i : support)
+		{
+			compute_count_range(transmitted[i], received, begin, end, counts.data());
+			accumulate_interval_den(Q_hat[i].lo, Q_hat[i].hi, counts.data(), den_lo.data() + begin, den_hi.data() + begin, end - begin);
+		}
+	});
+
+	// -log of the denominators, averaged over the complement pairs.
+	std::vector<Float> A_lo(num_received);
+	std::vector<Float> A_hi(num_received);
+	for (size_t j = 0; j < num_received; j += 2)
+	{
+		Interval pair_sum = interval_add({den_lo[j], den_hi[j]}, {den_lo[j + 1], den_hi[j + 1]});
+		Interval log_average = interval_log({std::max(0.0, round_down(pair_sum.lo * 0.5)), round_up(pair_sum.hi * 0.5)});
+		A_lo[j] = A_lo[j + 1] = -log_average.hi;
+		A_hi[j] = A_hi[j + 1] = -log_average.lo;
+	}
+
+	// D(P_t || W) for every transmitted codeword.
+	std::vector<Interval> factors(channel.out_len() + 1);
+	for (size_t k = 0; k <= channel.out_len(); ++k)
+	{
+		factors[k] = certified_normalization_factor(channel, n, k);
+	}
+	std::vector<Interval> divergences(num_transmitted);
+	size_t num_blocks = (num_transmitted + CERTIFIED_ROW_BLOCK_SIZE - 1) / CERTIFIED_ROW_BLOCK_SIZE;
+	run_parallel_tasks(num_threads, num_blocks, [&](size_t block){
+		std::vector<Float> counts(num_received);
+		for (size_t i = block * CERTIFIED_ROW_BLOCK_SIZE; i < std::min(num_transmitted, (block + 1) * CERTIFIED_ROW_BLOCK_SIZE); ++i)
+		{
+			compute_count_range(transmitted[i], received, 0, num_received, counts.data());
+			Interval divergence = exact_interval(0.0);
+			for (size_t start = 0, run_end = 0; start < num_received; start = run_end)
+			{
+				size_t k = received[start].len;
+				for (run_end = start + 1; run_end < num_received and received[run_end].len == k; ++run_end);
+				Interval run_sum = exact_interval(0.0);
+				accumulate_interval_divergence(counts.data() + start, A_lo.data() + start, A_hi.data() + start,
+					run_end - start, &run_sum.lo, &run_sum.hi);
+				divergence = interval_add(divergence, interval_mul(factors[k], run_sum));
+			}
+			divergences[i] = divergence;
+		}
+	});
+
+	CertifiedEvaluation res;
+	res.rate = exact_interval(0.0);
+	for (size_t i : support)
+	{
+		res.rate = interval_add(res.rate, interval_mul(Q_hat[i], divergences[i]));
+	}
+	res.maximiser = 0;
+	res.max_divergence = divergences[0];
+	for (size_t i = 1; i < num_transmitted; ++i)
+	{
+		if (divergences[i].hi > res.max_divergence.hi)
+		{
+			res.maximiser = i;
+		}
+		res.max_divergence.lo = std::max(res.max_divergence.lo, divergences[i].lo);
+		res.max_divergence.hi = std::max(res.max_divergence.hi, divergences[i].hi);
+	}
+	return res;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "utils.h"
+#include "bit_channel.h"
+#include "interval_arithmetic.h"
+
+
+/*
+A certified evaluation of the final distribution of a BAA run, for the bounds that get published.
+The regular passes sum billions of doubles and drop the entries below ad-hoc thresholds (P_jk < 1E-12 in the alphas,
+	< 1E-30 in compute_rate, denominators clamped at 1E-50). Here every quantity is an interval that provably contains
+	the exact value (see interval_arithmetic.h):
+	- The transition counts are exact integers (up to 2^53, hence in_len <= MAX_CERTIFIED_LEN).
+	- The normalization factors are recomputed in interval arithmetic from the deletion probability, which defines the
+		channel.
+	- Q is normalized to sum to exactly 1 (as an interval).
+	- No entry is dropped: the only entries that are skipped are the zero counts, which contribute exactly 0.
+	log P_jk - log W_j = log count_jk - log sum_i Q_i count_ij, as the normalization factor cancels out, so the logs are
+	taken of exact counts and of the interval sums of counts.
+The rate of Q is a lower bound on the capacity of the (in_len, out_len) channel, and max_t D(P_t || W) an upper bound on
+	it (W, the output distribution of Q, being averaged over the complement pairs as in the BAA), so the capacity is
+	certified to lie in [rate.lo, max_divergence.hi], in nats.
+Both come out of the two passes of a BAA step over the table (one for the denominators, one for the rows), vectorized
+	and spread over the threads. The intervals are the same for every number of threads.
+*/
+constexpr size_t MAX_CERTIFIED_LEN = 53;
+
+struct CertifiedEvaluation
+{
+	// I(Q; W) of the transmitted distribution Q (normalized), in nats.
+	Interval rate;
+	// max_t D(P_t || W) over the transmitted codewords (and their complements), in nats.
+	Interval max_divergence;
+	// The transmitted codeword with the largest upper end of the divergence.
+	size_t maximiser;
+};
+
+/*
+The normalization factor of (n, k) of the channel (see ChannelContext::normalization_factor).
+*/
+Interval certified_normalization_factor(const ChannelContext& channel, size_t n, size_t k);
+
+/*
+Certifies the rate and the dual bound of Q, a distribution on the transmitted codewords (reduced by the NOT symmetry, as
+	in the BAA). The received alphabet is sorted by length, with the complement pairs adjacent.
+num_threads = 0 means all of the online cores.
+*/
+CertifiedEvaluation certify_rate(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted,
+	const std::vector<EfficientBitCodeWord>& received, const std::vector<Float>& Q, size_t num_threads = 0);
@@ -0,0 +1,183 @@
+#include "channel_context.h"
+#include "bit_channel.h"
+#include "perf_counters.h"
+#include "numa_placement.h"
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <numeric>
+
+
+/*
+log(base^exponent), where 0^0 = 1.
+*/
+static Float log_power(Float base, size_t exponent){
+	return (exponent == 0) ? 0.0 : exponent * log(base);
+}
+
+/*
+The log of the binomial coefficient. Uses lgamma_r, as lgamma writes the global signgam and the contexts are built from
+	several threads.
+*/
+static Float log_binomial(size_t n, size_t k){
+	int sign;
+	return lgamma_r(n + 1.0, &sign) - lgamma_r(k + 1.0, &sign) - lgamma_r(n - k + 1.0, &sign);
+}
+
+
+ChannelContext::ChannelContext(Float deletion_prob, size_t in_len, size_t out_len, bool up_to, bool load_cache) :
+	_deletion_prob(deletion_prob), _in_len(in_len), _out_len(out_len), _up_to(up_to), _cache_tables(&cached_transition_probs){
+	_normalization_factors.resize(in_len+1);
+	_log_normalization_factors.resize(in_len+1);
+	_normalization_factor_derivatives.resize(in_len+1);
+	for (size_t i_len = 0; i_len < in_len+1; ++i_len)
+	{
+		compute_normalization_factor_derivatives(i_len);
+		_normalization_factors[i_len].resize(out_len+1);
+		_log_normalization_factors[i_len].resize(out_len+1, -INFINITY);
+		if (i_len > MAX_EXACT_BINOMIAL_LEN)
+		{
+			compute_log_normalization_factors(i_len);
+			continue;
+		}
+		std::vector<Float> prob_out_len_k;
+		prob_out_len_k.resize(out_len+1);
+		prob_out_len_k[0] = pow(deletion_prob, i_len);
+		std::vector<size_t> num_out_len_k;
+		num_out_len_k.resize(out_len+1);
+		num_out_len_k[0] = 1;
+		for (size_t k = 1; k < out_len+1; ++k)
+		{
+			// The product may take more than 64 bits before it is divided.
+			num_out_len_k[k] = (size_t) (((unsigned __int128) (i_len - k + 1) * num_out_len_k[k-1]) / k);
+			if (up_to)
+			{
+				prob_out_len_k[k] = pow(deletion_prob, i_len-k) * pow(1 - deletion_prob, k);
+			}
+		}
+		if (not up_to)
+		{
+			_normalization_factors[i_len][out_len] = 1. / num_out_len_k[out_len];
+			_log_normalization_factors[i_len][out_len] = log(_normalization_factors[i_len][out_len]);
+			continue;
+		}
+		Float total = std::inner_product(num_out_len_k.begin(), num_out_len_k.end(), prob_out_len_k.begin(), 0.0);
+		for (size_t k = 0; k < out_len+1; ++k)
+		{
+			_normalization_factors[i_len][k] = prob_out_len_k[k] / total;
+			_log_normalization_factors[i_len][k] = log(_normalization_factors[i_len][k]);
+		}
+	}
+
+	if (load_cache)
+	{
+		ScopedPerfRegion perf_region(PERF_REGION_CACHE_LOAD);
+		// The tables are read-only and shared by all of the threads, place them according to BDC_NUMA_POLICY.
+		ScopedTablePlacement table_placement;
+		size_t n = in_len;
+		size_t k = out_len;
+		for (size_t n1 = 0; n1 <= (n+1)/2; ++n1)
+		{
+			for (size_t k1 = 0; k1 <= k; ++k1)
+			{
+				load_transition_cache(n1, k1);
+			}
+		}
+	}
+}
+
+
+void ChannelContext::compute_log_normalization_factors(size_t i_len){
+	std::vector<Float>& log_factors = _log_normalization_factors[i_len];
+	if (not _up_to)
+	{
+		if (_out_len <= i_len)
+		{
+			log_factors[_out_len] = -log_binomial(i_len, _out_len);
+		}
+	}
+	else{
+		// The binomial distribution of the number of kept bits, truncated to out_len and normalized by its total.
+		Float max_log_weight = -INFINITY;
+		for (size_t k = 0; k <= std::min(i_len, _out_len); ++k)
+		{
+			log_factors[k] = log_power(_deletion_prob, i_len - k) + log_power(1 - _deletion_prob, k);
+			max_log_weight = std::max(max_log_weight, log_binomial(i_len, k) + log_factors[k]);
+		}
+		Float total = 0.0;
+		for (size_t k = 0; k <= std::min(i_len, _out_len); ++k)
+		{
+			total += exp(log_binomial(i_len, k) + log_factors[k] - max_log_weight);
+		}
+		Float log_total = max_log_weight + log(total);
+		for (size_t k = 0; k <= std::min(i_len, _out_len); ++k)
+		{
+			log_factors[k] -= log_total;
+		}
+	}
+	for (size_t k = 0; k <= _out_len; ++k)
+	{
+		_normalization_factors[i_len][k] = exp(log_factors[k]);
+	}
+}
+
+
+void ChannelContext::compute_normalization_factor_derivatives(size_t i_len){
+	std::vector<std::pair<Float, Float> >& derivatives = _normalization_factor_derivatives[i_len];
+	derivatives.assign(_out_len+1, std::make_pair(0.0, 0.0));
+	if (not _up_to)
+	{
+		return;
+	}
+	Float d = _deletion_prob;
+	size_t max_k = std::min(i_len, _out_len);
+	if (d <= 0 or d >= 1)
+	{
+		// The factors are not differentiable in d at the ends.
+		for (size_t k = 0; k <= max_k; ++k)
+		{
+			derivatives[k] = std::make_pair(NAN, NAN);
+		}
+		return;
+	}
+	// f(n, k) = d^(n - k) (1 - d)^k / Z, where Z sums C(n, k') d^(n - k') (1 - d)^k' over k' <= out_len. So
+	// 	f' / f = (mu - k) / (d (1 - d)), with mu the mean of the number of kept bits k' in the truncated binomial
+	// 	distribution, and mu' = -var / (d (1 - d)).
+	std::vector<Float> log_weights(max_k + 1);
+	Float max_log_weight = -INFINITY;
+	for (size_t k = 0; k <= max_k; ++k)
+	{
+		log_weights[k] = log_binomial(i_len, k) + log_power(d, i_len - k) + log_power(1 - d, k);
+		max_log_weight = std::max(max_log_weight, log_weights[k]);
+	}
+	Float total = 0.0, mean = 0.0, second_moment = 0.0;
+	for (size_t k = 0; k <= max_k; ++k)
+	{
+		Float weight = exp(log_weights[k] - max_log_weight);
+		total += weight;
+		mean += weight * k;
+		second_moment += weight * k * k;
+	}
+	mean /= total;
+	Float variance = std::max(0.0, second_moment / total - mean * mean);
+	Float scale = d * (1 - d);
+	for (size_t k = 0; k <= max_k; ++k)
+	{
+		Float first = (mean - k) / scale;
+		Float first_derivative = -(variance + (mean - k) * (1 - 2 * d)) / (scale * scale);
+		derivatives[k] = std::make_pair(first, first_derivative + first * first);
+	}
+}
+
+
+static std::unique_ptr<ChannelContext> _default_channel_context;
+
+void initialize_bit_channel(Float deletion_prob, size_t in_len, size_t out_len, bool up_to, bool load_cache){
+	_default_channel_context.reset(new ChannelContext(deletion_prob, in_len, out_len, up_to, load_cache));
+}
+
+
+const ChannelContext& default_channel_context(){
+	assert(_default_channel_context != NULL);
+	return *_default_channel_context;
+}
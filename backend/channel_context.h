@@ -0,0 +1,97 @@
+#pragma once
+#include "utils.h"
+#include "cached_transition_probs.h"
+
+
+/*
+The normalization factors of transmitted codewords up to this length are computed from exact binomial coefficients, and
+	those of longer codewords in the log domain.
+*/
+constexpr size_t MAX_EXACT_BINOMIAL_LEN = 64;
+
+
+/*
+The state of the bit channel for one configuration (deletion probability, input length, output length and up_to).
+The engine functions take the context they run in, so that a single process can serve several configurations at once
+	(from several threads): a context is immutable once constructed, and the transition count tables, which do not
+	depend on the deletion probability, are loaded once per process and shared by reference by all of the contexts.
+*/
+class ChannelContext
+{
+public:
+	/*
+	Computes the normalization factors of the configuration and (unless load_cache is false) makes sure that the
+		transition count tables it needs are loaded.
+	Codewords longer than MAX_BIT_CACHE_SIZE have no tables, so contexts of wide codewords (see bit_words.h) are
+		constructed with load_cache = false.
+	*/
+	ChannelContext(Float deletion_prob, size_t in_len, size_t out_len, bool up_to, bool load_cache = true);
+
+	Float deletion_prob() const { return _deletion_prob; }
+	size_t in_len() const { return _in_len; }
+	size_t out_len() const { return _out_len; }
+	bool up_to() const { return _up_to; }
+
+	/*
+	The probability of every single way to receive a codeword of length k from a transmitted codeword of length n,
+		i.e. the transition probability is this factor times the number of ways.
+	*/
+	inline Float normalization_factor(size_t n, size_t k) const{
+		return _normalization_factors[n][k];
+	}
+
+	/*
+	The log of the normalization factor. Unlike the factor itself, this does not underflow for long codewords.
+	*/
+	inline Float log_normalization_factor(size_t n, size_t k) const{
+		return _log_normalization_factors[n][k];
+	}
+
+	/*
+	The derivatives of the normalization factor by the deletion probability, relative to the factor itself:
+		f'(n, k) / f(n, k) and f''(n, k) / f(n, k). As the transition probabilities are the factors times counts that do
+		not depend on d, these are all the d-dependence of the channel (see compute_bit_rate_derivative_sums).
+	Both are 0 when exactly out_len bits are kept, which does not depend on d.
+	*/
+	inline Float normalization_factor_log_derivative(size_t n, size_t k) const{
+		return _normalization_factor_derivatives[n][k].first;
+	}
+	inline Float normalization_factor_second_derivative_ratio(size_t n, size_t k) const{
+		return _normalization_factor_derivatives[n][k].second;
+	}
+
+	/*
+	The shared transition count tables (see cached_transition_probs.h).
+	*/
+	inline const CacheTable& cache_table(size_t n, size_t k) const{
+		return (*_cache_tables)[n][k];
+	}
+
+private:
+	/*
+	Computes the factors of the transmitted length i_len in the log domain, where the binomial coefficients do not fit
+		in 64 bits.
+	*/
+	void compute_log_normalization_factors(size_t i_len);
+
+	/*
+	Computes the derivatives of the factors of the transmitted length i_len (from the log factors).
+	*/
+	void compute_normalization_factor_derivatives(size_t i_len);
+
+	Float _deletion_prob;
+	size_t _in_len;
+	size_t _out_len;
+	bool _up_to;
+	std::vector<std::vector<Float> > _normalization_factors;
+	std::vector<std::vector<Float> > _log_normalization_factors;
+	std::vector<std::vector<std::pair<Float, Float> > > _normalization_factor_derivatives;
+	const TransitionCacheTables* _cache_tables;
+};
+
+
+/*
+The context set up by the last call to initialize_bit_channel, used by the functions that do not take a context (the
+	BitCodeWord engine and the tests). Must not be called before initialize_bit_channel.
+*/
+const ChannelContext& default_channel_context();
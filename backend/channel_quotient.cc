@@ -0,0 +1,214 @@
+#include "channel_quotient.h"
+#include "deletion_channel_simulator.h"
+#include "vector_kernels.h"
+#include <cassert>
+#include <numeric>
+
+// The counts do not depend on the deletion probability, the context only provides the cache tables.
+constexpr Float QUOTIENT_DELETION_PROB = 0.5;
+
+
+static uint64_t hash_counts(const std::vector<uint64_t>& counts){
+	uint64_t hash = counts.size();
+	for (uint64_t count : counts)
+	{
+		hash = splitmix64_finalize(hash ^ count) + 0x9E3779B97F4A7C15ULL;
+	}
+	return hash;
+}
+
+
+/*
+Numbers the classes of items with equal keys in the order of their first members. Only the items whose hashes collide
+	have their keys computed (again), so get_key is called about once per item that has company.
+*/
+template <typename GetKey>
+static std::vector<size_t> collapse_classes(const std::vector<uint64_t>& hashes, const GetKey& get_key){
+	std::vector<size_t> order(hashes.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](size_t i, size_t j){ return hashes[i] < hashes[j]; });
+
+	std::vector<size_t> first_member(hashes.size());
+	for (size_t begin = 0, end = 0; begin < order.size(); begin = end)
+	{
+		while (end < order.size() and hashes[order[end]] == hashes[order[begin]])
+		{
+			++end;
+		}
+		std::vector<std::pair<size_t, std::vector<uint64_t> > > representatives;
+		for (size_t i = begin; i < end; ++i)
+		{
+			size_t item = order[i];
+			first_member[item] = item;
+			if (end - begin == 1)
+			{
+				break;
+			}
+			auto key = get_key(item);
+			auto representative = std::find_if(representatives.begin(), representatives.end(),
+				[&](const std::pair<size_t, std::vector<uint64_t> >& rep){ return rep.second == key; });
+			if (representative == representatives.end())
+			{
+				representatives.push_back(std::make_pair(item, std::move(key)));
+			}
+			else{
+				first_member[item] = representative->first;
+			}
+		}
+	}
+
+	// The members of a class come after its first member, which was numbered by then.
+	std::vector<size_t> classes(hashes.size());
+	size_t num_classes = 0;
+	for (size_t item = 0; item < hashes.size(); ++item)
+	{
+		classes[item] = (first_member[item] == item) ? num_classes++ : classes[first_member[item]];
+	}
+	return classes;
+}
+
+
+ChannelQuotient compute_channel_quotient(const std::vector<EfficientBitCodeWord>& transmitted,
+	const std::vector<EfficientBitCodeWord>& received, size_t in_len, size_t out_len, bool up_to){
+	assert(received.size() % 2 == 0);
+	for (const auto& word : transmitted)
+	{
+		assert(word.len == in_len);
+	}
+	ChannelContext channel(QUOTIENT_DELETION_PROB, in_len, out_len, up_to);
+	CodewordBucketIndex received_index(received);
+	ChannelQuotient quotient;
+
+	// The rows.
+	auto row_counts = [&](size_t i){
+		std::vector<Float> row(received.size());
+		compute_transition_count_row_range(channel, transmitted[i], received, 0, received.size(), &received_index, row.data());
+		return std::vector<uint64_t>(row.begin(), row.end());
+	};
+	std::vector<uint64_t> row_hashes(transmitted.size());
+	for (size_t i = 0; i < transmitted.size(); ++i)
+	{
+		row_hashes[i] = hash_counts(row_counts(i));
+	}
+	quotient.transmitted_class = collapse_classes(row_hashes, row_counts);
+	for (size_t i = 0; i < transmitted.size(); ++i)
+	{
+		if (quotient.transmitted_class[i] == quotient.transmitted_representatives.size())
+		{
+			quotient.transmitted_representatives.push_back(transmitted[i]);
+			quotient.class_sizes.push_back(0);
+		}
+		++quotient.class_sizes[quotient.transmitted_class[i]];
+	}
+
+	// The columns of the (codeword, complement) pairs, divided by the gcd of their counts. The members of a class of
+	// 	transmitted codewords have the same entries in every column, so the representatives are enough.
+	CodewordBucketIndex transmitted_index(quotient.transmitted_representatives);
+	std::vector<uint64_t> column_gcds(received.size() / 2);
+	auto column_counts = [&](size_t pair){
+		std::vector<uint64_t> counts;
+		counts.reserve(2 * quotient.transmitted_representatives.size());
+		for (size_t j = 2 * pair; j < 2 * pair + 2; ++j)
+		{
+			for (Float count : compute_transition_count_col(channel, quotient.transmitted_representatives, received[j], &transmitted_index))
+			{
+				counts.push_back((uint64_t) count);
+			}
+		}
+		uint64_t gcd = 0;
+		for (uint64_t count : counts)
+		{
+			gcd = std::gcd(gcd, count);
+		}
+		column_gcds[pair] = gcd;
+		// The pairs that no transmitted codeword reaches are not merged with each other.
+		if (gcd == 0)
+		{
+			counts.push_back(pair);
+			return counts;
+		}
+		for (auto& count : counts)
+		{
+			count /= gcd;
+		}
+		return counts;
+	};
+	std::vector<uint64_t> column_hashes(received.size() / 2);
+	for (size_t pair = 0; pair < column_hashes.size(); ++pair)
+	{
+		column_hashes[pair] = hash_counts(column_counts(pair));
+	}
+	auto pair_classes = collapse_classes(column_hashes, column_counts);
+	std::vector<size_t> representative_pairs;
+	for (size_t pair = 0; pair < pair_classes.size(); ++pair)
+	{
+		if (pair_classes[pair] == representative_pairs.size())
+		{
+			representative_pairs.push_back(pair);
+			quotient.received_representatives.push_back(received[2 * pair]);
+			quotient.received_representatives.push_back(received[2 * pair + 1]);
+		}
+	}
+	quotient.received_class.resize(received.size());
+	quotient.received_count_ratio.resize(received.size());
+	for (size_t j = 0; j < received.size(); ++j)
+	{
+		size_t pair = j / 2;
+		size_t representative_pair = representative_pairs[pair_classes[pair]];
+		quotient.received_class[j] = (2 * pair_classes[pair]) + (j % 2);
+		quotient.received_count_ratio[j] = (pair == representative_pair) ? 1.0 :
+			(Float) column_gcds[pair] / column_gcds[representative_pair];
+	}
+	return quotient;
+}
+
+
+std::vector<Float> merge_transmitted_distribution(const ChannelQuotient& quotient, const std::vector<Float>& Q){
+	assert(Q.size() == quotient.transmitted_class.size());
+	std::vector<Float> Q_classes(quotient.transmitted_representatives.size(), 0.0);
+	for (size_t i = 0; i < Q.size(); ++i)
+	{
+		Q_classes[quotient.transmitted_class[i]] += Q[i];
+	}
+	return Q_classes;
+}
+
+
+std::vector<Float> expand_transmitted_distribution(const ChannelQuotient& quotient, const std::vector<Float>& Q_classes){
+	assert(Q_classes.size() == quotient.transmitted_representatives.size());
+	std::vector<Float> Q(quotient.transmitted_class.size());
+	for (size_t i = 0; i < Q.size(); ++i)
+	{
+		size_t c = quotient.transmitted_class[i];
+		Q[i] = Q_classes[c] / quotient.class_sizes[c];
+	}
+	return Q;
+}
+
+
+std::vector<Float> compute_quotient_log_Wjk_den(const ChannelContext& channel, const ChannelQuotient& quotient,
+	const std::vector<EfficientBitCodeWord>& received, const std::vector<Float>& Q_classes){
+	assert(received.size() == quotient.received_class.size());
+	auto representative_log_den = log_Wjk_den_from_sums(compute_all_Wjk_den_sums(channel, quotient.transmitted_representatives,
+		quotient.received_representatives, Q_classes));
+	size_t n = quotient.transmitted_representatives.front().len;
+	std::vector<Float> log_den(received.size());
+	for (size_t j = 0; j < received.size(); ++j)
+	{
+		size_t c = quotient.received_class[j];
+		// Exactly 0 for the representatives themselves.
+		Float log_ratio = log(quotient.received_count_ratio[j]) +
+			(channel.log_normalization_factor(n, received[j].len) - channel.log_normalization_factor(n, quotient.received_representatives[c].len));
+		log_den[j] = representative_log_den[c] + log_ratio;
+	}
+	return log_den;
+}
+
+
+std::vector<Float> do_quotient_baa_step(const ChannelContext& channel, const ChannelQuotient& quotient,
+	const std::vector<EfficientBitCodeWord>& received, const std::vector<Float>& Q_classes){
+	auto log_W_jk = compute_quotient_log_Wjk_den(channel, quotient, received, Q_classes);
+	auto log_alphas = compute_all_log_alpha_k(channel, quotient.transmitted_representatives, received, Q_classes, log_W_jk);
+	exp_normalize(log_alphas.data(), log_alphas.size());
+	return log_alphas;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "utils.h"
+#include "bit_baa_fast.h"
+
+
+/*
+Beyond the NOT symmetry, many transmitted codewords have identical rows of transition counts (whenever their multisets
+	of subsequences of the received lengths agree, which is common when the received codewords are much shorter), and
+	some received codewords may have proportional columns. Neither distinction matters to the capacity: the BAA on the
+	quotient channel, where every class of transmitted codewords is a single input (with the sum of their probabilities)
+	and every class of received codewords is a single output, follows the BAA on the whole channel exactly.
+The classes are found from the transition counts, so they only depend on the alphabets and not on the deletion probability.
+*/
+struct ChannelQuotient
+{
+	// The class of every transmitted codeword, and the first member and the number of members of every class.
+	std::vector<size_t> transmitted_class;
+	std::vector<EfficientBitCodeWord> transmitted_representatives;
+	std::vector<size_t> class_sizes;
+
+	// The received codewords are merged in (codeword, complement) pairs, as the denominators are averaged over the
+	// 	pairs (see log_Wjk_den_from_sums). The representative of every received codeword (as an index into
+	// 	received_representatives) and the ratio of its counts to those of the representative:
+	// 	count(t, received[j]) = received_count_ratio[j] * count(t, received_representatives[received_class[j]]).
+	std::vector<size_t> received_class;
+	std::vector<Float> received_count_ratio;
+	std::vector<EfficientBitCodeWord> received_representatives;
+};
+
+/*
+Hashes the rows and the columns of the transition counts from the transmitted codewords to the received ones and collapses
+	the equivalence classes (every collision of the hashes is checked against the counts themselves).
+Loads the cache tables of (in_len, out_len) and costs about as much as two passes over the transition table.
+*/
+ChannelQuotient compute_channel_quotient(const std::vector<EfficientBitCodeWord>& transmitted,
+	const std::vector<EfficientBitCodeWord>& received, size_t in_len, size_t out_len, bool up_to);
+
+/*
+The distribution on the classes of the transmitted codewords (the sum over the members), and back (spread evenly over the
+	members, which is where the BAA on the whole channel keeps them when it starts from the uniform distribution).
+*/
+std::vector<Float> merge_transmitted_distribution(const ChannelQuotient& quotient, const std::vector<Float>& Q);
+std::vector<Float> expand_transmitted_distribution(const ChannelQuotient& quotient, const std::vector<Float>& Q_classes);
+
+/*
+The log denominators of all of the received codewords, computed only for the representatives.
+*/
+std::vector<Float> compute_quotient_log_Wjk_den(const ChannelContext& channel, const ChannelQuotient& quotient,
+	const std::vector<EfficientBitCodeWord>& received, const std::vector<Float>& Q_classes);
+
+/*
+A BAA step (as do_full_baa_step) on the quotient channel, from and to distributions on the classes.
+*/
+std::vector<Float> do_quotient_baa_step(const ChannelContext& channel, const ChannelQuotient& quotient,
+	const std::vector<EfficientBitCodeWord>& received, const std::vector<Float>& Q_classes);
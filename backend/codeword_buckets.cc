@@ -0,0 +1,137 @@
+#include "codeword_buckets.h"
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+
+CodewordBucketIndex::CodewordBucketIndex(const std::vector<EfficientBitCodeWord>& alphabet){
+	size_t max_len = 0;
+	for (const auto& word : alphabet)
+	{
+		max_len = std::max(max_len, word.len);
+	}
+	typedef std::tuple<size_t, uint32_t, uint32_t, uint32_t, uint32_t> BucketKey;
+	std::map<BucketKey, size_t> bucket_sizes;
+	for (const auto& word : alphabet)
+	{
+		CodewordSignature signature = codeword_signature(word);
+		bucket_sizes[BucketKey(word.len, signature.weight, signature.runs, signature.first_bit, signature.last_bit)]++;
+	}
+
+	std::map<BucketKey, uint32_t> bucket_ids;
+	_length_buckets.assign(max_len + 2, 0);
+	for (const auto& entry : bucket_sizes)
+	{
+		const BucketKey& key = entry.first;
+		bucket_ids[key] = _buckets.size();
+		_buckets.push_back(CodewordBucket{std::get<0>(key),
+			CodewordSignature{std::get<1>(key), std::get<2>(key), std::get<3>(key), std::get<4>(key)}, entry.second});
+		_length_buckets[std::get<0>(key) + 1] = _buckets.size();
+	}
+
+	_length_positions.assign(max_len + 2, 0);
+	_bucket_of.reserve(alphabet.size());
+	for (size_t i = 0; i < alphabet.size(); ++i)
+	{
+		const auto& word = alphabet[i];
+		assert(i == 0 or alphabet[i - 1].len <= word.len);
+		CodewordSignature signature = codeword_signature(word);
+		_bucket_of.push_back(bucket_ids[BucketKey(word.len, signature.weight, signature.runs, signature.first_bit,
+			signature.last_bit)]);
+		_length_positions[word.len + 1] = i + 1;
+	}
+	// Lengths without codewords get empty ranges.
+	for (size_t len = 1; len < max_len + 2; ++len)
+	{
+		_length_buckets[len] = std::max(_length_buckets[len], _length_buckets[len - 1]);
+		_length_positions[len] = std::max(_length_positions[len], _length_positions[len - 1]);
+	}
+}
+
+
+size_t CodewordBucketIndex::collect_passing(size_t len, const std::vector<uint8_t>& bucket_passes, size_t num_passing,
+	std::vector<size_t>& out, size_t begin, size_t end) const{
+	size_t num_len = _length_positions[len + 1] - _length_positions[len];
+	begin = std::max(begin, _length_positions[len]);
+	end = std::min(end, _length_positions[len + 1]);
+	if (begin >= end)
+	{
+		return 0;
+	}
+	if (num_passing == 0)
+	{
+		// Whole lengths are skipped without a pass over their codewords.
+		return end - begin;
+	}
+	size_t num_out = out.size();
+	if (num_passing == num_len)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			out.push_back(i);
+		}
+		return end - begin;
+	}
+	out.resize(num_out + (end - begin));
+	for (size_t i = begin; i < end; ++i)
+	{
+		// Branch free compaction of the positions whose bucket passed.
+		out[num_out] = i;
+		num_out += bucket_passes[_bucket_of[i] - _length_buckets[len]];
+	}
+	out.resize(num_out);
+	return end - begin;
+}
+
+
+size_t CodewordBucketIndex::collect_reachable(const EfficientBitCodeWord& transmitted, size_t k, std::vector<size_t>& out,
+	size_t begin, size_t end) const{
+	if (k + 1 >= _length_positions.size())
+	{
+		return 0;
+	}
+	CodewordSignature trans_signature = codeword_signature(transmitted);
+	std::vector<uint8_t> bucket_passes(_length_buckets[k + 1] - _length_buckets[k]);
+	size_t num_passing = 0;
+	for (size_t b = 0; b < bucket_passes.size(); ++b)
+	{
+		const CodewordBucket& bucket = _buckets[_length_buckets[k] + b];
+		bucket_passes[b] = may_transition(trans_signature, transmitted.len, bucket.signature, k);
+		num_passing += bucket_passes[b] * bucket.size;
+	}
+	return collect_passing(k, bucket_passes, num_passing, out, begin, end);
+}
+
+
+size_t CodewordBucketIndex::count_reachable(const EfficientBitCodeWord& transmitted, size_t k) const{
+	if (k + 1 >= _length_positions.size())
+	{
+		return 0;
+	}
+	CodewordSignature trans_signature = codeword_signature(transmitted);
+	size_t num_passing = 0;
+	for (size_t b = _length_buckets[k]; b < _length_buckets[k + 1]; ++b)
+	{
+		num_passing += may_transition(trans_signature, transmitted.len, _buckets[b].signature, k) * _buckets[b].size;
+	}
+	return num_passing;
+}
+
+
+size_t CodewordBucketIndex::collect_sources(const EfficientBitCodeWord& received, size_t n, std::vector<size_t>& out,
+	size_t begin, size_t end) const{
+	if (n + 1 >= _length_positions.size())
+	{
+		return 0;
+	}
+	CodewordSignature rec_signature = codeword_signature(received);
+	std::vector<uint8_t> bucket_passes(_length_buckets[n + 1] - _length_buckets[n]);
+	size_t num_passing = 0;
+	for (size_t b = 0; b < bucket_passes.size(); ++b)
+	{
+		const CodewordBucket& bucket = _buckets[_length_buckets[n] + b];
+		bucket_passes[b] = may_transition(bucket.signature, n, rec_signature, received.len);
+		num_passing += bucket_passes[b] * bucket.size;
+	}
+	return collect_passing(n, bucket_passes, num_passing, out, begin, end);
+}
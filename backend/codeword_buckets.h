@@ -0,0 +1,111 @@
+#pragma once
+#include "utils.h"
+#include "bit_channel.h"
+
+
+/*
+Necessary conditions for a nonzero transition count. The received codeword is a subsequence of the transmitted one, so
+	it has at most as many ones, at most as many zeros and at most as many runs. Moreover, if its first bit differs from
+	the first bit of the transmitted codeword then the whole first run of the transmitted codeword was deleted (and the
+	same for the last bit), so every such mismatch costs a run.
+*/
+struct CodewordSignature
+{
+	uint32_t weight;
+	uint32_t runs;
+	// The first bit of the codeword (its most significant bit) and its last bit, 0 for the empty codeword.
+	uint32_t first_bit;
+	uint32_t last_bit;
+};
+
+inline CodewordSignature codeword_signature(const EfficientBitCodeWord& word){
+	if (word.len == 0)
+	{
+		return CodewordSignature{0, 0, 0, 0};
+	}
+	uint64_t adjacent_mask = (word.len >= 64) ? ~0ULL >> 1 : ((1ULL << (word.len - 1)) - 1);
+	return CodewordSignature{
+		(uint32_t) __builtin_popcountll(word.num),
+		(uint32_t) __builtin_popcountll((word.num ^ (word.num >> 1)) & adjacent_mask) + 1,
+		(uint32_t) ((word.num >> (word.len - 1)) & 1),
+		(uint32_t) (word.num & 1)
+	};
+}
+
+/*
+Returns false only if no transition from a transmitted codeword of length n to a received codeword of length k
+	is possible. Evaluated without branches, so that a batch of pairs can be filtered into a compact list.
+*/
+inline bool may_transition(const CodewordSignature& transmitted, size_t n, const CodewordSignature& received, size_t k){
+	uint32_t boundary_mismatches = (transmitted.first_bit ^ received.first_bit) + (transmitted.last_bit ^ received.last_bit);
+	return (k <= n) & (received.weight <= transmitted.weight) & (k - received.weight <= n - transmitted.weight)
+		& ((k == 0) | (received.runs + boundary_mismatches <= transmitted.runs));
+}
+
+
+/*
+The codewords of a given length and signature (weight, number of runs and boundary bits), so that the tests above
+	pass or fail for all of them together.
+*/
+struct CodewordBucket
+{
+	size_t len;
+	CodewordSignature signature;
+	size_t size;
+};
+
+/*
+Groups the codewords of an alphabet (sorted by length, as all of the alphabets of the engine are) into buckets by length
+	and signature, so that the row and column passes decide once per bucket which codewords can take part in a
+	transition, instead of testing every pair.
+The alphabet itself is not reordered (its order keeps the table lookups of neighbouring codewords close together):
+	every position remembers its bucket, and the positions that pass are collected in the order of the alphabet.
+*/
+class CodewordBucketIndex
+{
+public:
+	explicit CodewordBucketIndex(const std::vector<EfficientBitCodeWord>& alphabet);
+
+	/*
+	Appends the positions of the codewords of length k in the alphabet that may be received from the transmitted
+		codeword (a superset of the positions of the nonzero transition counts).
+	Only the positions in [begin, end) are considered. Returns the number of codewords of length k in that range, so
+		that the caller can tell whether anything was pruned.
+	*/
+	size_t collect_reachable(const EfficientBitCodeWord& transmitted, size_t k, std::vector<size_t>& out,
+		size_t begin = 0, size_t end = SIZE_MAX) const;
+
+	/*
+	The number of positions collect_reachable would append for the whole alphabet, computed from the sizes of the buckets
+		alone.
+	*/
+	size_t count_reachable(const EfficientBitCodeWord& transmitted, size_t k) const;
+
+	/*
+	Appends the positions of the codewords of length n in the alphabet that the received codeword may have been
+		transmitted from (among the positions in [begin, end)), and returns the number of codewords of length n there.
+	*/
+	size_t collect_sources(const EfficientBitCodeWord& received, size_t n, std::vector<size_t>& out,
+		size_t begin = 0, size_t end = SIZE_MAX) const;
+
+	size_t num_codewords(size_t len) const{
+		return (len + 1 < _length_positions.size()) ? _length_positions[len + 1] - _length_positions[len] : 0;
+	}
+	const std::vector<CodewordBucket>& buckets() const { return _buckets; }
+
+private:
+	/*
+	Appends the positions in [begin, end) of the codewords of length len whose bucket passed (bucket_passes is indexed
+		by the buckets of that length), and returns the number of codewords of length len in the range.
+	*/
+	size_t collect_passing(size_t len, const std::vector<uint8_t>& bucket_passes, size_t num_passing,
+		std::vector<size_t>& out, size_t begin, size_t end) const;
+
+	// Sorted by (len, weight, runs, first_bit, last_bit).
+	std::vector<CodewordBucket> _buckets;
+	// The buckets of the codewords of length len are _buckets[_length_buckets[len], _length_buckets[len + 1]), and
+	// 	their positions in the alphabet are [_length_positions[len], _length_positions[len + 1]).
+	std::vector<size_t> _length_buckets;
+	std::vector<size_t> _length_positions;
+	std::vector<uint32_t> _bucket_of;
+};
@@ -0,0 +1,197 @@
+#include "deletion_channel_simulator.h"
+#include <immintrin.h>
+
+// The draw indices used by the different parts of a sample, so that they never share a random word.
+constexpr uint64_t LENGTH_DRAW = SIMULATOR_PROB_BITS;
+constexpr uint64_t FIRST_SUBSET_DRAW = SIMULATOR_PROB_BITS + 1;
+
+// Bernoulli masks are generated this many samples at a time, so that the inner loop runs across the samples.
+constexpr size_t MASK_CHUNK_SIZE = 64;
+
+
+static inline uint64_t low_bits(size_t len){
+	return (len >= 64) ? ~0ULL : ((1ULL << len) - 1);
+}
+
+
+/*
+The build does not assume BMI2, so PEXT is compiled on its own and picked at runtime (as the kernels of vector_kernels.cc).
+*/
+__attribute__((target("bmi2")))
+static uint64_t extract_bits_bmi2(uint64_t word, uint64_t mask){
+	return _pext_u64(word, mask);
+}
+
+static uint64_t extract_bits_portable(uint64_t word, uint64_t mask){
+	uint64_t res = 0;
+	for (uint64_t out_bit = 1; mask != 0; out_bit <<= 1)
+	{
+		if (word & mask & -mask)
+		{
+			res |= out_bit;
+		}
+		mask &= mask - 1;
+	}
+	return res;
+}
+
+uint64_t extract_bits(uint64_t word, uint64_t mask){
+	static const bool use_bmi2 = __builtin_cpu_supports("bmi2");
+	if (use_bmi2)
+	{
+		return extract_bits_bmi2(word, mask);
+	}
+	return extract_bits_portable(word, mask);
+}
+
+
+DeletionChannelSimulator make_deletion_channel_simulator(Float deletion_prob, size_t in_len, size_t out_len, bool up_to,
+	uint64_t seed){
+	assert(in_len <= MAX_WIDE_WORD_LEN);
+	assert(up_to or out_len <= in_len);
+	DeletionChannelSimulator sim;
+	sim.deletion_prob = deletion_prob;
+	sim.in_len = in_len;
+	sim.out_len = out_len;
+	sim.up_to = up_to;
+	sim.key = counter_rng(seed, 0, 0);
+	sim.keep_prob_fixed = (uint64_t) llround((1 - deletion_prob) * (1ULL << SIMULATOR_PROB_BITS));
+	sim.keep_prob_fixed = std::min(sim.keep_prob_fixed, (uint64_t) 1 << SIMULATOR_PROB_BITS);
+	sim.keep_prob_trailing_zeros = (sim.keep_prob_fixed == 0) ? SIMULATOR_PROB_BITS : __builtin_ctzll(sim.keep_prob_fixed);
+
+	if (up_to and out_len < in_len)
+	{
+		// The binomial distribution of the number of kept bits, truncated to out_len:
+		std::vector<Float> log_weights(out_len + 1);
+		for (size_t k = 0; k <= out_len; ++k)
+		{
+			log_weights[k] = lgamma(in_len + 1.0) - lgamma(k + 1.0) - lgamma(in_len - k + 1.0) +
+				(k * log(1 - deletion_prob)) + ((in_len - k) * log(deletion_prob));
+			if (std::isnan(log_weights[k]))
+			{
+				log_weights[k] = -INFINITY;
+			}
+		}
+		Float max_log_weight = *std::max_element(log_weights.begin(), log_weights.end());
+		std::vector<Float> cdf(out_len + 1);
+		Float total = 0.0;
+		for (size_t k = 0; k <= out_len; ++k)
+		{
+			total += exp(log_weights[k] - max_log_weight);
+			cdf[k] = total;
+		}
+		sim.length_cdf.resize(out_len + 1);
+		for (size_t k = 0; k <= out_len; ++k)
+		{
+			sim.length_cdf[k] = (uint64_t) std::min(ldexp(cdf[k] / total, 64), 0x1.fffffffffffffp63);
+		}
+		sim.length_cdf[out_len] = ~0ULL;
+	}
+	return sim;
+}
+
+
+/*
+Keeps every bit with probability keep_prob_fixed / 2^32, one bit of the probability at a time: OR-ing (AND-ing) a uniform
+	word into a mask whose bits are set with probability p gives a mask whose bits are set with probability (1 + p)/2 (p/2).
+The chunk'th 64 bits of a wide mask use the draws from chunk * SIMULATOR_PROB_BITS on. These overlap the length and
+	subset draws, but a sample never uses both.
+*/
+static inline uint64_t bernoulli_mask(const DeletionChannelSimulator& sim, uint64_t sample, size_t chunk){
+	if (sim.keep_prob_fixed >> SIMULATOR_PROB_BITS)
+	{
+		return ~0ULL;
+	}
+	uint64_t stream = sample_stream(sim.key, sample);
+	uint64_t mask = 0;
+	for (size_t bit = sim.keep_prob_trailing_zeros; bit < SIMULATOR_PROB_BITS; ++bit)
+	{
+		uint64_t r = stream_draw(stream, (chunk * SIMULATOR_PROB_BITS) + bit);
+		mask = ((sim.keep_prob_fixed >> bit) & 1) ? (mask | r) : (mask & r);
+	}
+	return mask;
+}
+
+
+/*
+A uniformly random subset of k of the n bits (Floyd's algorithm).
+*/
+template <typename Word>
+static inline Word fixed_size_mask(const DeletionChannelSimulator& sim, uint64_t sample, size_t k){
+	size_t n = sim.in_len;
+	uint64_t stream = sample_stream(sim.key, sample);
+	Word mask(0);
+	for (size_t j = n - k; j < n; ++j)
+	{
+		uint64_t r = stream_draw(stream, FIRST_SUBSET_DRAW + j);
+		size_t t = (size_t) (((unsigned __int128) r * (j + 1)) >> 64);
+		mask = mask | ((low_word(mask >> t) & 1) ? (Word(1) << j) : (Word(1) << t));
+	}
+	return mask;
+}
+
+
+template <typename Word>
+Word simulate_keep_mask(const DeletionChannelSimulator& sim, uint64_t sample){
+	assert(sim.in_len <= BitWordTraits<Word>::BITS);
+	if (not sim.up_to)
+	{
+		return fixed_size_mask<Word>(sim, sample, sim.out_len);
+	}
+	if (not sim.length_cdf.empty())
+	{
+		uint64_t u = counter_rng(sim.key, sample, LENGTH_DRAW);
+		size_t k = std::upper_bound(sim.length_cdf.begin(), sim.length_cdf.end() - 1, u) - sim.length_cdf.begin();
+		return fixed_size_mask<Word>(sim, sample, k);
+	}
+	Word mask(0);
+	for (size_t chunk = 0; 64 * chunk < sim.in_len; ++chunk)
+	{
+		mask = mask | (Word(bernoulli_mask(sim, sample, chunk)) << (64 * chunk));
+	}
+	return mask & low_bits_mask<Word>(sim.in_len);
+}
+
+template uint64_t simulate_keep_mask(const DeletionChannelSimulator& sim, uint64_t sample);
+template unsigned __int128 simulate_keep_mask(const DeletionChannelSimulator& sim, uint64_t sample);
+template MultiWord<4> simulate_keep_mask(const DeletionChannelSimulator& sim, uint64_t sample);
+
+
+void simulate_deletion_channel_batch(const DeletionChannelSimulator& sim, const EfficientBitCodeWord* transmitted,
+	EfficientBitCodeWord* received, size_t count, uint64_t first_sample){
+	assert(sim.in_len <= 64);
+	if (not sim.up_to or not sim.length_cdf.empty() or (sim.keep_prob_fixed >> SIMULATOR_PROB_BITS))
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			received[i] = simulate_deletion_channel(sim, transmitted[i], first_sample + i);
+		}
+		return;
+	}
+	// Independent deletions: build the masks of a chunk of samples together so that the loop over the samples vectorizes.
+	uint64_t masks[MASK_CHUNK_SIZE];
+	uint64_t streams[MASK_CHUNK_SIZE];
+	for (size_t chunk = 0; chunk < count; chunk += MASK_CHUNK_SIZE)
+	{
+		size_t chunk_size = std::min(MASK_CHUNK_SIZE, count - chunk);
+		for (size_t s = 0; s < chunk_size; ++s)
+		{
+			masks[s] = 0;
+			streams[s] = sample_stream(sim.key, first_sample + chunk + s);
+		}
+		for (size_t bit = sim.keep_prob_trailing_zeros; bit < SIMULATOR_PROB_BITS; ++bit)
+		{
+			uint64_t keep_bit = (sim.keep_prob_fixed >> bit) & 1;
+			for (size_t s = 0; s < chunk_size; ++s)
+			{
+				uint64_t r = stream_draw(streams[s], bit);
+				masks[s] = keep_bit ? (masks[s] | r) : (masks[s] & r);
+			}
+		}
+		for (size_t s = 0; s < chunk_size; ++s)
+		{
+			uint64_t mask = masks[s] & low_bits(sim.in_len);
+			received[chunk + s] = EfficientBitCodeWord(extract_bits(transmitted[chunk + s].num, mask), __builtin_popcountll(mask));
+		}
+	}
+}
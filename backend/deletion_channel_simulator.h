@@ -0,0 +1,106 @@
+#pragma once
+#include "utils.h"
+#include "bit_channel.h"
+#include "bit_words.h"
+
+
+/*
+A stateless counter based generator: stream_draw(sample_stream(key, sample), draw) is the draw'th random word of the given
+	sample of the stream with the given key. Every sample can thus be simulated independently of all the others
+	(in any order and on any thread).
+Both steps are a round of the splitmix64 finalizer, so the per-sample part can be hoisted out of the loops over the draws.
+*/
+inline uint64_t splitmix64_finalize(uint64_t x){
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+inline uint64_t sample_stream(uint64_t key, uint64_t sample){
+	return splitmix64_finalize(key ^ (sample * 0x9E3779B97F4A7C15ULL));
+}
+
+inline uint64_t stream_draw(uint64_t stream, uint64_t draw){
+	return splitmix64_finalize(stream + ((draw + 1) * 0xD1B54A32D192ED03ULL));
+}
+
+inline uint64_t counter_rng(uint64_t key, uint64_t sample, uint64_t draw){
+	return stream_draw(sample_stream(key, sample), draw);
+}
+
+/*
+Compacts the bits of word selected by mask into the low bits of the result (keeping their order), like the BMI2 PEXT instruction.
+*/
+uint64_t extract_bits(uint64_t word, uint64_t mask);
+
+/*
+The same for words of any width (see bit_words.h), 64 bits at a time.
+*/
+template <typename Word>
+inline Word extract_word_bits(const Word& word, const Word& mask){
+	Word res(0);
+	size_t res_len = 0;
+	for (size_t shift = 0; shift < BitWordTraits<Word>::BITS; shift += 64)
+	{
+		uint64_t chunk_mask = low_word(mask >> shift);
+		res = res | (Word(extract_bits(low_word(word >> shift), chunk_mask)) << res_len);
+		res_len += __builtin_popcountll(chunk_mask);
+	}
+	return res;
+}
+
+/*
+Simulates the deletion channel that initialize_bit_channel(deletion_prob, in_len, out_len, up_to) describes:
+	- up_to with out_len >= in_len: every bit is kept independently with probability 1 - deletion_prob.
+	- up_to with out_len < in_len: the number of kept bits is binomial, truncated to at most out_len.
+	- otherwise exactly out_len uniformly random bits are kept.
+*/
+struct DeletionChannelSimulator
+{
+	Float deletion_prob;
+	size_t in_len;
+	size_t out_len;
+	bool up_to;
+	uint64_t key;
+	// The keep probability in 0.32 fixed point, and the number of its trailing zero bits (which need no random words).
+	uint64_t keep_prob_fixed;
+	size_t keep_prob_trailing_zeros;
+	// The CDF of the number of kept bits in 0.64 fixed point (only used when the output length is restricted).
+	std::vector<uint64_t> length_cdf;
+};
+
+constexpr size_t SIMULATOR_PROB_BITS = 32;
+
+DeletionChannelSimulator make_deletion_channel_simulator(Float deletion_prob, size_t in_len, size_t out_len, bool up_to,
+	uint64_t seed);
+
+/*
+Returns the mask of the bits of a codeword of length sim.in_len that survive the channel in the given sample.
+The word type only has to hold sim.in_len bits: the mask of a sample is the same at every width.
+Instantiated for uint64_t, unsigned __int128 and MultiWord<4>.
+*/
+template <typename Word = uint64_t>
+Word simulate_keep_mask(const DeletionChannelSimulator& sim, uint64_t sample);
+
+/*
+Transmits a single codeword of length sim.in_len. The outcome depends only on the simulator's key and the sample index.
+*/
+inline EfficientBitCodeWord simulate_deletion_channel(const DeletionChannelSimulator& sim, const EfficientBitCodeWord& transmitted,
+	uint64_t sample){
+	uint64_t mask = simulate_keep_mask(sim, sample);
+	return EfficientBitCodeWord(extract_bits(transmitted.num, mask), __builtin_popcountll(mask));
+}
+
+template <typename Word>
+inline BasicBitCodeWord<Word> simulate_deletion_channel(const DeletionChannelSimulator& sim, const BasicBitCodeWord<Word>& transmitted,
+	uint64_t sample){
+	Word mask = simulate_keep_mask<Word>(sim, sample);
+	return BasicBitCodeWord<Word>(extract_word_bits(transmitted.num, mask), word_popcount(mask));
+}
+
+/*
+Transmits count codewords. The i'th one is sample first_sample + i, so splitting a batch between threads
+	(or calling simulate_deletion_channel on every element) gives the same result.
+*/
+void simulate_deletion_channel_batch(const DeletionChannelSimulator& sim, const EfficientBitCodeWord* transmitted,
+	EfficientBitCodeWord* received, size_t count, uint64_t first_sample);
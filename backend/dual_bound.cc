@@ -0,0 +1,153 @@
+#include "dual_bound.h"
+#include "bit_baa_fast.h"
+#include "codeword_buckets.h"
+#include "numa_placement.h"
+#include "tiled_baa.h"
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <unistd.h>
+
+// The transmitted codewords are handed to the threads in blocks of consecutive codewords, which share the split cache
+// 	rows of their first halves.
+constexpr size_t DUAL_BOUND_BLOCK_SIZE = 64;
+
+
+/*
+The maximisers found so far, shared by the threads. The smallest divergence that is kept is published through an atomic,
+	so the rows only take the lock when they are about to enter the list.
+*/
+class DualBoundMaximisers
+{
+public:
+	explicit DualBoundMaximisers(size_t capacity) : _capacity(capacity), _threshold(-INFINITY) {}
+
+	Float threshold() const{
+		return _threshold.load(std::memory_order_relaxed);
+	}
+
+	void offer(size_t index, Float divergence){
+		std::lock_guard<std::mutex> lock(_mutex);
+		DualBoundMaximiser candidate = {index, divergence};
+		auto position = std::upper_bound(_maximisers.begin(), _maximisers.end(), candidate, precedes);
+		if (_maximisers.size() == _capacity and position == _maximisers.end())
+		{
+			return;
+		}
+		_maximisers.insert(position, candidate);
+		if (_maximisers.size() > _capacity)
+		{
+			_maximisers.pop_back();
+		}
+		if (_maximisers.size() == _capacity)
+		{
+			_threshold.store(_maximisers.back().divergence, std::memory_order_relaxed);
+		}
+	}
+
+	const std::vector<DualBoundMaximiser>& maximisers() const{
+		return _maximisers;
+	}
+
+private:
+	static bool precedes(const DualBoundMaximiser& a, const DualBoundMaximiser& b){
+		return (a.divergence > b.divergence) or (a.divergence == b.divergence and a.index < b.index);
+	}
+
+	size_t _capacity;
+	std::atomic<Float> _threshold;
+	std::mutex _mutex;
+	std::vector<DualBoundMaximiser> _maximisers;
+};
+
+
+DualBoundResult compute_dual_bound(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted,
+	const std::vector<EfficientBitCodeWord>& received, const std::vector<Float>& R, const DualBoundOptions& options){
+	assert(R.size() == received.size() and received.size() % 2 == 0);
+	assert(not transmitted.empty() and options.num_maximisers > 0);
+	size_t num_received = received.size();
+
+	std::vector<Float> log_R(num_received);
+	for (size_t j = 0; j < num_received; j += 2)
+	{
+		assert(R[j] >= 0 and R[j + 1] >= 0);
+		log_R[j] = log_R[j + 1] = log((R[j] + R[j + 1]) / 2);
+	}
+
+	BaaTileShape shape = choose_baa_tile_shape(channel.in_len(), channel.out_len(), transmitted.size(), num_received);
+	size_t tile_size = std::min(shape.received_cols, num_received);
+	size_t num_tiles = (num_received + tile_size - 1) / tile_size;
+	// min_log_R_after[tile] is the smallest log R of the received codewords from the tile on.
+	std::vector<Float> min_log_R_after(num_tiles + 1, INFINITY);
+	for (size_t tile = num_tiles; tile-- > 0;)
+	{
+		min_log_R_after[tile] = min_log_R_after[tile + 1];
+		for (size_t j = tile * tile_size; j < std::min(num_received, (tile + 1) * tile_size); ++j)
+		{
+			min_log_R_after[tile] = std::min(min_log_R_after[tile], log_R[j]);
+		}
+	}
+
+	CodewordBucketIndex received_index(received);
+	DualBoundMaximisers maximisers(std::min(options.num_maximisers, transmitted.size()));
+	std::atomic<size_t> num_early_exits(0);
+	size_t num_blocks = (transmitted.size() + DUAL_BOUND_BLOCK_SIZE - 1) / DUAL_BOUND_BLOCK_SIZE;
+
+	auto run_block = [&](size_t block){
+		std::vector<Float> P_tile(tile_size);
+		for (size_t i = block * DUAL_BOUND_BLOCK_SIZE; i < std::min(transmitted.size(), (block + 1) * DUAL_BOUND_BLOCK_SIZE); ++i)
+		{
+			Float divergence = 0.0;
+			Float row_mass = 0.0;
+			bool dropped = false;
+			for (size_t tile = 0; tile < num_tiles and divergence < INFINITY; ++tile)
+			{
+				size_t begin = tile * tile_size;
+				size_t end = std::min(num_received, begin + tile_size);
+				compute_Pjk_row_range(channel, transmitted[i], received, begin, end, &received_index, P_tile.data());
+				for (size_t j = begin; j < end; ++j)
+				{
+					Float P = P_tile[j - begin];
+					if (P > 0)
+					{
+						divergence += P * (log(P) - log_R[j]);
+						row_mass += P;
+					}
+				}
+				if (not options.early_exit or tile + 1 == num_tiles)
+				{
+					continue;
+				}
+				// m * log(m / R_min) is convex in m, so over the probability left in the row, [0, 1 - row_mass], it is
+				// 	largest at one of the ends.
+				Float mass_left = std::max(0.0, 1.0 - row_mass);
+				Float rest_bound = (mass_left > 0) ? std::max(0.0, mass_left * (log(mass_left) - min_log_R_after[tile + 1])) : 0.0;
+				if (divergence + rest_bound < maximisers.threshold())
+				{
+					dropped = true;
+					break;
+				}
+			}
+			if (dropped)
+			{
+				++num_early_exits;
+			}
+			else if (divergence >= maximisers.threshold()){
+				maximisers.offer(i, divergence);
+			}
+		}
+	};
+
+	size_t num_threads = options.num_threads;
+	if (num_threads == 0)
+	{
+		num_threads = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+	}
+	run_parallel_tasks(num_threads, num_blocks, run_block);
+
+	DualBoundResult result;
+	result.maximisers = maximisers.maximisers();
+	result.bound = result.maximisers.front().divergence;
+	result.num_early_exits = num_early_exits;
+	return result;
+}
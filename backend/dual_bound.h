@@ -0,0 +1,55 @@
+#pragma once
+#include "utils.h"
+#include "bit_channel.h"
+
+
+/*
+The dual (upper) bound on the capacity: for every distribution R on the received codewords,
+	C <= max_t D(P_t || R),
+	where P_t is the row of the transition table of the transmitted codeword t. Evaluating it takes a single pass over the
+	transmitted alphabet, so an analytic or parametric candidate R can be checked without running the BAA (the output
+	distribution of the BAA's own Q gives a bound that closes on the rate as the BAA converges).
+*/
+
+
+struct DualBoundOptions
+{
+	// 0 means all of the online cores.
+	size_t num_threads = 0;
+	// The number of transmitted codewords with the largest divergences to report.
+	size_t num_maximisers = 10;
+	// Stop evaluating a row once its divergence provably cannot reach the maximisers (see compute_dual_bound).
+	bool early_exit = true;
+};
+
+struct DualBoundMaximiser
+{
+	// The index into the transmitted alphabet and D(P_t || R) in nats.
+	size_t index;
+	Float divergence;
+};
+
+struct DualBoundResult
+{
+	// max_t D(P_t || R) in nats (the units of compute_bit_rate_efficient), INFINITY if R misses a reachable codeword.
+	Float bound;
+	// In decreasing divergence (ties by index).
+	std::vector<DualBoundMaximiser> maximisers;
+	// The number of rows that were dropped before their end.
+	size_t num_early_exits;
+};
+
+/*
+Computes the dual bound of R (a probability for every received codeword, in the order of the received alphabet) over the
+	transmitted alphabet, which may be reduced by the NOT symmetry: R is averaged over every (codeword, complement) pair
+	first, which can only lower the bound (the divergence is convex in R) and makes the maximum over the representatives
+	the maximum over all of the transmitted codewords. An R that sums to less than 1 gives a looser but still valid bound.
+The rows are computed a tile of received codewords at a time (as in accumulate_baa_tiles). After every tile, the rest of
+	the row can add at most m * log(m / R_min) to the divergence, where m is the probability left in the row and R_min the
+	smallest probability of the received codewords that are left, and the row is dropped once even that cannot reach the
+	smallest of the maximisers found so far. The maximisers and the bound do not depend on the number of threads or on
+	the early exits, as a row is only dropped when it is strictly below a divergence that is kept.
+The channel's cache tables are loaded and the transition kernels should be autotuned before this is called.
+*/
+DualBoundResult compute_dual_bound(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted,
+	const std::vector<EfficientBitCodeWord>& received, const std::vector<Float>& R, const DualBoundOptions& options);
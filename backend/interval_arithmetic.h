@@ -0,0 +1,90 @@
+#pragma once
+#include "utils.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+
+/*
+Interval arithmetic with outward rounding, for the certified evaluation of the rate (see certified_rate.h).
+Rather than switching the rounding mode of the FPU (which GCC does not promise to respect without -frounding-math, and
+	which the library's log ignores anyway), every result is computed with the usual rounding to nearest and pushed out by
+	a ulp: the exact result of an operation lies between the neighbours of its rounded result. This is a couple of plain
+	vector operations (the makefile builds with -ffp-contract=off, so nothing is fused), so the certified passes
+	vectorize as the regular ones do.
+*/
+
+
+/*
+A double below (above) x by at least a ulp of x, down to the subnormals (the smallest subnormal is also subtracted).
+	Overflows stay bounded: the lower bound of +inf is DBL_MAX.
+*/
+inline Float round_down(Float x){
+	Float res = (x - std::abs(x) * 0x1p-52) - std::numeric_limits<Float>::denorm_min();
+	return std::isfinite(x) ? res : ((x > 0) ? DBL_MAX : x);
+}
+
+inline Float round_up(Float x){
+	Float res = (x + std::abs(x) * 0x1p-52) + std::numeric_limits<Float>::denorm_min();
+	return std::isfinite(x) ? res : ((x < 0) ? -DBL_MAX : x);
+}
+
+
+struct Interval
+{
+	Float lo;
+	Float hi;
+};
+
+inline Interval exact_interval(Float x){
+	return {x, x};
+}
+
+inline Interval interval_add(const Interval& a, const Interval& b){
+	return {round_down(a.lo + b.lo), round_up(a.hi + b.hi)};
+}
+
+inline Interval interval_sub(const Interval& a, const Interval& b){
+	return {round_down(a.lo - b.hi), round_up(a.hi - b.lo)};
+}
+
+inline Interval interval_mul(const Interval& a, const Interval& b){
+	Float products[4] = {a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi};
+	return {round_down(*std::min_element(products, products + 4)), round_up(*std::max_element(products, products + 4))};
+}
+
+/*
+a * b for a, b >= 0, where the lower end is not pushed below 0.
+*/
+inline Interval interval_mul_nonnegative(const Interval& a, const Interval& b){
+	assert(a.lo >= 0 and b.lo >= 0);
+	return {std::max(0.0, round_down(a.lo * b.lo)), round_up(a.hi * b.hi)};
+}
+
+/*
+a / b for b > 0.
+*/
+inline Interval interval_div_positive(const Interval& a, const Interval& b){
+	assert(b.lo > 0);
+	Float quotients[4] = {a.lo / b.lo, a.lo / b.hi, a.hi / b.lo, a.hi / b.hi};
+	return {round_down(*std::min_element(quotients, quotients + 4)), round_up(*std::max_element(quotients, quotients + 4))};
+}
+
+/*
+The library's log is within a ulp of the exact one (glibc documents less than 1 ulp on x86-64), so its result is pushed
+	out by two ulps. a.lo >= 0, and log(0) = -inf.
+*/
+inline Float log_round_down(Float x){
+	return (x > 0) ? round_down(round_down(log(x))) : -INFINITY;
+}
+
+inline Float log_round_up(Float x){
+	return round_up(round_up(log(x)));
+}
+
+inline Interval interval_log(const Interval& a){
+	assert(a.lo >= 0);
+	return {log_round_down(a.lo), log_round_up(a.hi)};
+}
@@ -0,0 +1,11 @@
+#include "log_count_table.h"
+
+
+const std::array<Float, LOG_COUNT_TABLE_SIZE> _log_count_table = [](){
+	std::array<Float, LOG_COUNT_TABLE_SIZE> res;
+	for (size_t count = 0; count < LOG_COUNT_TABLE_SIZE; ++count)
+	{
+		res[count] = log((Float) count);
+	}
+	return res;
+}();
@@ -0,0 +1,21 @@
+#pragma once
+#include "utils.h"
+#include <array>
+#include <cmath>
+
+
+/*
+The logs of the transition counts, which are exact integers: P_jk = normalization_factor(n, k) * count_jk, so
+	log P_jk = log_normalization_factor(n, k) + log count_jk, where the first term is cached per (n, k) in the channel
+	context and the second comes from this table for the counts below LOG_COUNT_TABLE_SIZE. A count is a number of ways
+	to delete bits, which is small for almost every pair, so the larger counts fall back to the library's log.
+The table holds the library's logs (log(0) = -inf), so log_count(c) is bitwise log(c) either way.
+The table takes 32KB, so it stays in L2 next to the tiles of the BAA passes (see tiled_baa.h).
+*/
+constexpr size_t LOG_COUNT_TABLE_SIZE = 1 << 12;
+
+extern const std::array<Float, LOG_COUNT_TABLE_SIZE> _log_count_table;
+
+inline Float log_count(Float count){
+	return (count < LOG_COUNT_TABLE_SIZE) ? _log_count_table[(size_t) count] : log(count);
+}
@@ -0,0 +1,214 @@
+#include "monte_carlo_rate.h"
+#include "transition_kernels.h"
+#include "deletion_channel_simulator.h"
+#include "numa_placement.h"
+#include <random>
+#include <unistd.h>
+
+// The number of batches evaluated between two checks of the stopping rule (independent of the number of threads,
+// 	so that the stopping point is reproducible).
+constexpr size_t BATCHES_PER_ROUND = 64;
+
+
+MarkovInputDistribution iid_input_distribution(Float one_prob){
+	return MarkovInputDistribution{one_prob, one_prob, 1 - one_prob};
+}
+
+
+template <typename Word>
+Float compute_expected_transition_count(const MarkovInputDistribution& Q, size_t in_len, const BasicBitCodeWord<Word>& received){
+	size_t k = received.len;
+	if (k > in_len)
+	{
+		return 0.0;
+	}
+	// ways[j][b] is the sum over the prefixes of the transmitted codeword ending with the bit b, of their probability
+	// 	times the number of ways to produce the first j received bits from them.
+	std::vector<std::array<Float, 2> > ways(k + 1, {0.0, 0.0});
+	// Before the first bit, the chain is in a virtual state whose transitions are the initial distribution.
+	ways[0][0] = 1.0;
+	Float trans[2][2] = {{1 - Q.first_one_prob, Q.first_one_prob}, {0.0, 0.0}};
+	for (size_t i = 0; i < in_len; ++i)
+	{
+		for (size_t j = std::min(i + 1, k) + 1; j-- > 0;)
+		{
+			std::array<Float, 2> next;
+			for (size_t c = 0; c < 2; ++c)
+			{
+				next[c] = (ways[j][0] * trans[0][c]) + (ways[j][1] * trans[1][c]);
+				if (j > 0 and received.bit(j - 1) == c)
+				{
+					next[c] += (ways[j-1][0] * trans[0][c]) + (ways[j-1][1] * trans[1][c]);
+				}
+			}
+			ways[j] = next;
+		}
+		trans[0][0] = 1 - Q.zero_to_one_prob;	trans[0][1] = Q.zero_to_one_prob;
+		trans[1][0] = Q.one_to_zero_prob;		trans[1][1] = 1 - Q.one_to_zero_prob;
+	}
+	return ways[k][0] + ways[k][1];
+}
+
+template Float compute_expected_transition_count(const MarkovInputDistribution& Q, size_t in_len, const BasicBitCodeWord<uint64_t>& received);
+template Float compute_expected_transition_count(const MarkovInputDistribution& Q, size_t in_len, const BitCodeWord128& received);
+template Float compute_expected_transition_count(const MarkovInputDistribution& Q, size_t in_len, const BitCodeWord256& received);
+
+Float compute_expected_transition_count(const MarkovInputDistribution& Q, size_t in_len, const EfficientBitCodeWord& received){
+	return compute_expected_transition_count(Q, in_len, BasicBitCodeWord<uint64_t>(received));
+}
+
+
+/*
+The running mean and sum of squared deviations of a set of samples (merged with Chan et al.'s pairwise update).
+*/
+struct SampleStats
+{
+	size_t count = 0;
+	Float mean = 0.0;
+	Float m2 = 0.0;
+
+	void add(Float x){
+		++count;
+		Float delta = x - mean;
+		mean += delta / count;
+		m2 += delta * (x - mean);
+	}
+
+	void merge(const SampleStats& other){
+		if (other.count == 0)
+		{
+			return;
+		}
+		size_t total = count + other.count;
+		Float delta = other.mean - mean;
+		mean += delta * other.count / total;
+		m2 += other.m2 + (delta * delta * count * other.count / total);
+		count = total;
+	}
+};
+
+
+static inline Float uniform_01(std::mt19937_64& rng){
+	return (rng() >> 11) * 0x1.0p-53;
+}
+
+
+template <typename Word>
+static BasicBitCodeWord<Word> sample_transmitted(const MarkovInputDistribution& Q, size_t in_len, std::mt19937_64& rng){
+	Word num(0);
+	uint64_t bit = 0;
+	for (size_t i = 0; i < in_len; ++i)
+	{
+		if (i == 0)
+		{
+			bit = uniform_01(rng) < Q.first_one_prob;
+		} else if (bit == 0){
+			bit = uniform_01(rng) < Q.zero_to_one_prob;
+		} else{
+			bit = not (uniform_01(rng) < Q.one_to_zero_prob);
+		}
+		num = (num << 1) | Word(bit);
+	}
+	return BasicBitCodeWord<Word>(num, in_len);
+}
+
+
+static Float count_transitions_any_length(const BasicBitCodeWord<uint64_t>& wide_transmitted,
+	const BasicBitCodeWord<uint64_t>& wide_received){
+	EfficientBitCodeWord transmitted(wide_transmitted.num, wide_transmitted.len);
+	EfficientBitCodeWord received(wide_received.num, wide_received.len);
+	if (transition_kernel_applicable(_transition_kernel_kinds[transmitted.len][received.len], transmitted.len, received.len))
+	{
+		return count_transitions(transmitted, received);
+	}
+	// The cache tables of long codewords are usually not loaded.
+	return count_transitions_dynamic_programming(transmitted, received);
+}
+
+// Past 64 bits there are no kernels, and the counts no longer fit in an integer.
+template <typename Word>
+static Float count_transitions_any_length(const BasicBitCodeWord<Word>& transmitted, const BasicBitCodeWord<Word>& received){
+	return count_transitions_wide(transmitted, received);
+}
+
+
+template <typename Word>
+static SampleStats run_batch_of_width(const MarkovInputDistribution& Q, size_t in_len, const DeletionChannelSimulator& channel,
+	const MonteCarloRateOptions& options, uint64_t batch){
+	std::seed_seq seq{(uint32_t) options.seed, (uint32_t) (options.seed >> 32), (uint32_t) batch, (uint32_t) (batch >> 32)};
+	std::mt19937_64 rng(seq);
+	SampleStats stats;
+	for (size_t s = 0; s < options.batch_size; ++s)
+	{
+		auto transmitted = sample_transmitted<Word>(Q, in_len, rng);
+		auto received = simulate_deletion_channel(channel, transmitted, (batch * options.batch_size) + s);
+		Float count = count_transitions_any_length(transmitted, received);
+		stats.add(log(count) - log(compute_expected_transition_count(Q, in_len, received)));
+	}
+	return stats;
+}
+
+/*
+Runs the batch on the narrowest codewords that hold in_len bits, so that the 64 bit path is unchanged.
+*/
+static SampleStats run_batch(const MarkovInputDistribution& Q, size_t in_len, const DeletionChannelSimulator& channel,
+	const MonteCarloRateOptions& options, uint64_t batch){
+	if (in_len <= 64)
+	{
+		return run_batch_of_width<uint64_t>(Q, in_len, channel, options, batch);
+	}
+	if (in_len <= 128)
+	{
+		return run_batch_of_width<unsigned __int128>(Q, in_len, channel, options, batch);
+	}
+	return run_batch_of_width<MultiWord<4> >(Q, in_len, channel, options, batch);
+}
+
+
+MonteCarloRateEstimate estimate_rate_monte_carlo(const MarkovInputDistribution& Q, Float deletion_prob, size_t in_len,
+	size_t out_len, bool up_to, const MonteCarloRateOptions& options){
+	assert(in_len > 0 and in_len <= MAX_WIDE_WORD_LEN);
+	assert(up_to or out_len <= in_len);
+	assert(options.batch_size > 0);
+	auto channel = make_deletion_channel_simulator(deletion_prob, in_len, out_len, up_to, options.seed);
+	size_t num_threads = options.num_threads;
+	if (num_threads == 0)
+	{
+		num_threads = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+	}
+
+	SampleStats total;
+	MonteCarloRateEstimate estimate;
+	estimate.converged = false;
+	size_t next_batch = 0;
+	while (true)
+	{
+		size_t remaining = (options.max_samples > total.count) ? options.max_samples - total.count : 0;
+		size_t num_batches = std::min(BATCHES_PER_ROUND, (remaining + options.batch_size - 1) / options.batch_size);
+		if (num_batches == 0)
+		{
+			break;
+		}
+		std::vector<SampleStats> batch_stats(num_batches);
+		run_parallel_tasks(num_threads, num_batches, [&](size_t b){
+			batch_stats[b] = run_batch(Q, in_len, channel, options, next_batch + b);
+		});
+		for (const auto& stats : batch_stats)
+		{
+			total.merge(stats);
+		}
+		next_batch += num_batches;
+
+		Float standard_error = (total.count > 1) ? sqrt(total.m2 / (total.count - 1) / total.count) : INFINITY;
+		if (total.count >= options.min_samples and options.z_score * standard_error <= options.target_half_width)
+		{
+			estimate.converged = true;
+			break;
+		}
+	}
+	estimate.rate = total.mean;
+	estimate.num_samples = total.count;
+	estimate.standard_error = (total.count > 1) ? sqrt(total.m2 / (total.count - 1) / total.count) : INFINITY;
+	estimate.half_width = options.z_score * estimate.standard_error;
+	return estimate;
+}
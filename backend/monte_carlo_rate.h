@@ -0,0 +1,66 @@
+#pragma once
+#include "utils.h"
+#include "bit_channel.h"
+#include "bit_words.h"
+
+
+/*
+A binary Markov chain over the bits of the transmitted codeword (the first bit being the most significant one).
+An i.i.d. Bernoulli(p) input is the chain with zero_to_one_prob = p and one_to_zero_prob = 1 - p.
+*/
+struct MarkovInputDistribution
+{
+	Float first_one_prob;
+	Float zero_to_one_prob;
+	Float one_to_zero_prob;
+};
+
+MarkovInputDistribution iid_input_distribution(Float one_prob);
+
+/*
+Returns E_{t ~ Q}[count(t, received)], the expected number of ways a random transmitted codeword of length in_len
+	can be transformed into the received one. Multiplied by the normalization factor of (in_len, received.len) this is W(r).
+Computed exactly with an O(in_len * received.len) forward pass over the states of the chain.
+*/
+Float compute_expected_transition_count(const MarkovInputDistribution& Q, size_t in_len, const EfficientBitCodeWord& received);
+// The same for codewords of any width (see bit_words.h), instantiated for uint64_t, unsigned __int128 and MultiWord<4>.
+template <typename Word>
+Float compute_expected_transition_count(const MarkovInputDistribution& Q, size_t in_len, const BasicBitCodeWord<Word>& received);
+
+struct MonteCarloRateOptions
+{
+	// Every batch of samples is drawn from its own RNG stream, seeded by (seed, batch index).
+	size_t batch_size = 4096;
+	uint64_t seed = 0;
+	// Stop once the half width of the confidence interval is at most target_half_width (in nats), but never before
+	// 	min_samples and never after max_samples.
+	Float target_half_width = 1E-3;
+	Float z_score = 1.96;
+	size_t min_samples = 1 << 16;
+	size_t max_samples = 1 << 24;
+	// 0 means all of the online cores.
+	size_t num_threads = 0;
+};
+
+struct MonteCarloRateEstimate
+{
+	// The mutual information I(T; R) in nats (the same units as compute_bit_rate_efficient).
+	Float rate;
+	Float standard_error;
+	Float half_width;
+	size_t num_samples;
+	bool converged;
+};
+
+/*
+Estimates the rate of the Markov input distribution on words of length in_len over the deletion channel, as produced by
+	initialize_bit_channel(deletion_prob, in_len, out_len, up_to): either exactly out_len bits are kept, or the number
+	of kept bits is binomial, truncated to at most out_len.
+Every sample draws t ~ Q and a received word r, and evaluates log P(r|t) - log W(r) exactly (the normalization factors
+	cancel, so this is log count(t, r) - log E_Q[count(T, r)]).
+in_len goes up to MAX_WIDE_WORD_LEN. Past 64 bits the codewords are the wide ones of bit_words.h, and the counts are kept in
+	floating point (see count_transitions_wide), so the samples are exact only up to rounding.
+The samples are reduced in batch order, so the result only depends on the seed and not on the number of threads.
+*/
+MonteCarloRateEstimate estimate_rate_monte_carlo(const MarkovInputDistribution& Q, Float deletion_prob, size_t in_len,
+	size_t out_len, bool up_to, const MonteCarloRateOptions& options);
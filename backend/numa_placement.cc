@@ -0,0 +1,181 @@
+#include "numa_placement.h"
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+
+static NumaTablePolicy _numa_table_policy = NUMA_OFF;
+// The node this process was bound to, to restore its memory policy after the tables were placed.
+static int _numa_home_node = -1;
+// The kernel's ids of the nodes of get_numa_node_cpus (memory only nodes are skipped, and the ids may be sparse).
+static std::vector<size_t> _numa_node_ids;
+
+constexpr size_t MAX_NUMA_NODES = 64;
+
+
+/*
+Parses a kernel cpulist such as "0-3,8-11".
+*/
+static std::vector<size_t> parse_cpu_list(const char* list){
+	std::vector<size_t> cpus;
+	const char* pos = list;
+	while (*pos != '\0' and *pos != '\n')
+	{
+		char* end;
+		size_t first = strtoul(pos, &end, 10);
+		if (end == pos)
+		{
+			break;
+		}
+		size_t last = first;
+		if (*end == '-')
+		{
+			pos = end + 1;
+			last = strtoul(pos, &end, 10);
+		}
+		for (size_t cpu = first; cpu <= last; ++cpu)
+		{
+			cpus.push_back(cpu);
+		}
+		pos = (*end == ',') ? end + 1 : end;
+	}
+	return cpus;
+}
+
+
+static std::vector<std::vector<size_t> > read_numa_node_cpus(){
+	std::vector<std::vector<size_t> > node_cpus;
+	for (size_t node = 0; node < MAX_NUMA_NODES; ++node)
+	{
+		char filename[128];
+		snprintf(filename, sizeof(filename), "/sys/devices/system/node/node%lu/cpulist", node);
+		FILE* cpulist_file = fopen(filename, "r");
+		if (cpulist_file == NULL)
+		{
+			continue;
+		}
+		char line[4096] = {0};
+		if (fgets(line, sizeof(line), cpulist_file) != NULL)
+		{
+			auto cpus = parse_cpu_list(line);
+			// Memory only nodes have no CPUs to run on.
+			if (not cpus.empty())
+			{
+				node_cpus.push_back(cpus);
+				_numa_node_ids.push_back(node);
+			}
+		}
+		fclose(cpulist_file);
+	}
+	if (node_cpus.empty())
+	{
+		std::vector<size_t> cpus;
+		for (long cpu = 0; cpu < sysconf(_SC_NPROCESSORS_CONF); ++cpu)
+		{
+			cpus.push_back(cpu);
+		}
+		node_cpus.push_back(cpus);
+		_numa_node_ids.push_back(0);
+	}
+	return node_cpus;
+}
+
+
+const std::vector<std::vector<size_t> >& get_numa_node_cpus(){
+	static const std::vector<std::vector<size_t> > node_cpus = read_numa_node_cpus();
+	return node_cpus;
+}
+
+
+bool pin_thread_to_numa_node(size_t node){
+	const auto& node_cpus = get_numa_node_cpus();
+	if (node >= node_cpus.size())
+	{
+		return false;
+	}
+	cpu_set_t cpu_set;
+	CPU_ZERO(&cpu_set);
+	for (size_t cpu : node_cpus[node])
+	{
+		CPU_SET(cpu, &cpu_set);
+	}
+	return sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0;
+}
+
+
+static bool set_memory_policy(int mode, const unsigned long* nodemask, unsigned long maxnode){
+	return syscall(SYS_set_mempolicy, mode, nodemask, maxnode) == 0;
+}
+
+
+bool prefer_numa_node_memory(size_t node){
+	if (node >= get_num_numa_nodes())
+	{
+		return false;
+	}
+	unsigned long nodemask = 1UL << _numa_node_ids[node];
+	return set_memory_policy(MPOL_PREFERRED, &nodemask, MAX_NUMA_NODES + 1);
+}
+
+
+int configure_numa_placement_from_env(){
+	const char* policy = getenv("BDC_NUMA_POLICY");
+	if (policy == NULL or policy[0] == '\0' or !strcmp(policy, "off"))
+	{
+		_numa_table_policy = NUMA_OFF;
+		return -1;
+	} else if (!strcmp(policy, "replicate")){
+		_numa_table_policy = NUMA_REPLICATE_TABLES;
+	} else if (!strcmp(policy, "interleave")){
+		_numa_table_policy = NUMA_INTERLEAVE_TABLES;
+	} else{
+		fprintf(stderr, "Unknown NUMA policy %s (expected off, replicate or interleave).\n", policy);
+		exit(1);
+	}
+
+	const char* shard_index = getenv("BDC_SHARD_INDEX");
+	size_t node = (shard_index != NULL) ? atol(shard_index) % get_num_numa_nodes() : 0;
+	if (not pin_thread_to_numa_node(node) or not prefer_numa_node_memory(node))
+	{
+		fprintf(stderr, "Warning: could not place the process on NUMA node %lu.\n", node);
+	}
+	_numa_home_node = node;
+	return node;
+}
+
+
+NumaTablePolicy get_numa_table_policy(){
+	return _numa_table_policy;
+}
+
+
+int numa_node_of_thread(size_t thread_index){
+	if (_numa_table_policy == NUMA_OFF)
+	{
+		return -1;
+	}
+	return thread_index % get_num_numa_nodes();
+}
+
+
+ScopedTablePlacement::ScopedTablePlacement() : _active(false){
+	if (_numa_table_policy != NUMA_INTERLEAVE_TABLES or get_num_numa_nodes() < 2)
+	{
+		return;
+	}
+	unsigned long nodemask = 0;
+	for (size_t node = 0; node < get_num_numa_nodes(); ++node)
+	{
+		nodemask |= 1UL << _numa_node_ids[node];
+	}
+	_active = set_memory_policy(MPOL_INTERLEAVE, &nodemask, MAX_NUMA_NODES + 1);
+}
+
+
+ScopedTablePlacement::~ScopedTablePlacement(){
+	if (_active)
+	{
+		prefer_numa_node_memory(_numa_home_node);
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "utils.h"
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <thread>
+
+
+/*
+How the read-only transition count tables are placed on multi-socket nodes (BDC_NUMA_POLICY).
+Every slave process loads its own copy of the tables, so with the process bound to a node the tables are replicated
+	per node for free. Interleaving them instead spreads the lookups over the memory controllers of all of the nodes.
+*/
+enum NumaTablePolicy
+{
+	// Leave the placement to the kernel (first touch, threads float freely).
+	NUMA_OFF,
+	// Bind the process and all of its allocations (including the tables) to the node of its shard.
+	NUMA_REPLICATE_TABLES,
+	// Bind the process to the node of its shard, but interleave the table pages over all of the nodes.
+	NUMA_INTERLEAVE_TABLES
+};
+
+/*
+The CPUs of every NUMA node, as listed in /sys/devices/system/node. Machines without that folder are a single node.
+*/
+const std::vector<std::vector<size_t> >& get_numa_node_cpus();
+
+inline size_t get_num_numa_nodes(){
+	return get_numa_node_cpus().size();
+}
+
+/*
+Restricts the calling thread to the CPUs of the given node. Returns false if the affinity could not be set.
+*/
+bool pin_thread_to_numa_node(size_t node);
+
+/*
+Makes the calling thread allocate (first touch) its memory on the given node when possible.
+*/
+bool prefer_numa_node_memory(size_t node);
+
+/*
+Reads BDC_NUMA_POLICY (off / replicate / interleave) and BDC_SHARD_INDEX, and for a policy other than off
+	pins the process to the node of its shard (shard_index mod the number of nodes) and prefers that node's memory.
+Must be called before the codewords, Q and the tables are loaded, so that they are first touched on the right node.
+Returns the node the process was placed on, or -1 if it was not placed.
+*/
+int configure_numa_placement_from_env();
+
+NumaTablePolicy get_numa_table_policy();
+
+/*
+The node that the i'th thread of a threaded engine should run on (threads are spread round robin over the sockets),
+	or -1 if the threads should not be pinned.
+*/
+int numa_node_of_thread(size_t thread_index);
+
+/*
+Runs task(0), ..., task(num_tasks - 1) on up to num_threads threads, which take the tasks in order as they become free.
+The calling thread runs tasks too, as thread 0, and keeps its affinity (the node of its shard). Only the spawned threads
+	are pinned, to numa_node_of_thread of their index.
+*/
+template <typename Task>
+void run_parallel_tasks(size_t num_threads, size_t num_tasks, const Task& task){
+	assert(num_threads > 0);
+	std::atomic<size_t> next(0);
+	auto run = [&](){
+		for (size_t t = next++; t < num_tasks; t = next++)
+		{
+			task(t);
+		}
+	};
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < std::min(num_threads, num_tasks); ++i)
+	{
+		threads.emplace_back([&run, i](){
+			if (numa_node_of_thread(i) >= 0)
+			{
+				pin_thread_to_numa_node(numa_node_of_thread(i));
+			}
+			run();
+		});
+	}
+	run();
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+/*
+Applies the table placement policy to the allocations made during the lifetime of the object
+	(used around the loading of the shared read-only tables).
+*/
+class ScopedTablePlacement
+{
+public:
+	ScopedTablePlacement();
+	~ScopedTablePlacement();
+private:
+	bool _active;
+};
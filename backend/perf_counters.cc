@@ -0,0 +1,264 @@
+#include "perf_counters.h"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#include <cstring>
+#include <mutex>
+
+std::atomic<bool> _perf_instrumentation_enabled(false);
+
+static const char* PERF_REGION_NAMES[NUM_PERF_REGIONS] = {
+	"denominators",
+	"alphas",
+	"rate",
+	"cache_load",
+};
+
+static const char* PERF_COUNTER_NAMES[NUM_PERF_COUNTERS] = {
+	"cycles",
+	"instructions",
+	"cache_misses",
+	"branch_misses",
+};
+
+static const uint64_t PERF_COUNTER_CONFIGS[NUM_PERF_COUNTERS] = {
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_CACHE_MISSES,
+	PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+/*
+The counters and the stats of a thread. The counters are opened as a single group so that all of them can be read with
+	one syscall. The stats are merged into _perf_exited_thread_stats when the thread exits.
+*/
+struct PerfThreadState
+{
+	bool opened = false;
+	int group_fd = -1;
+	int counter_fds[NUM_PERF_COUNTERS] = {-1, -1, -1, -1};
+	uint64_t counter_ids[NUM_PERF_COUNTERS];
+	size_t num_open_counters = 0;
+	PerfRegionStats stats[NUM_PERF_REGIONS];
+
+	~PerfThreadState();
+};
+
+static thread_local PerfThreadState _perf_thread_state;
+
+// Guards the stats of the exited threads and the set up of the instrumentation.
+static std::mutex _perf_mutex;
+static PerfRegionStats _perf_exited_thread_stats[NUM_PERF_REGIONS];
+// The counters that the thread which turned on the instrumentation could open (the columns of the report).
+static bool _perf_counter_available[NUM_PERF_COUNTERS] = {false};
+static size_t _num_available_counters = 0;
+
+
+static void merge_perf_region_stats(PerfRegionStats& res, const PerfRegionStats& stats){
+	res.calls += stats.calls;
+	res.wall_ns += stats.wall_ns;
+	for (size_t c = 0; c < NUM_PERF_COUNTERS; ++c)
+	{
+		res.counters[c] += stats.counters[c];
+	}
+}
+
+
+PerfThreadState::~PerfThreadState(){
+	for (size_t c = 0; c < NUM_PERF_COUNTERS; ++c)
+	{
+		if (counter_fds[c] != -1)
+		{
+			close(counter_fds[c]);
+		}
+	}
+	std::lock_guard<std::mutex> lock(_perf_mutex);
+	for (size_t r = 0; r < NUM_PERF_REGIONS; ++r)
+	{
+		merge_perf_region_stats(_perf_exited_thread_stats[r], stats[r]);
+	}
+}
+
+
+static int open_perf_counter(uint64_t config, int group_fd){
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = config;
+	attr.disabled = (group_fd == -1);
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID;
+	// Measure the calling thread on whichever CPU it runs on.
+	return (int) syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+
+static void open_thread_perf_counters(PerfThreadState& state){
+	state.opened = true;
+	for (size_t c = 0; c < NUM_PERF_COUNTERS; ++c)
+	{
+		int fd = open_perf_counter(PERF_COUNTER_CONFIGS[c], state.group_fd);
+		if (fd < 0)
+		{
+			continue;
+		}
+		if (ioctl(fd, PERF_EVENT_IOC_ID, &state.counter_ids[c]) < 0)
+		{
+			close(fd);
+			continue;
+		}
+		if (state.group_fd == -1)
+		{
+			state.group_fd = fd;
+		}
+		state.counter_fds[c] = fd;
+		++state.num_open_counters;
+	}
+	if (state.group_fd != -1)
+	{
+		ioctl(state.group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(state.group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+}
+
+
+bool enable_perf_instrumentation(){
+	std::lock_guard<std::mutex> lock(_perf_mutex);
+	if (_perf_instrumentation_enabled)
+	{
+		return _num_available_counters > 0;
+	}
+	open_thread_perf_counters(_perf_thread_state);
+	for (size_t c = 0; c < NUM_PERF_COUNTERS; ++c)
+	{
+		_perf_counter_available[c] = (_perf_thread_state.counter_fds[c] != -1);
+	}
+	_num_available_counters = _perf_thread_state.num_open_counters;
+	if (_num_available_counters == 0)
+	{
+		fprintf(stderr, "Warning: hardware performance counters are unavailable, falling back to timers only.\n");
+	}
+	_perf_instrumentation_enabled = true;
+	return _num_available_counters > 0;
+}
+
+
+const char* enable_perf_instrumentation_from_env(){
+	const char* stats_path = getenv("BDC_PERF_STATS");
+	if (stats_path == NULL or stats_path[0] == '\0')
+	{
+		return NULL;
+	}
+	enable_perf_instrumentation();
+	return stats_path;
+}
+
+
+void read_perf_counters(uint64_t& wall_ns, uint64_t counters[NUM_PERF_COUNTERS]){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	wall_ns = ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+
+	for (size_t c = 0; c < NUM_PERF_COUNTERS; ++c)
+	{
+		counters[c] = 0;
+	}
+	PerfThreadState& state = _perf_thread_state;
+	if (not state.opened and perf_instrumentation_enabled())
+	{
+		open_thread_perf_counters(state);
+	}
+	if (state.group_fd == -1)
+	{
+		return;
+	}
+	// Layout of a PERF_FORMAT_GROUP | PERF_FORMAT_ID read: nr, followed by nr (value, id) pairs.
+	uint64_t buffer[1 + (2 * NUM_PERF_COUNTERS)];
+	if (read(state.group_fd, buffer, sizeof(buffer)) <= 0)
+	{
+		return;
+	}
+	uint64_t nr = buffer[0];
+	for (size_t i = 0; i < nr; ++i)
+	{
+		for (size_t c = 0; c < NUM_PERF_COUNTERS; ++c)
+		{
+			if (state.counter_fds[c] != -1 and state.counter_ids[c] == buffer[2 + (2*i)])
+			{
+				counters[c] = buffer[1 + (2*i)];
+			}
+		}
+	}
+}
+
+
+void add_perf_region_sample(PerfRegion region, uint64_t start_wall_ns, const uint64_t start_counters[NUM_PERF_COUNTERS]){
+	uint64_t wall_ns;
+	uint64_t counters[NUM_PERF_COUNTERS];
+	read_perf_counters(wall_ns, counters);
+
+	PerfRegionStats& stats = _perf_thread_state.stats[region];
+	stats.calls++;
+	stats.wall_ns += wall_ns - start_wall_ns;
+	for (size_t c = 0; c < NUM_PERF_COUNTERS; ++c)
+	{
+		stats.counters[c] += counters[c] - start_counters[c];
+	}
+}
+
+
+PerfRegionStats get_perf_region_stats(PerfRegion region){
+	std::lock_guard<std::mutex> lock(_perf_mutex);
+	PerfRegionStats res = _perf_exited_thread_stats[region];
+	merge_perf_region_stats(res, _perf_thread_state.stats[region]);
+	return res;
+}
+
+
+void print_perf_stats(FILE* out_file){
+	fprintf(out_file, "%-16s\t%10s\t%12s", "region", "calls", "wall_ms");
+	for (size_t c = 0; c < NUM_PERF_COUNTERS; ++c)
+	{
+		if (_perf_counter_available[c])
+		{
+			fprintf(out_file, "\t%14s", PERF_COUNTER_NAMES[c]);
+		}
+	}
+	bool has_ipc = _perf_counter_available[PERF_COUNTER_CYCLES] and _perf_counter_available[PERF_COUNTER_INSTRUCTIONS];
+	if (has_ipc)
+	{
+		fprintf(out_file, "\t%6s", "ipc");
+	}
+	fprintf(out_file, "\n");
+
+	for (size_t r = 0; r < NUM_PERF_REGIONS; ++r)
+	{
+		PerfRegionStats stats = get_perf_region_stats((PerfRegion) r);
+		if (stats.calls == 0)
+		{
+			continue;
+		}
+		fprintf(out_file, "%-16s\t%10lu\t%12.3f", PERF_REGION_NAMES[r], stats.calls, stats.wall_ns / 1E6);
+		for (size_t c = 0; c < NUM_PERF_COUNTERS; ++c)
+		{
+			if (_perf_counter_available[c])
+			{
+				fprintf(out_file, "\t%14lu", stats.counters[c]);
+			}
+		}
+		if (has_ipc)
+		{
+			Float cycles = stats.counters[PERF_COUNTER_CYCLES];
+			fprintf(out_file, "\t%6.2f", cycles > 0 ? stats.counters[PERF_COUNTER_INSTRUCTIONS] / cycles : 0.0);
+		}
+		fprintf(out_file, "\n");
+	}
+	if (_num_available_counters == 0)
+	{
+		fprintf(out_file, "(hardware counters unavailable, timers only)\n");
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include "utils.h"
+#include <atomic>
+#include <cstdint>
+
+
+/*
+The regions of the backend that can be instrumented with hardware performance counters.
+To add a region, add it before NUM_PERF_REGIONS and give it a name in PERF_REGION_NAMES (perf_counters.cc).
+Entering and leaving a region reads the counters with a syscall, so regions wrap whole passes rather than rows or tiles.
+*/
+enum PerfRegion
+{
+	PERF_REGION_DENOMINATORS,
+	PERF_REGION_ALPHAS,
+	PERF_REGION_RATE,
+	PERF_REGION_CACHE_LOAD,
+	NUM_PERF_REGIONS
+};
+
+enum PerfCounter
+{
+	PERF_COUNTER_CYCLES,
+	PERF_COUNTER_INSTRUCTIONS,
+	PERF_COUNTER_CACHE_MISSES,
+	PERF_COUNTER_BRANCH_MISSES,
+	NUM_PERF_COUNTERS
+};
+
+struct PerfRegionStats
+{
+	uint64_t calls = 0;
+	uint64_t wall_ns = 0;
+	uint64_t counters[NUM_PERF_COUNTERS] = {0};
+};
+
+/*
+Turns on the instrumentation for the whole process.
+Tries to open the hardware counters of the calling thread with perf_event_open. Counters that cannot be opened (no PMU
+	access, a restrictive perf_event_paranoid, an unsupported event in a VM...) are reported as unavailable and only the
+	timers are kept. Every other thread opens its own counters when it first enters a region.
+Returns true if at least one hardware counter is available.
+*/
+bool enable_perf_instrumentation();
+
+/*
+Turns on the instrumentation if the environment variable BDC_PERF_STATS is set.
+Returns the path that the stats should be appended to, or NULL if the instrumentation is off.
+*/
+const char* enable_perf_instrumentation_from_env();
+
+extern std::atomic<bool> _perf_instrumentation_enabled;
+
+inline bool perf_instrumentation_enabled(){
+	return _perf_instrumentation_enabled.load(std::memory_order_relaxed);
+}
+
+/*
+Reads the current values of the wall clock and of the hardware counters of the calling thread.
+Unavailable counters are read as 0.
+*/
+void read_perf_counters(uint64_t& wall_ns, uint64_t counters[NUM_PERF_COUNTERS]);
+
+/*
+Adds the difference between the given start values and the current values to the calling thread's stats of the given region.
+*/
+void add_perf_region_sample(PerfRegion region, uint64_t start_wall_ns, const uint64_t start_counters[NUM_PERF_COUNTERS]);
+
+/*
+The stats of the region, summed over the threads that have exited and the calling thread. The engines join their
+	workers before returning, so this covers all of their work. The wall times of the threads are added up.
+*/
+PerfRegionStats get_perf_region_stats(PerfRegion region);
+
+/*
+Prints a table of the per-region counter deltas (and the derived IPC) to the given file, as get_perf_region_stats.
+*/
+void print_perf_stats(FILE* out_file);
+
+
+/*
+Measures the lifetime of the object into the given region.
+Costs a single branch when the instrumentation is off, so it can be left around hot loops.
+Nested regions are inclusive (the outer region also counts the events of the inner ones).
+*/
+class ScopedPerfRegion
+{
+public:
+	inline ScopedPerfRegion(PerfRegion region): _region(region), _active(perf_instrumentation_enabled()) {
+		if (_active)
+		{
+			read_perf_counters(_start_wall_ns, _start_counters);
+		}
+	}
+	inline ~ScopedPerfRegion(){
+		if (_active)
+		{
+			add_perf_region_sample(_region, _start_wall_ns, _start_counters);
+		}
+	}
+	ScopedPerfRegion(const ScopedPerfRegion&) = delete;
+	ScopedPerfRegion& operator= (const ScopedPerfRegion&) = delete;
+
+private:
+	PerfRegion _region;
+	bool _active;
+	uint64_t _start_wall_ns;
+	uint64_t _start_counters[NUM_PERF_COUNTERS];
+};
@@ -0,0 +1,132 @@
+#include "product_distribution.h"
+#include "bit_baa_fast.h"
+#include "codeword_buckets.h"
+#include "numa_placement.h"
+#include <cmath>
+#include <unistd.h>
+
+
+static std::vector<size_t> support_of(const std::vector<Float>& Q_half){
+	std::vector<size_t> support;
+	Float total = 0.0;
+	for (size_t u = 0; u < Q_half.size(); ++u)
+	{
+		assert(Q_half[u] >= 0);
+		total += Q_half[u];
+		if (Q_half[u] > 0)
+		{
+			support.push_back(u);
+		}
+	}
+	assert(std::abs(total - 1.0) < 1E-9);
+	return support;
+}
+
+
+std::vector<std::vector<Float> > compute_half_expected_counts(const ChannelContext& channel, const std::vector<Float>& Q_half,
+	size_t half_len){
+	assert(Q_half.size() == (1ULL << half_len));
+	auto support = support_of(Q_half);
+	size_t max_k = std::min(half_len, channel.out_len());
+	std::vector<std::vector<Float> > res(max_k + 1);
+	for (size_t k = 0; k <= max_k; ++k)
+	{
+		const CacheTable& table = channel.cache_table(half_len, k);
+		assert(table.size() == (1ULL << (half_len + k)));
+		res[k].assign(1ULL << k, 0.0);
+		for (size_t u : support)
+		{
+			const Int* counts = table.data() + (u << k);
+			for (size_t s = 0; s < res[k].size(); ++s)
+			{
+				res[k][s] += Q_half[u] * counts[s];
+			}
+		}
+	}
+	return res;
+}
+
+
+std::vector<Float> compute_product_output_distribution(const ChannelContext& channel, const ProductMixture& Q,
+	const std::vector<EfficientBitCodeWord>& received){
+	assert(Q.weights.size() == Q.components.size());
+	size_t n = channel.in_len();
+	size_t n1 = (n + 1) / 2;
+	size_t n2 = n - n1;
+	std::vector<Float> W(received.size(), 0.0);
+	for (size_t m = 0; m < Q.components.size(); ++m)
+	{
+		auto prefix_counts = compute_half_expected_counts(channel, Q.components[m].prefix, n1);
+		auto suffix_counts = compute_half_expected_counts(channel, Q.components[m].suffix, n2);
+		for (size_t j = 0; j < received.size(); ++j)
+		{
+			size_t k = received[j].len;
+			Float count = 0.0;
+			for (size_t k1 = (k > n2) ? k - n2 : 0; k1 <= std::min(k, n1); ++k1)
+			{
+				size_t k2 = k - k1;
+				uint64_t received_num1 = (received[j].num >> k2) & ((1ULL << k1) - 1);
+				uint64_t received_num2 = received[j].num & ((1ULL << k2) - 1);
+				count += prefix_counts[k1][received_num1] * suffix_counts[k2][received_num2];
+			}
+			W[j] += Q.weights[m] * channel.normalization_factor(n, k) * count;
+		}
+	}
+	return W;
+}
+
+
+ProductRate compute_product_rate(const ChannelContext& channel, const ProductMixture& Q,
+	const std::vector<EfficientBitCodeWord>& received, size_t num_threads){
+	size_t n = channel.in_len();
+	size_t n2 = n - ((n + 1) / 2);
+	ProductRate res;
+
+	auto W = compute_product_output_distribution(channel, Q, received);
+	res.output_entropy = 0.0;
+	for (Float W_j : W)
+	{
+		if (W_j > 0)
+		{
+			res.output_entropy -= W_j * log(W_j);
+		}
+	}
+
+	if (num_threads == 0)
+	{
+		num_threads = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+	}
+	CodewordBucketIndex received_index(received);
+	res.conditional_entropy = 0.0;
+	res.num_rows = 0;
+	for (size_t m = 0; m < Q.components.size(); ++m)
+	{
+		const auto& component = Q.components[m];
+		auto prefix_support = support_of(component.prefix);
+		auto suffix_support = support_of(component.suffix);
+		// The entropy of the rows of every prefix, weighted by the suffix distribution.
+		std::vector<Float> prefix_entropies(prefix_support.size(), 0.0);
+		run_parallel_tasks(num_threads, prefix_support.size(), [&](size_t p){
+			for (size_t u2 : suffix_support)
+			{
+				EfficientBitCodeWord transmitted((prefix_support[p] << n2) | u2, n);
+				Float entropy = 0.0;
+				for (Float P : compute_Pjk_row(channel, transmitted, received, &received_index))
+				{
+					if (P > 0)
+					{
+						entropy -= P * log(P);
+					}
+				}
+				prefix_entropies[p] += component.suffix[u2] * entropy;
+			}
+		});
+		for (size_t p = 0; p < prefix_support.size(); ++p)
+		{
+			res.conditional_entropy += Q.weights[m] * component.prefix[prefix_support[p]] * prefix_entropies[p];
+		}
+		res.num_rows += prefix_support.size() * suffix_support.size();
+	}
+	res.rate = res.output_entropy - res.conditional_entropy;
+	return res;
+}
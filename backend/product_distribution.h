@@ -0,0 +1,67 @@
+#pragma once
+#include "utils.h"
+#include "bit_channel.h"
+
+
+/*
+Input distributions that factorise over the two halves of the transmitted codeword, split as in the split cache
+	(get_num_transition_possibilities_using_cache_fast): the prefix has n1 = (in_len + 1) / 2 bits and the suffix the
+	other n2 = in_len - n1. As
+		count(t, r) = sum_{k1} count(t[:n1], r[:k1]) * count(t[n1:], r[k1:]),
+	the expected count under a product distribution is the same convolution over the split points of the received
+	codeword of the expected counts of the halves, which only take a pass over the split cache tables of the halves.
+	So W is computed without ever enumerating the 2^in_len transmitted codewords.
+*/
+
+
+struct ProductInputDistribution
+{
+	// Q(t) = prefix[t >> n2] * suffix[t & (2^n2 - 1)], the halves indexed by their bits (as the codeword numbers are).
+	// Each half sums to 1.
+	std::vector<Float> prefix;
+	std::vector<Float> suffix;
+};
+
+/*
+A mixture sum_m weights[m] * components[m] of product distributions (e.g. a product of codes and its shifts).
+*/
+struct ProductMixture
+{
+	std::vector<Float> weights;
+	std::vector<ProductInputDistribution> components;
+};
+
+/*
+The expected counts of a half: res[k][s] = sum_u Q_half[u] * count(u, s) for every word s of length k <= min(half_len,
+	out_len), read off the split cache table of (half_len, k) of the channel.
+*/
+std::vector<std::vector<Float> > compute_half_expected_counts(const ChannelContext& channel, const std::vector<Float>& Q_half,
+	size_t half_len);
+
+/*
+The output distribution W(r) = sum_t Q(t) P(r | t) of the received codewords, for a channel of the length of the
+	mixture's codewords.
+*/
+std::vector<Float> compute_product_output_distribution(const ChannelContext& channel, const ProductMixture& Q,
+	const std::vector<EfficientBitCodeWord>& received);
+
+struct ProductRate
+{
+	// I(Q; W) = H(W) - H(W | Q), in nats (the units of compute_bit_rate_efficient).
+	Float rate;
+	Float output_entropy;
+	Float conditional_entropy;
+	// The number of transmitted rows that were evaluated for the conditional entropy.
+	size_t num_rows;
+};
+
+/*
+The exact rate of the mixture on the received alphabet.
+The output entropy comes from the convolution. The conditional entropy sum_t Q(t) H(P_t) does not factorise, so it takes a
+	row of the transition table for every pair of halves in the supports of each component. This costs |supp prefix| *
+	|supp suffix| rows per component, which is far below 2^in_len for the sparse halves (codes) it is meant for.
+The rows are split between num_threads threads (0 means all of the online cores) and summed in a fixed order, so the
+	result does not depend on the number of threads.
+*/
+ProductRate compute_product_rate(const ChannelContext& channel, const ProductMixture& Q,
+	const std::vector<EfficientBitCodeWord>& received, size_t num_threads = 0);
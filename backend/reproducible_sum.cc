@@ -0,0 +1,89 @@
+#include "reproducible_sum.h"
+
+constexpr int CANONICAL_DIGITS = REPRODUCIBLE_SUM_DIGITS + 2;
+
+
+/*
+Carries the limbs (least significant last) into digits of REPRODUCIBLE_SUM_DIGIT_BITS bits (least significant first).
+The two extra digits take the carries out of the top limb. Returns false if the sum is negative.
+*/
+static bool carry_limbs(const int64_t limbs[REPRODUCIBLE_SUM_DIGITS], uint64_t digits[CANONICAL_DIGITS]){
+	const __int128 mask = (1ULL << REPRODUCIBLE_SUM_DIGIT_BITS) - 1;
+	__int128 carry = 0;
+	for (int d = 0; d < CANONICAL_DIGITS; ++d)
+	{
+		__int128 total = carry + ((d < REPRODUCIBLE_SUM_DIGITS) ? limbs[REPRODUCIBLE_SUM_DIGITS - 1 - d] : 0);
+		digits[d] = (uint64_t) (total & mask);
+		carry = total >> REPRODUCIBLE_SUM_DIGIT_BITS;
+	}
+	// |limbs| < 2^63, so whatever is left is the sign.
+	return carry == 0;
+}
+
+
+Float ReproducibleSum::value() const{
+	if (top < 0)
+	{
+		return 0.0;
+	}
+	uint64_t digits[CANONICAL_DIGITS];
+	Float sign = 1.0;
+	if (not carry_limbs(limbs, digits))
+	{
+		int64_t negated[REPRODUCIBLE_SUM_DIGITS];
+		for (int d = 0; d < REPRODUCIBLE_SUM_DIGITS; ++d)
+		{
+			negated[d] = -limbs[d];
+		}
+		assert(carry_limbs(negated, digits));
+		sign = -1.0;
+	}
+
+	int lead = CANONICAL_DIGITS - 1;
+	while (lead >= 0 and digits[lead] == 0)
+	{
+		--lead;
+	}
+	if (lead < 0)
+	{
+		return 0.0;
+	}
+	// The three digits from the leading one hold at least 61 significant bits. Rounding them to 64 bits, with the rest
+	// 	folded into a sticky bit, and then to a double rounds the exact sum correctly.
+	unsigned __int128 window = 0;
+	bool sticky = false;
+	for (int d = lead; d >= lead - 2; --d)
+	{
+		window = (window << REPRODUCIBLE_SUM_DIGIT_BITS) | ((d >= 0) ? digits[d] : 0);
+	}
+	for (int d = lead - 3; d >= 0; --d)
+	{
+		sticky |= (digits[d] != 0);
+	}
+	uint64_t window_high = (uint64_t) (window >> 64);
+	int window_bits = (window_high != 0) ? 128 - __builtin_clzll(window_high) : 64 - __builtin_clzll((uint64_t) window);
+	int shift = std::max(0, window_bits - 64);
+	sticky |= (window & ((((unsigned __int128) 1) << shift) - 1)) != 0;
+	uint64_t mantissa = (uint64_t) (window >> shift) | (uint64_t) sticky;
+
+	// The least significant bit of the window is the digit lead - 2 of the canonical digits, i.e. the digit
+	// 	top - REPRODUCIBLE_SUM_DIGITS + 1 + lead - 2 of the expansion.
+	int exponent = REPRODUCIBLE_SUM_DIGIT_BITS * (top - REPRODUCIBLE_SUM_DIGITS + lead - 1) + shift - 1074;
+	return sign * ldexp((Float) mantissa, exponent);
+}
+
+
+std::vector<ReproducibleSum> load_reproducible_sums_from_file(FILE* in_file){
+	uint32_t shape;
+	assert(fread(&shape, sizeof(shape), 1, in_file) == 1);
+	std::vector<ReproducibleSum> sums(shape);
+	assert(fread(sums.data(), sizeof(ReproducibleSum), shape, in_file) == shape);
+	return sums;
+}
+
+
+void write_reproducible_sums_to_file(FILE* out_file, const std::vector<ReproducibleSum>& sums){
+	uint32_t shape = (uint32_t) sums.size();
+	fwrite(&shape, sizeof(shape), 1, out_file);
+	assert(fwrite(sums.data(), sizeof(ReproducibleSum), shape, out_file) == shape);
+}
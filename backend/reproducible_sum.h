@@ -0,0 +1,105 @@
+#pragma once
+#include "utils.h"
+#include <cassert>
+#include <cstring>
+
+
+/*
+An order independent sum of doubles, so that the denominators and the rate come out bitwise identical for every split of
+	the transmitted codewords into shards (and every order in which the shards are merged).
+Every term is cut into digits of REPRODUCIBLE_SUM_DIGIT_BITS bits at fixed positions of the binary exponent range, and
+	the digits are added as integers, which is exact and associative. Only the REPRODUCIBLE_SUM_DIGITS digits below (and
+	including) the digit of the leading bit of the largest term are kept: the terms are truncated to that grid, which
+	depends on the largest term alone. This keeps at least 90 bits below the leading bit of the largest term, so the
+	truncation costs less than 2^-60 of it even for 2^30 terms.
+The digits are only carried into each other when the sum is rounded (to the nearest double), so a single sum can take
+	up to 2^33 terms (or merged sums).
+*/
+constexpr int REPRODUCIBLE_SUM_DIGIT_BITS = 30;
+constexpr int REPRODUCIBLE_SUM_DIGITS = 4;
+
+struct ReproducibleSum
+{
+	// The index of the most significant digit, where the digit i holds the bits [30i, 30i + 30) of the binary expansion
+	// 	in units of the smallest subnormal (2^-1074). -1 for an empty sum.
+	int32_t top = -1;
+	// limbs[d] is the sum of the digits of index top - d of the terms.
+	int64_t limbs[REPRODUCIBLE_SUM_DIGITS] = {0};
+
+	/*
+	Adds a finite term.
+	*/
+	inline void add(Float x){
+		uint64_t bits;
+		memcpy(&bits, &x, sizeof(bits));
+		uint64_t biased_exponent = (bits >> 52) & 0x7ff;
+		uint64_t mantissa = bits & ((1ULL << 52) - 1);
+		if (biased_exponent == 0 and mantissa == 0)
+		{
+			return;
+		}
+		// The position of the least significant bit of the mantissa, in units of 2^-1074.
+		int lsb = 0;
+		if (biased_exponent != 0)
+		{
+			mantissa |= 1ULL << 52;
+			lsb = (int) biased_exponent - 1;
+		}
+		int lead_digit = (lsb + 63 - __builtin_clzll(mantissa)) / REPRODUCIBLE_SUM_DIGIT_BITS;
+		raise_top(lead_digit);
+		int first_digit = lsb / REPRODUCIBLE_SUM_DIGIT_BITS;
+		unsigned __int128 shifted = (unsigned __int128) mantissa << (lsb % REPRODUCIBLE_SUM_DIGIT_BITS);
+		int64_t sign = (bits >> 63) ? -1 : 1;
+		for (int digit = std::max(first_digit, top - REPRODUCIBLE_SUM_DIGITS + 1); digit <= lead_digit; ++digit)
+		{
+			uint64_t value = (uint64_t) (shifted >> (REPRODUCIBLE_SUM_DIGIT_BITS * (digit - first_digit)));
+			limbs[top - digit] += sign * (int64_t) (value & ((1ULL << REPRODUCIBLE_SUM_DIGIT_BITS) - 1));
+		}
+	}
+
+	/*
+	Adds the terms of another sum (the result is the same as adding all of its terms one by one).
+	*/
+	inline void add(const ReproducibleSum& other){
+		if (other.top < 0)
+		{
+			return;
+		}
+		raise_top(other.top);
+		for (int d = 0; d < REPRODUCIBLE_SUM_DIGITS; ++d)
+		{
+			int digit = other.top - d;
+			if (digit > top - REPRODUCIBLE_SUM_DIGITS)
+			{
+				limbs[top - digit] += other.limbs[d];
+			}
+		}
+	}
+
+	/*
+	The sum rounded to the nearest double.
+	*/
+	Float value() const;
+
+private:
+	inline void raise_top(int new_top){
+		if (new_top <= top)
+		{
+			return;
+		}
+		int shift = new_top - top;
+		for (int d = REPRODUCIBLE_SUM_DIGITS - 1; d >= 0; --d)
+		{
+			limbs[d] = (d >= shift) ? limbs[d - shift] : 0;
+		}
+		top = new_top;
+	}
+};
+
+
+/*
+The partial sums of the shards are passed between the processes in files of their own (a uint32 count followed by the
+	sums).
+*/
+std::vector<ReproducibleSum> load_reproducible_sums_from_file(FILE* in_file);
+void write_reproducible_sums_to_file(FILE* out_file, const std::vector<ReproducibleSum>& sums);
@@ -0,0 +1,222 @@
+#include "resource_planner.h"
+#include "bit_channel.h"
+#include "cache_io.h"
+#include <unistd.h>
+
+// A rough cost of a single (random) cache table lookup, including the surrounding combine loop.
+constexpr Float NS_PER_CACHE_LOOKUP = 1.5;
+
+const char* execution_strategy_name(ExecutionStrategy strategy){
+	switch (strategy)
+	{
+	case STRATEGY_STORE_P:
+		return "store_P";
+	case STRATEGY_RECOMPUTE_P:
+		return "recompute_P";
+	default:
+		return "impossible";
+	}
+}
+
+
+size_t get_available_memory_bytes(){
+	FILE* meminfo = fopen("/proc/meminfo", "r");
+	if (meminfo != NULL)
+	{
+		char line[256];
+		while (fgets(line, sizeof(line), meminfo))
+		{
+			size_t kb;
+			if (sscanf(line, "MemAvailable: %lu kB", &kb) == 1)
+			{
+				fclose(meminfo);
+				return kb * 1024;
+			}
+		}
+		fclose(meminfo);
+	}
+	return (size_t) sysconf(_SC_PHYS_PAGES) * (size_t) sysconf(_SC_PAGE_SIZE);
+}
+
+
+/*
+The number of ways to split a received codeword of length k between the two halves of a transmitted codeword of length n
+	(i.e. the number of iterations of get_num_transition_possibilities_using_cache_fast that are not skipped).
+*/
+static size_t num_valid_splits(size_t n, size_t k){
+	size_t n1 = (n+1) / 2;
+	size_t n2 = n - n1;
+	size_t lowest = (k > n2) ? k - n2 : 0;
+	size_t highest = std::min(k, n1);
+	return (highest >= lowest) ? highest - lowest + 1 : 0;
+}
+
+
+static size_t per_worker_bytes(const ResourcePlan& plan, size_t shard_size){
+	size_t codeword_bytes = sizeof(EfficientBitCodeWord);
+	size_t res = plan.cache_table_bytes;
+	res += (plan.in_len + 1) * (plan.out_len + 1) * sizeof(Float);
+	// The codewords are read with push_back, so the vectors may hold up to twice their size while loading.
+	res += 2 * (shard_size + plan.num_received) * codeword_bytes;
+	// The whole Q array is loaded before the shard is copied out of it.
+	res += (plan.num_transmitted + shard_size) * sizeof(Float);
+	// The denominators, a row / column of P_jk and the output array.
+	res += 2 * plan.num_received * sizeof(Float);
+	res += 2 * std::max(shard_size, plan.num_received) * sizeof(Float);
+	return res;
+}
+
+
+static size_t shared_bytes(const ResourcePlan& plan, size_t num_workers){
+	// The driver keeps the current and next Q, their log-ratio and the alphas, and merges num_workers denominator arrays
+	// 	(concatenated and exponentiated, so three copies of them).
+	return (4 * plan.num_transmitted * sizeof(Float)) + (3 * num_workers * plan.num_received * sizeof(Float)) +
+		(plan.num_received * sizeof(Float));
+}
+
+
+static ResourcePlan refuse(ResourcePlan plan, const char* reason){
+	plan.strategy = STRATEGY_IMPOSSIBLE;
+	plan.num_workers = 0;
+	plan.num_shards = 0;
+	plan.threads_per_worker = 0;
+	plan.refusal_reason = reason;
+	return plan;
+}
+
+
+ResourcePlan plan_baa_resources(size_t in_len, size_t out_len, bool up_to, size_t max_workers, size_t memory_budget_bytes){
+	ResourcePlan plan;
+	plan.in_len = in_len;
+	plan.out_len = out_len;
+	plan.up_to = up_to;
+	plan.refusal_reason = "";
+	plan.available_memory_bytes = (memory_budget_bytes > 0) ? memory_budget_bytes : get_available_memory_bytes();
+	plan.available_cores = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+	if (max_workers == 0)
+	{
+		max_workers = plan.available_cores;
+	}
+
+	plan.num_transmitted = (in_len > 0 and in_len < 64) ? (1ULL << (in_len - 1)) : 0;
+	plan.num_received = (out_len < 63) ? (up_to ? (1ULL << (out_len + 1)) - 1 : (1ULL << out_len)) : 0;
+	plan.cache_table_bytes = 0;
+	plan.num_missing_cache_tables = 0;
+	plan.pair_evaluations_per_iteration = 0.0;
+	plan.cache_lookups_per_iteration = 0.0;
+	plan.estimated_core_seconds_per_iteration = 0.0;
+	plan.per_worker_bytes = 0;
+	plan.per_worker_stored_P_bytes = 0;
+	plan.shared_bytes = 0;
+	plan.estimated_seconds_per_iteration = 0.0;
+
+	if (in_len == 0 or in_len >= 64)
+	{
+		return refuse(plan, "in_len must be between 1 and 63 (the codewords are stored in a uint64_t)");
+	}
+	if (out_len >= 63)
+	{
+		return refuse(plan, "out_len must be smaller than 63");
+	}
+	if (((in_len + 1) / 2) >= MAX_BIT_CACHE_SIZE or out_len >= MAX_BIT_CACHE_SIZE)
+	{
+		return refuse(plan, "the halves of the codewords are longer than MAX_BIT_CACHE_SIZE");
+	}
+	// The table of (n1, k1) has 2^(n1 + k1) entries, so all of them together have fewer than 2^(n1 + k1 + 2) for the
+	// 	largest n1 and k1. This is checked in floating point: well below MAX_BIT_CACHE_SIZE, the sizes of the tables no
+	// 	longer fit in a uint64_t.
+	if (ldexp((Float) sizeof(Int), (in_len + 1) / 2 + out_len + 2) >= ldexp(1.0, 63))
+	{
+		return refuse(plan, "the transition count tables are too large to be addressed");
+	}
+
+	// The tables loaded by initialize_bit_channel:
+	for (size_t n1 = 0; n1 <= (in_len + 1) / 2; ++n1)
+	{
+		for (size_t k1 = 0; k1 <= out_len; ++k1)
+		{
+			plan.cache_table_bytes += (1ULL << (n1 + k1)) * sizeof(Int);
+			if (access(get_cache_filename(n1, k1).data(), R_OK) != 0)
+			{
+				plan.num_missing_cache_tables++;
+			}
+		}
+	}
+
+	// Every iteration computes all of P_jk twice (once for the denominators and once for the alphas).
+	Float num_pairs = ((Float) plan.num_transmitted) * plan.num_received;
+	plan.pair_evaluations_per_iteration = 2 * num_pairs;
+	Float lookups_per_pair = 2.0 * num_valid_splits(in_len, out_len);
+	if (up_to)
+	{
+		// Average over the received lengths, weighted by the number of received codewords of each length.
+		lookups_per_pair = 0.0;
+		for (size_t k = 0; k <= out_len; ++k)
+		{
+			lookups_per_pair += 2.0 * num_valid_splits(in_len, k) * ((Float) (1ULL << k)) / plan.num_received;
+		}
+	}
+	plan.cache_lookups_per_iteration = plan.pair_evaluations_per_iteration * lookups_per_pair;
+	plan.estimated_core_seconds_per_iteration = plan.cache_lookups_per_iteration * NS_PER_CACHE_LOOKUP * 1E-9;
+
+	// Use as many workers as fit in memory.
+	size_t num_workers = std::min(max_workers, plan.num_transmitted);
+	for (; num_workers > 0; --num_workers)
+	{
+		size_t shard_size = (plan.num_transmitted + num_workers - 1) / num_workers;
+		if (shared_bytes(plan, num_workers) + (num_workers * per_worker_bytes(plan, shard_size)) <= plan.available_memory_bytes)
+		{
+			break;
+		}
+	}
+	size_t shard_size = (plan.num_transmitted + std::max(num_workers, 1UL) - 1) / std::max(num_workers, 1UL);
+	plan.per_worker_bytes = per_worker_bytes(plan, shard_size);
+	plan.per_worker_stored_P_bytes = shard_size * plan.num_received * sizeof(Float);
+	plan.shared_bytes = shared_bytes(plan, std::max(num_workers, 1UL));
+	if (plan.num_missing_cache_tables > 0)
+	{
+		return refuse(plan, "some of the transition count tables are missing (run generate_cache_tables.py)");
+	}
+	if (num_workers == 0)
+	{
+		return refuse(plan, "a single worker does not fit in the available memory");
+	}
+
+	plan.num_workers = num_workers;
+	plan.num_shards = num_workers;
+	plan.threads_per_worker = std::max(1UL, plan.available_cores / num_workers);
+	size_t total_with_stored_P = plan.shared_bytes + (num_workers * (plan.per_worker_bytes + plan.per_worker_stored_P_bytes));
+	plan.strategy = (total_with_stored_P <= plan.available_memory_bytes) ? STRATEGY_STORE_P : STRATEGY_RECOMPUTE_P;
+	plan.estimated_seconds_per_iteration = plan.estimated_core_seconds_per_iteration / num_workers;
+	return plan;
+}
+
+
+void print_resource_plan(FILE* out_file, const ResourcePlan& plan){
+	const Float MB = 1024.0 * 1024.0;
+	fprintf(out_file, "in_len = %lu\n", plan.in_len);
+	fprintf(out_file, "out_len = %lu\n", plan.out_len);
+	fprintf(out_file, "up_to = %d\n", plan.up_to);
+	fprintf(out_file, "num_transmitted = %lu\n", plan.num_transmitted);
+	fprintf(out_file, "num_received = %lu\n", plan.num_received);
+	fprintf(out_file, "cache_table_mb = %.2f\n", plan.cache_table_bytes / MB);
+	fprintf(out_file, "missing_cache_tables = %lu\n", plan.num_missing_cache_tables);
+	fprintf(out_file, "per_worker_mb = %.2f\n", plan.per_worker_bytes / MB);
+	fprintf(out_file, "per_worker_stored_P_mb = %.2f\n", plan.per_worker_stored_P_bytes / MB);
+	fprintf(out_file, "shared_mb = %.2f\n", plan.shared_bytes / MB);
+	fprintf(out_file, "pair_evaluations_per_iteration = %.4g\n", plan.pair_evaluations_per_iteration);
+	fprintf(out_file, "cache_lookups_per_iteration = %.4g\n", plan.cache_lookups_per_iteration);
+	fprintf(out_file, "estimated_core_seconds_per_iteration = %.4g\n", plan.estimated_core_seconds_per_iteration);
+	fprintf(out_file, "available_memory_mb = %.2f\n", plan.available_memory_bytes / MB);
+	fprintf(out_file, "available_cores = %lu\n", plan.available_cores);
+	fprintf(out_file, "strategy = %s\n", execution_strategy_name(plan.strategy));
+	if (plan.strategy == STRATEGY_IMPOSSIBLE)
+	{
+		fprintf(out_file, "reason = %s\n", plan.refusal_reason);
+		return;
+	}
+	fprintf(out_file, "num_workers = %lu\n", plan.num_workers);
+	fprintf(out_file, "num_shards = %lu\n", plan.num_shards);
+	fprintf(out_file, "threads_per_worker = %lu\n", plan.threads_per_worker);
+	fprintf(out_file, "estimated_seconds_per_iteration = %.4g\n", plan.estimated_seconds_per_iteration);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "utils.h"
+#include <cstdint>
+
+
+/*
+The ways a BAA run can evaluate the transition probabilities on every iteration.
+*/
+enum ExecutionStrategy
+{
+	// Every worker keeps the P_jk entries of its shard in memory after the first pass.
+	STRATEGY_STORE_P,
+	// The P_jk entries are recomputed from the cache tables in every pass (what the slave currently does).
+	STRATEGY_RECOMPUTE_P,
+	// No number of workers fits in the available memory.
+	STRATEGY_IMPOSSIBLE
+};
+
+const char* execution_strategy_name(ExecutionStrategy strategy);
+
+/*
+The predicted resource usage of a distributed BAA run on (in_len, out_len, up_to), and the recommended way to run it.
+All sizes are in bytes.
+*/
+struct ResourcePlan
+{
+	size_t in_len;
+	size_t out_len;
+	bool up_to;
+
+	// The alphabet sizes as produced by gen_codewords (the transmitted one is reduced by the NOT symmetry).
+	size_t num_transmitted;
+	size_t num_received;
+
+	// The transition count tables loaded by initialize_bit_channel (loaded separately by every worker).
+	size_t cache_table_bytes;
+	// Cache tables that initialize_bit_channel will try to load but are missing from the transition_counts folder.
+	size_t num_missing_cache_tables;
+
+	// Memory used by a single slave process working on a shard of num_transmitted / num_shards codewords.
+	size_t per_worker_bytes;
+	// The P_jk entries of a single shard, if they were to be stored.
+	size_t per_worker_stored_P_bytes;
+	// Memory held by the python driver regardless of the number of workers (Q vectors, merged denominators...).
+	size_t shared_bytes;
+
+	// The number of (transmitted, received) pairs evaluated in a single BAA iteration (denominators + alphas).
+	Float pair_evaluations_per_iteration;
+	// The number of cache table lookups in a single BAA iteration and the resulting (rough) single core runtime.
+	Float cache_lookups_per_iteration;
+	Float estimated_core_seconds_per_iteration;
+
+	size_t available_memory_bytes;
+	size_t available_cores;
+
+	// The recommendation.
+	ExecutionStrategy strategy;
+	size_t num_workers;
+	size_t num_shards;
+	size_t threads_per_worker;
+	Float estimated_seconds_per_iteration;
+	// A human readable explanation when strategy == STRATEGY_IMPOSSIBLE.
+	const char* refusal_reason;
+};
+
+/*
+Returns the amount of memory the planner may use by default (MemAvailable from /proc/meminfo, or the physical memory).
+*/
+size_t get_available_memory_bytes();
+
+/*
+Computes the resource plan for the given channel.
+If max_workers is 0, then all the online cores may be used. If memory_budget_bytes is 0 then get_available_memory_bytes() is used.
+*/
+ResourcePlan plan_baa_resources(size_t in_len, size_t out_len, bool up_to, size_t max_workers = 0, size_t memory_budget_bytes = 0);
+
+/*
+Prints the plan as "key = value" lines which are easy to read both by a person and by the python driver.
+*/
+void print_resource_plan(FILE* out_file, const ResourcePlan& plan);
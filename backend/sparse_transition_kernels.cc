@@ -0,0 +1,299 @@
+#include "sparse_transition_kernels.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+
+static inline uint8_t get_bit(uint64_t num, size_t len, size_t pos){
+	// The first bit of the codeword is its most significant bit.
+	return (num >> (len - 1 - pos)) & 1;
+}
+
+
+static inline bool find_codeword(const EfficientBitCodeWord* alphabet, size_t size, const EfficientBitCodeWord& word,
+	size_t& index){
+	const EfficientBitCodeWord* found = std::lower_bound(alphabet, alphabet + size, word);
+	if (found == alphabet + size or found->num != word.num or found->len != word.len)
+	{
+		return false;
+	}
+	index = found - alphabet;
+	return true;
+}
+
+
+struct SubsequenceSearch
+{
+	size_t n;
+	size_t k;
+	uint8_t bits[64];
+	// next_occurrence[b][p] is the first position >= p that holds the bit b (n if there is none).
+	size_t next_occurrence[2][65];
+	// ways[d * n + q] is the number of embeddings of the current prefix of length d + 1 that end at position q.
+	std::vector<uint64_t> ways;
+	const EfficientBitCodeWord* received;
+	size_t num_received;
+	std::vector<SparseTransitionCount>* out;
+
+	/*
+	Extends the current prefix (of the given length, with its leftmost embedding ending at position leftmost) by
+		every bit that still leaves enough positions for the rest of the subsequence.
+	*/
+	void extend(size_t depth, uint64_t prefix, size_t leftmost){
+		if (depth == k)
+		{
+			uint64_t count = 0;
+			const uint64_t* current = ways.data() + (depth - 1) * n;
+			for (size_t q = leftmost; q < n; ++q)
+			{
+				count += current[q];
+			}
+			size_t index;
+			if (find_codeword(received, num_received, EfficientBitCodeWord(prefix, k), index))
+			{
+				out->push_back(SparseTransitionCount{index, count});
+			}
+			return;
+		}
+		size_t start = (depth == 0) ? 0 : leftmost + 1;
+		// The last position the next bit can take and still leave room for the remaining k - depth - 1 bits:
+		size_t last = n - (k - depth);
+		for (uint8_t bit = 0; bit < 2; ++bit)
+		{
+			size_t first = next_occurrence[bit][start];
+			if (first > last)
+			{
+				continue;
+			}
+			uint64_t* next = ways.data() + depth * n;
+			if (depth == 0)
+			{
+				for (size_t q = first; q <= last; ++q)
+				{
+					next[q] = (bits[q] == bit) ? 1 : 0;
+				}
+			} else{
+				// Every embedding of the prefix that ends before q extends to an embedding ending at q.
+				const uint64_t* current = ways.data() + (depth - 1) * n;
+				uint64_t ending_before = 0;
+				for (size_t q = leftmost; q < first; ++q)
+				{
+					ending_before += current[q];
+				}
+				for (size_t q = first; q <= last; ++q)
+				{
+					next[q] = (bits[q] == bit) ? ending_before : 0;
+					ending_before += current[q];
+				}
+			}
+			for (size_t q = last + 1; q < n; ++q)
+			{
+				next[q] = 0;
+			}
+			extend(depth + 1, (prefix << 1) | bit, first);
+		}
+	}
+};
+
+
+void enumerate_subsequence_counts(const EfficientBitCodeWord& transmitted, size_t k,
+	const EfficientBitCodeWord* received, size_t num_received, std::vector<SparseTransitionCount>& out){
+	size_t n = transmitted.len;
+	if (k > n or num_received == 0)
+	{
+		return;
+	}
+	if (k == 0)
+	{
+		size_t index;
+		if (find_codeword(received, num_received, EfficientBitCodeWord(0, 0), index))
+		{
+			out.push_back(SparseTransitionCount{index, 1});
+		}
+		return;
+	}
+	SubsequenceSearch search;
+	search.n = n;
+	search.k = k;
+	for (size_t q = 0; q < n; ++q)
+	{
+		search.bits[q] = get_bit(transmitted.num, n, q);
+	}
+	search.next_occurrence[0][n] = search.next_occurrence[1][n] = n;
+	for (size_t q = n; q-- > 0;)
+	{
+		search.next_occurrence[0][q] = (search.bits[q] == 0) ? q : search.next_occurrence[0][q + 1];
+		search.next_occurrence[1][q] = (search.bits[q] == 1) ? q : search.next_occurrence[1][q + 1];
+	}
+	search.ways.resize(k * n);
+	search.received = received;
+	search.num_received = num_received;
+	search.out = &out;
+	search.extend(0, 0, 0);
+}
+
+
+struct SupersequenceSearch
+{
+	size_t n;
+	size_t k;
+	uint8_t bits[64];
+	// ways[pos * (k + 1) + j] is the number of embeddings of the first j bits of the received codeword in the first
+	// 	pos bits of the current supersequence.
+	std::vector<uint64_t> ways;
+	const EfficientBitCodeWord* transmitted;
+	size_t num_transmitted;
+	std::vector<SparseTransitionCount>* out;
+
+	/*
+	Extends the current prefix of the supersequence (of length pos, whose longest embedded prefix of the received
+		codeword has length matched) by both bits, as long as the rest of the received codeword still fits.
+	*/
+	void extend(size_t pos, uint64_t prefix, size_t matched){
+		const uint64_t* current = ways.data() + pos * (k + 1);
+		if (pos == n)
+		{
+			size_t index;
+			if (find_codeword(transmitted, num_transmitted, EfficientBitCodeWord(prefix, n), index))
+			{
+				out->push_back(SparseTransitionCount{index, current[k]});
+			}
+			return;
+		}
+		uint64_t* next = ways.data() + (pos + 1) * (k + 1);
+		for (uint8_t bit = 0; bit < 2; ++bit)
+		{
+			size_t next_matched = matched;
+			next[0] = current[0];
+			for (size_t j = 1; j <= k; ++j)
+			{
+				next[j] = current[j] + ((bits[j - 1] == bit) ? current[j - 1] : 0);
+				if (next[j] != 0)
+				{
+					next_matched = std::max(next_matched, j);
+				}
+			}
+			if (k - next_matched > n - pos - 1)
+			{
+				continue;
+			}
+			extend(pos + 1, (prefix << 1) | bit, next_matched);
+		}
+	}
+};
+
+
+void enumerate_supersequence_counts(const EfficientBitCodeWord& received, size_t n,
+	const EfficientBitCodeWord* transmitted, size_t num_transmitted, std::vector<SparseTransitionCount>& out){
+	size_t k = received.len;
+	if (k > n or num_transmitted == 0)
+	{
+		return;
+	}
+	SupersequenceSearch search;
+	search.n = n;
+	search.k = k;
+	for (size_t j = 0; j < k; ++j)
+	{
+		search.bits[j] = get_bit(received.num, k, j);
+	}
+	search.ways.assign((n + 1) * (k + 1), 0);
+	search.ways[0] = 1;
+	search.transmitted = transmitted;
+	search.num_transmitted = num_transmitted;
+	search.out = &out;
+	search.extend(0, 0, 0);
+}
+
+
+// The cost of a step of the searches (or of a step of the binary search of a leaf) relative to a lookup of the dense
+// 	combine, measured on (14, k) rows.
+constexpr Float SPARSE_STEP_COST = 2.0;
+
+
+static Float binomial(size_t n, size_t k){
+	Float res = 1.0;
+	for (size_t i = 0; i < std::min(k, n - k); ++i)
+	{
+		res = res * (n - i) / (i + 1);
+	}
+	return res;
+}
+
+
+// The number of table lookups the dense combine spends on a single pair.
+static Float num_splits(size_t n, size_t k){
+	size_t n1 = (n + 1) / 2;
+	size_t n2 = n - n1;
+	size_t lowest = (k > n2) ? k - n2 : 0;
+	size_t highest = std::min(k, n1);
+	return 2.0 * (highest - lowest + 1);
+}
+
+
+static Float sparse_row_cost(size_t n, size_t k){
+	// The nodes on level j of the search are distinct subsequences of length j of the first n - k + j bits, and
+	// 	every node costs O(n - k). Every leaf is looked up with a binary search.
+	Float num_nodes = 0.0;
+	for (size_t j = 0; j <= k; ++j)
+	{
+		num_nodes += std::min(binomial(n - k + j, j), (Float) std::pow(2.0, j));
+	}
+	Float num_leaves = std::min(binomial(n, k), (Float) std::pow(2.0, k));
+	return SPARSE_STEP_COST * ((n - k + 1) * num_nodes + k * num_leaves);
+}
+
+
+static Float sparse_column_cost(size_t n, size_t k){
+	// A word of length k has sum_{i <= n - k} (n choose i) supersequences of length n, which bounds the number of
+	// 	nodes on every level of the search. Every node costs O(k) (and a leaf also a binary search).
+	Float num_leaves = 0.0;
+	for (size_t i = 0; i <= n - k; ++i)
+	{
+		num_leaves += binomial(n, i);
+	}
+	Float num_nodes = 0.0;
+	for (size_t pos = 1; pos <= n; ++pos)
+	{
+		num_nodes += std::min(num_leaves, (Float) std::pow(2.0, pos));
+	}
+	return SPARSE_STEP_COST * ((k + 1) * num_nodes + n * num_leaves);
+}
+
+
+typedef std::array<std::array<Float, MAX_KERNEL_WORD_LEN + 1>, MAX_KERNEL_WORD_LEN + 1> SparseCostTable;
+
+/*
+The minimal size of a run of codewords for which the sparse kernel is expected to be faster, per (n, k) bucket
+	(infinite where the sparse kernel does not apply).
+*/
+static const SparseCostTable& sparse_break_even(bool column){
+	static const std::array<SparseCostTable, 2> tables = [](){
+		std::array<SparseCostTable, 2> res;
+		for (size_t n = 0; n <= MAX_KERNEL_WORD_LEN; ++n)
+		{
+			for (size_t k = 0; k <= MAX_KERNEL_WORD_LEN; ++k)
+			{
+				if (k > n)
+				{
+					res[0][n][k] = res[1][n][k] = INFINITY;
+					continue;
+				}
+				res[0][n][k] = sparse_row_cost(n, k) / num_splits(n, k);
+				res[1][n][k] = sparse_column_cost(n, k) / num_splits(n, k);
+			}
+		}
+		return res;
+	}();
+	return tables[column];
+}
+
+
+bool prefer_sparse_row(size_t n, size_t k, size_t run_size){
+	return n <= MAX_KERNEL_WORD_LEN and k <= MAX_KERNEL_WORD_LEN and run_size > sparse_break_even(false)[n][k];
+}
+
+
+bool prefer_sparse_column(size_t n, size_t k, size_t run_size){
+	return n <= MAX_KERNEL_WORD_LEN and k <= MAX_KERNEL_WORD_LEN and run_size > sparse_break_even(true)[n][k];
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "utils.h"
+#include "bit_channel.h"
+
+
+/*
+Kernels that enumerate only the nonzero transition counts of a row or a column of the transition table, instead of
+	evaluating every pair and discarding the zeros. When the received length is close to the transmitted length most
+	pairs have no transitions at all, and the work of these kernels scales with the number of nonzeros.
+Both kernels look the enumerated codewords up in an alphabet sorted with operator< (as all of the alphabets of the
+	engine are) and emit the positions they are found at, together with the number of ways of the transition
+	(the same quantity as get_num_transition_possibilities).
+*/
+struct SparseTransitionCount
+{
+	size_t index;
+	uint64_t count;
+};
+
+/*
+Enumerates the distinct subsequences of length k of the transmitted codeword with their number of embeddings, by a
+	depth first search over the next occurrence of each bit (so every distinct subsequence is visited exactly once).
+Appends an entry for every subsequence that appears in received[0, num_received), which must all have length k.
+*/
+void enumerate_subsequence_counts(const EfficientBitCodeWord& transmitted, size_t k,
+	const EfficientBitCodeWord* received, size_t num_received, std::vector<SparseTransitionCount>& out);
+
+/*
+Enumerates the supersequences of length n of the received codeword with their number of embeddings of the received
+	codeword, by a depth first search over the bits of the supersequence that prunes the prefixes that can no longer
+	contain it.
+Appends an entry for every supersequence that appears in transmitted[0, num_transmitted), which must all have length n.
+*/
+void enumerate_supersequence_counts(const EfficientBitCodeWord& received, size_t n,
+	const EfficientBitCodeWord* transmitted, size_t num_transmitted, std::vector<SparseTransitionCount>& out);
+
+/*
+Whether enumerating the subsequences is expected to be cheaper than evaluating a run of run_size received codewords of
+	length k for a transmitted codeword of length n (and the same for the supersequences of a received codeword of
+	length k against a run of run_size transmitted codewords of length n).
+*/
+bool prefer_sparse_row(size_t n, size_t k, size_t run_size);
+bool prefer_sparse_column(size_t n, size_t k, size_t run_size);
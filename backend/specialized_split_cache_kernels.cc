@@ -0,0 +1,72 @@
+#include "transition_kernels.h"
+#include <utility>
+
+/*
+The split cache combine (get_num_transition_possibilities_using_cache_fast) with the lengths as template parameters:
+	the lengths of the halves, the masks and the range of valid splits are compile time constants, so the loop over
+	the splits is fully unrolled and has no bounds checks.
+*/
+
+template <size_t LEN>
+constexpr uint64_t LOW_BITS = (LEN >= 64) ? ~0ULL : ((1ULL << LEN) - 1);
+
+
+template <size_t N, size_t K, size_t K1>
+inline size_t combine_split(uint64_t trans_num1, uint64_t trans_num2, uint64_t rec_num){
+	constexpr size_t N1 = (N + 1) / 2;
+	constexpr size_t N2 = N - N1;
+	constexpr size_t K2 = K - K1;
+	const Int* table1 = cached_transition_probs[N1][K1].data();
+	const Int* table2 = cached_transition_probs[N2][K2].data();
+	uint64_t rec_num1 = rec_num >> K2;
+	uint64_t rec_num2 = rec_num & LOW_BITS<K2>;
+	return ((size_t) table1[(trans_num1 << K1) ^ rec_num1]) * table2[(trans_num2 << K2) ^ rec_num2];
+}
+
+
+template <size_t N, size_t K, size_t LOWEST, size_t... I>
+inline size_t combine_all_splits(uint64_t trans_num1, uint64_t trans_num2, uint64_t rec_num, std::index_sequence<I...>){
+	return (combine_split<N, K, LOWEST + I>(trans_num1, trans_num2, rec_num) + ... + 0);
+}
+
+
+template <size_t N, size_t K>
+size_t count_transitions_specialized_split_cache(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord& recieved){
+	if constexpr (K > N)
+	{
+		return 0;
+	} else{
+		constexpr size_t N1 = (N + 1) / 2;
+		constexpr size_t N2 = N - N1;
+		// The splits k1 + k2 = K with k1 <= N1 and k2 <= N2:
+		constexpr size_t LOWEST = (K > N2) ? K - N2 : 0;
+		constexpr size_t HIGHEST = std::min(K, N1);
+		uint64_t trans_num1 = transmitted.num >> N2;
+		uint64_t trans_num2 = transmitted.num & LOW_BITS<N2>;
+		return combine_all_splits<N, K, LOWEST>(trans_num1, trans_num2, recieved.num,
+			std::make_index_sequence<HIGHEST - LOWEST + 1>());
+	}
+}
+
+
+typedef std::array<TransitionCountKernel, MAX_SPECIALIZED_KERNEL_LEN + 1> SpecializedKernelRow;
+
+template <size_t N, size_t... K>
+constexpr SpecializedKernelRow make_specialized_kernel_row(std::index_sequence<K...>){
+	return SpecializedKernelRow{count_transitions_specialized_split_cache<N, K>...};
+}
+
+template <size_t... N>
+constexpr std::array<SpecializedKernelRow, MAX_SPECIALIZED_KERNEL_LEN + 1> make_specialized_kernel_table(std::index_sequence<N...>){
+	return {make_specialized_kernel_row<N>(std::make_index_sequence<MAX_SPECIALIZED_KERNEL_LEN + 1>())...};
+}
+
+// Constant initialized, so it can be used while initializing the other dispatch tables.
+static constexpr std::array<SpecializedKernelRow, MAX_SPECIALIZED_KERNEL_LEN + 1> SPECIALIZED_KERNELS =
+	make_specialized_kernel_table(std::make_index_sequence<MAX_SPECIALIZED_KERNEL_LEN + 1>());
+
+
+TransitionCountKernel get_specialized_split_cache_kernel(size_t n, size_t k){
+	assert(n <= MAX_SPECIALIZED_KERNEL_LEN and k <= MAX_SPECIALIZED_KERNEL_LEN);
+	return SPECIALIZED_KERNELS[n][k];
+}
@@ -0,0 +1,131 @@
+#include "baa.h"
+#include "bit_baa.h"
+#include "bit_baa_fast.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+/*
+A BAA step straight from the rows of the transition table, with the denominators averaged over the received pairs if
+	average_received_pairs is set.
+*/
+std::vector<Float> reference_step(const std::vector<std::vector<Float> >& rows, const std::vector<Float>& Q,
+	bool average_received_pairs){
+	size_t num_received = rows[0].size();
+	std::vector<Float> den(num_received, 0.0);
+	for (size_t i = 0; i < rows.size(); ++i)
+	{
+		for (size_t j = 0; j < num_received; ++j)
+		{
+			den[j] += Q[i] * rows[i][j];
+		}
+	}
+	if (average_received_pairs)
+	{
+		for (size_t j = 0; j < num_received; j += 2)
+		{
+			den[j] = den[j + 1] = (den[j] + den[j + 1]) / 2;
+		}
+	}
+	std::vector<Float> alphas(rows.size(), 0.0);
+	Float max_log_alpha = -INFINITY;
+	for (size_t i = 0; i < rows.size(); ++i)
+	{
+		for (size_t j = 0; j < num_received; ++j)
+		{
+			if (rows[i][j] >= BAA_ALPHA_THRESHOLD)
+			{
+				alphas[i] += rows[i][j] * (log(Q[i]) + log(rows[i][j]) - log(den[j]));
+			}
+		}
+		max_log_alpha = std::max(max_log_alpha, alphas[i]);
+	}
+	Float total = 0.0;
+	for (auto& alpha : alphas)
+	{
+		alpha = exp(alpha - max_log_alpha);
+		total += alpha;
+	}
+	for (auto& alpha : alphas)
+	{
+		alpha /= total;
+	}
+	return alphas;
+}
+
+
+void assert_close(const std::vector<Float>& a, const std::vector<Float>& b){
+	assert(a.size() == b.size());
+	for (size_t i = 0; i < a.size(); ++i)
+	{
+		assert(std::abs(a[i] - b[i]) <= 1E-12 * std::max(a[i], b[i]));
+	}
+}
+
+
+int main()
+{
+	Float deletion_probability = 0.3;
+	constexpr size_t in_len = 8;
+	constexpr size_t out_len = 5;
+	initialize_channel(deletion_probability);
+	initialize_bit_channel(deletion_probability, in_len, out_len, false);
+	const ChannelContext& channel = default_channel_context();
+
+	auto by_number = [](const BitCodeWord& a, const BitCodeWord& b){ return EfficientBitCodeWord(a) < EfficientBitCodeWord(b); };
+	auto transmitted_bits = get_all_bit_codewords(in_len);
+	std::sort(transmitted_bits.begin(), transmitted_bits.end(), by_number);
+	auto received_bits = get_all_bit_codewords(out_len);
+	std::sort(received_bits.begin(), received_bits.end(), by_number);
+	std::vector<EfficientBitCodeWord> transmitted(transmitted_bits.begin(), transmitted_bits.end());
+	std::vector<EfficientBitCodeWord> received(received_bits.begin(), received_bits.end());
+	std::vector<CodeWord> transmitted_runs, received_runs;
+	for (const auto& word : transmitted_bits)
+	{
+		transmitted_runs.push_back(convert_to_run_word(word));
+	}
+	for (const auto& word : received_bits)
+	{
+		received_runs.push_back(convert_to_run_word(word));
+	}
+
+	// Every representation runs the same step as the reference on its own rows.
+	std::vector<Float> Q(transmitted.size());
+	for (size_t i = 0; i < Q.size(); ++i)
+	{
+		Q[i] = (1.0 + (i % 7)) / (4.0 * Q.size());
+	}
+	std::vector<std::vector<Float> > run_rows, bit_rows, efficient_rows;
+	for (size_t i = 0; i < transmitted.size(); ++i)
+	{
+		run_rows.push_back(compute_Pjk_row(transmitted_runs[i], received_runs));
+		bit_rows.push_back(compute_Pjk_row(transmitted_bits[i], received_bits));
+		efficient_rows.push_back(compute_Pjk_row(channel, transmitted[i], received));
+	}
+	assert_close(do_full_baa_step(transmitted_runs, received_runs, Q), reference_step(run_rows, Q, false));
+	assert_close(do_full_baa_step(transmitted_bits, received_bits, Q), reference_step(bit_rows, Q, false));
+	assert_close(do_full_baa_step(channel, transmitted, received, Q), reference_step(efficient_rows, Q, true));
+	printf("The BAA engine runs the same step on every representation.\n");
+
+	// The bit representations describe the same channel, so from a distribution that is symmetric under NOT (where the
+	// 	pair averaging changes nothing) they follow the same BAA, and give the same rate.
+	std::vector<Float> Q_bits(transmitted.size(), 1.0 / transmitted.size());
+	std::vector<Float> Q_efficient = Q_bits;
+	for (size_t iteration = 0; iteration < 10; ++iteration)
+	{
+		Q_bits = do_full_baa_step(transmitted_bits, received_bits, Q_bits);
+		Q_efficient = do_full_baa_step(channel, transmitted, received, Q_efficient);
+		assert_close(Q_bits, Q_efficient);
+	}
+	Float bit_rate = compute_bit_rate_efficient(transmitted_bits, received_bits,
+		compute_all_log_Wjk_den(transmitted_bits, received_bits, Q_bits), Q_bits);
+	Float efficient_rate = compute_bit_rate_efficient(channel, transmitted, received,
+		compute_all_log_Wjk_den(channel, transmitted, received, Q_efficient), Q_efficient);
+	printf("Rates: %.15f (BitCodeWord), %.15f (EfficientBitCodeWord)\n", bit_rate, efficient_rate);
+	assert(std::abs(bit_rate - efficient_rate) < 1E-12);
+	assert(std::abs(compute_rate(transmitted_bits, received_bits, Q_bits) - bit_rate) < 1E-12);
+	assert(std::abs(compute_rate(channel, transmitted, received, Q_efficient) - efficient_rate) < 1E-12);
+	printf("The bit representations follow the same BAA.\n");
+	return 0;
+}
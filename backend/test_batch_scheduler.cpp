@@ -0,0 +1,105 @@
+#include "batch_scheduler.h"
+#include "bit_baa_fast.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+int main()
+{
+	// Two groups: a long one of cheap jobs and a short one of expensive jobs.
+	std::vector<BatchJob> jobs;
+	for (size_t i = 0; i < 12; ++i)
+	{
+		jobs.push_back(BatchJob{8, 5, 0.05 * ((i * 7) % 12 + 1), true, jobs.size()});
+	}
+	for (size_t i = 0; i < 3; ++i)
+	{
+		jobs.push_back(BatchJob{10, 6, 0.1 * (3 - i), false, jobs.size()});
+	}
+	auto job_cost = [](const BatchJob& job){ return (Float) (1ULL << job.in_len); };
+	for (size_t num_threads : {1, 2, 4, 16})
+	{
+		auto chains = plan_batch(jobs, num_threads, job_cost);
+		Float total_cost = 0;
+		std::vector<size_t> seen(jobs.size(), 0);
+		for (size_t c = 0; c < chains.size(); ++c)
+		{
+			const auto& chain = chains[c];
+			assert(not chain.jobs.empty());
+			assert(c == 0 or chains[c - 1].predicted_cost >= chain.predicted_cost);
+			Float cold_cost = job_cost(chain.jobs.front());
+			assert(chain.predicted_cost == cold_cost * (1 + WARM_START_COST_FRACTION * (chain.jobs.size() - 1)));
+			for (size_t j = 0; j < chain.jobs.size(); ++j)
+			{
+				const auto& job = chain.jobs[j];
+				++seen[job.index];
+				assert(job.in_len == chain.jobs.front().in_len and job.out_len == chain.jobs.front().out_len);
+				assert(j == 0 or chain.jobs[j - 1].deletion_prob <= job.deletion_prob);
+			}
+			total_cost += chain.predicted_cost;
+		}
+		assert(std::all_of(seen.begin(), seen.end(), [](size_t count){ return count == 1; }));
+		// Without cutting, the grid would take as long as its slowest chain (12 cheap jobs in a row).
+		if (num_threads == 1)
+		{
+			assert(chains.size() == 2);
+		}
+		else{
+			Float bound = std::max(total_cost / num_threads, (Float) (1 << 10));
+			for (const auto& chain : chains)
+			{
+				assert(chain.predicted_cost <= bound + job_cost(chain.jobs.front()));
+			}
+		}
+	}
+	printf("The grid is cut into chains that fit the cores.\n");
+
+	// Every job gets the same distribution as a BAA run on its own (from the distribution its chain hands it).
+	std::vector<BatchJob> grid = {{8, 5, 0.3, true, 0}, {8, 5, 0.1, true, 1}, {8, 5, 0.2, true, 2}, {9, 5, 0.2, false, 3}};
+	BatchOptions options;
+	options.num_threads = 2;
+	options.accuracy = 0.01;
+	// Bitwise comparable with do_full_baa_step (the quotient channel is tested in test_channel_quotient).
+	options.merge_equivalent_codewords = false;
+	std::vector<BatchResult> results(grid.size());
+	std::vector<size_t> order;
+	run_batch(grid, options, [&](const BatchResult& result){
+		results[result.job.index] = result;
+		order.push_back(result.job.index);
+	});
+	assert(order.size() == grid.size());
+	for (const auto& result : results)
+	{
+		assert(result.distance < options.accuracy);
+		assert(result.rate > 0 and std::isfinite(result.rate));
+	}
+	// Only the heads of the chains start cold, and a chain runs in the order of the deletion probabilities.
+	for (const auto& chain : plan_batch(grid, options.num_threads))
+	{
+		for (size_t j = 0; j < chain.jobs.size(); ++j)
+		{
+			assert(results[chain.jobs[j].index].warm_started == (j > 0));
+			assert(j == 0 or std::find(order.begin(), order.end(), chain.jobs[j - 1].index) <
+				std::find(order.begin(), order.end(), chain.jobs[j].index));
+		}
+	}
+	assert(not results[1].warm_started);
+
+	initialize_bit_channel(0.1, 8, 5, true);
+	auto all_codewords = get_all_bit_codewords(8, false);
+	std::vector<EfficientBitCodeWord> transmitted(all_codewords.begin(), all_codewords.end());
+	std::sort(transmitted.begin(), transmitted.end());
+	transmitted = get_transmitted_codewords_symmetries(transmitted);
+	all_codewords = get_all_bit_codewords(5, true);
+	std::vector<EfficientBitCodeWord> received(all_codewords.begin(), all_codewords.end());
+	std::sort(received.begin(), received.end());
+	std::vector<Float> Q(transmitted.size(), 1.0 / transmitted.size());
+	for (size_t i = 0; i < results[1].num_iterations; ++i)
+	{
+		Q = do_full_baa_step(default_channel_context(), transmitted, received, Q);
+	}
+	assert(Q == results[1].Q);
+	printf("The scheduled BAA runs match the BAA.\n");
+	return 0;
+}
@@ -16,6 +16,7 @@ int main()
 	constexpr size_t in_len = 15;
 	constexpr size_t out_len = 5;
 	initialize_bit_channel(deletion_probability, in_len, out_len, false);
+	const ChannelContext& channel = default_channel_context();
 
 	auto transmitted_codewords = get_all_bit_codewords(in_len);
 	std::sort(transmitted_codewords.begin(), transmitted_codewords.end(), 
@@ -63,7 +64,7 @@ int main()
 
 			// auto rate = compute_rate(transmitted_codewords_efficient, received_codewords_efficient, Q);
 			// printf("The current rate is %f\n", rate);
-			auto log_dens = compute_all_log_Wjk_den(transmitted_codewords_efficient, received_codewords_efficient, Q);
+			auto log_dens = compute_all_log_Wjk_den(channel, transmitted_codewords_efficient, received_codewords_efficient, Q);
 			std::vector<Float> dens; dens.resize(log_dens.size());
 			for (size_t j = 0; j < dens.size(); ++j)
 			{
@@ -71,11 +72,11 @@ int main()
 			}
 			printf("sum(dens)=%f\n", std::accumulate(dens.begin(), dens.end(), 0.0));
 			printf("sum(Q)=%f\n", std::accumulate(Q.begin(), Q.end(), 0.0));
-			Float rate2 = compute_bit_rate_efficient(transmitted_codewords_efficient, received_codewords_efficient, log_dens, Q);
+			Float rate2 = compute_bit_rate_efficient(channel, transmitted_codewords_efficient, received_codewords_efficient, log_dens, Q);
 			printf("Efficient rate computation: %f\n", rate2 / log(2));
 			// assert(std::abs(rate-rate2) < 1E-6);
 		}
-		Q = do_full_baa_step(transmitted_codewords_efficient, received_codewords_efficient, Q);
+		Q = do_full_baa_step(channel, transmitted_codewords_efficient, received_codewords_efficient, Q);
 		// Q2 = do_full_baa_step(transmitted_codewords, received_codewords, Q2);
 	}
 	return 0;
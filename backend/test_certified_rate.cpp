@@ -0,0 +1,102 @@
+#include "certified_rate.h"
+#include "bit_baa_fast.h"
+#include "dual_bound.h"
+#include <cassert>
+#include <cmath>
+#include <random>
+
+
+bool contains(const Interval& interval, Float x, Float slack = 0.0){
+	return interval.lo - slack <= x and x <= interval.hi + slack;
+}
+
+
+void check_interval_arithmetic(){
+	std::mt19937_64 rng(3);
+	std::uniform_real_distribution<Float> uniform(-1.0, 1.0);
+	for (Float x : {0.0, 1.0, -1.0, 0.1, 1E-310, -1E-310, 4.9E-324, DBL_MAX, -DBL_MAX})
+	{
+		assert(round_down(x) < x and x < round_up(x));
+	}
+	// Sums and products of doubles are exact in long double as long as they are short.
+	Interval sum = exact_interval(0.0);
+	long double exact_sum = 0.0;
+	for (size_t i = 0; i < 1000; ++i)
+	{
+		Float x = uniform(rng);
+		sum = interval_add(sum, exact_interval(x));
+		exact_sum += x;
+		Float y = uniform(rng);
+		Interval product = interval_mul(exact_interval(x), exact_interval(y));
+		assert(product.lo <= (long double) x * y and (long double) x * y <= product.hi);
+		Interval log_interval = interval_log(exact_interval(std::abs(x)));
+		assert(log_interval.lo < log((long double) std::abs(x)) and log((long double) std::abs(x)) < log_interval.hi);
+	}
+	assert(sum.lo <= exact_sum and exact_sum <= sum.hi);
+	assert(sum.hi - sum.lo < 1E-10);
+}
+
+
+void check_certified_rate(size_t in_len, size_t out_len, bool up_to){
+	Float deletion_probability = 0.2;
+	initialize_bit_channel(deletion_probability, in_len, out_len, up_to);
+	const ChannelContext& channel = default_channel_context();
+	auto transmitted = get_transmitted_codewords_symmetries(get_sorted_bit_codewords(in_len, false));
+	auto received = get_sorted_bit_codewords(out_len, up_to);
+
+	for (size_t k = 0; k <= out_len; ++k)
+	{
+		Interval factor = certified_normalization_factor(channel, in_len, k);
+		assert(contains(factor, channel.normalization_factor(in_len, k), 1E-15 * factor.hi));
+		assert(factor.hi - factor.lo <= 1E-13 * factor.hi);
+	}
+
+	std::vector<Float> Q(transmitted.size(), 1.0 / transmitted.size());
+	for (size_t iteration = 0; iteration < 20; ++iteration)
+	{
+		Q = do_full_baa_step(channel, transmitted, received, Q);
+	}
+	auto log_den = compute_all_log_Wjk_den(channel, transmitted, received, Q);
+	Float rate = compute_bit_rate_efficient(channel, transmitted, received, log_den, Q);
+
+	auto certified = certify_rate(channel, transmitted, received, Q, 1);
+	printf("(%lu, %lu, %d): rate %.15f in [%.15f, %.15f], bound in [%.15f, %.15f]\n", in_len, out_len, (int) up_to, rate,
+		certified.rate.lo, certified.rate.hi, certified.max_divergence.lo, certified.max_divergence.hi);
+	// The regular rate drops the entries below 1E-20, and its factors are rounded.
+	assert(contains(certified.rate, rate, 1E-12));
+	assert(certified.rate.hi - certified.rate.lo < 1E-11);
+	assert(certified.rate.hi <= certified.max_divergence.hi);
+
+	// The dual bound of the output distribution of Q.
+	std::vector<Float> R(received.size(), 0.0);
+	for (size_t i = 0; i < transmitted.size(); ++i)
+	{
+		auto row = compute_Pjk_row(channel, transmitted[i], received);
+		for (size_t j = 0; j < received.size(); ++j)
+		{
+			R[j] += Q[i] * row[j];
+		}
+	}
+	DualBoundOptions options;
+	options.num_maximisers = 1;
+	auto dual_bound = compute_dual_bound(channel, transmitted, received, R, options);
+	assert(contains(certified.max_divergence, dual_bound.bound, 1E-12));
+	assert(certified.max_divergence.hi - certified.max_divergence.lo < 1E-11);
+
+	// The intervals do not depend on the number of threads.
+	auto certified_threads = certify_rate(channel, transmitted, received, Q, 4);
+	assert(certified_threads.rate.lo == certified.rate.lo and certified_threads.rate.hi == certified.rate.hi);
+	assert(certified_threads.max_divergence.hi == certified.max_divergence.hi);
+	assert(certified_threads.maximiser == certified.maximiser);
+}
+
+
+int main()
+{
+	check_interval_arithmetic();
+	printf("The intervals contain the exact results.\n");
+	check_certified_rate(10, 6, false);
+	check_certified_rate(11, 7, true);
+	printf("The certified intervals contain the regular rates and dual bounds.\n");
+	return 0;
+}
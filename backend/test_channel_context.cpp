@@ -0,0 +1,78 @@
+#include "bit_channel.h"
+#include "bit_baa_fast.h"
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+
+struct BAAResult
+{
+	std::vector<Float> log_den;
+	std::vector<Float> log_alpha;
+	Float rate;
+};
+
+
+BAAResult run_baa_step(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted,
+	const std::vector<EfficientBitCodeWord>& received){
+	std::vector<Float> Q(transmitted.size(), 1.0 / transmitted.size());
+	BAAResult result;
+	result.log_den = compute_all_log_Wjk_den(channel, transmitted, received, Q);
+	result.log_alpha = compute_all_log_alpha_k(channel, transmitted, received, Q, result.log_den);
+	result.rate = compute_bit_rate_efficient(channel, transmitted, received, result.log_den, Q);
+	return result;
+}
+
+
+bool operator==(const BAAResult& a, const BAAResult& b){
+	return a.log_den == b.log_den and a.log_alpha == b.log_alpha and a.rate == b.rate;
+}
+
+
+int main()
+{
+	size_t in_len = 12;
+	size_t out_len = 8;
+	auto transmitted = get_transmitted_codewords_symmetries(get_sorted_bit_codewords(in_len));
+	auto received = get_sorted_bit_codewords_of_lengths(1, out_len);
+
+	// The default context is the one that initialize_bit_channel sets up.
+	initialize_bit_channel(0.3, in_len, out_len, true);
+	ChannelContext channel_a(0.3, in_len, out_len, true);
+	ChannelContext channel_b(0.5, in_len, out_len, true);
+	ChannelContext channel_c(0.5, in_len, out_len, false);
+	assert(run_baa_step(default_channel_context(), transmitted, received) == run_baa_step(channel_a, transmitted, received));
+
+	// The contexts share the transition count tables.
+	assert(&channel_a.cache_table(6, 4) == &channel_b.cache_table(6, 4));
+	assert(&channel_a.cache_table(6, 4) == &default_channel_context().cache_table(6, 4));
+
+	// Several configurations can be evaluated at once, with the same results as one after the other.
+	std::vector<const ChannelContext*> channels = {&channel_a, &channel_b, &channel_c, &channel_b};
+	std::vector<BAAResult> sequential;
+	for (const ChannelContext* channel : channels)
+	{
+		sequential.push_back(run_baa_step(*channel, transmitted, received));
+	}
+	assert(not (sequential[0] == sequential[1]));
+	assert(not (sequential[1] == sequential[2]));
+
+	std::vector<BAAResult> concurrent(channels.size());
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < channels.size(); ++i)
+	{
+		threads.emplace_back([&, i](){
+			concurrent[i] = run_baa_step(*channels[i], transmitted, received);
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	for (size_t i = 0; i < channels.size(); ++i)
+	{
+		assert(concurrent[i] == sequential[i]);
+	}
+	printf("The channel contexts can be evaluated concurrently.\n");
+	return 0;
+}
@@ -0,0 +1,63 @@
+#include "channel_quotient.h"
+#include <cassert>
+#include <cmath>
+
+
+void check_quotient(size_t in_len, size_t out_len, bool up_to){
+	Float deletion_probability = 0.2;
+	initialize_bit_channel(deletion_probability, in_len, out_len, up_to);
+	const ChannelContext& channel = default_channel_context();
+	auto transmitted = get_transmitted_codewords_symmetries(get_sorted_bit_codewords(in_len, false));
+	auto received = get_sorted_bit_codewords(out_len, up_to);
+	auto quotient = compute_channel_quotient(transmitted, received, in_len, out_len, up_to);
+	printf("(%lu, %lu, %d): %lu transmitted classes out of %lu, %lu received out of %lu\n", in_len, out_len, (int) up_to,
+		quotient.transmitted_representatives.size(), transmitted.size(), quotient.received_representatives.size(), received.size());
+
+	// The members of a class have the same row as its representative.
+	for (size_t i = 0; i < transmitted.size(); ++i)
+	{
+		const auto& representative = quotient.transmitted_representatives[quotient.transmitted_class[i]];
+		assert(compute_Pjk_row(channel, transmitted[i], received) == compute_Pjk_row(channel, representative, received));
+	}
+	// Different classes have different rows.
+	for (size_t c = 1; c < quotient.transmitted_representatives.size(); ++c)
+	{
+		assert(compute_Pjk_row(channel, quotient.transmitted_representatives[c - 1], received) !=
+			compute_Pjk_row(channel, quotient.transmitted_representatives[c], received));
+	}
+
+	// The BAA on the quotient follows the BAA on the whole channel.
+	std::vector<Float> Q(transmitted.size(), 1.0 / transmitted.size());
+	auto Q_classes = merge_transmitted_distribution(quotient, Q);
+	for (size_t iteration = 0; iteration < 5; ++iteration)
+	{
+		auto log_den = compute_all_log_Wjk_den(channel, transmitted, received, Q);
+		auto quotient_log_den = compute_quotient_log_Wjk_den(channel, quotient, received, Q_classes);
+		for (size_t j = 0; j < received.size(); ++j)
+		{
+			assert(std::abs(log_den[j] - quotient_log_den[j]) < 1E-12);
+		}
+		Float rate = compute_bit_rate_efficient(channel, transmitted, received, log_den, Q);
+		Float quotient_rate = compute_bit_rate_efficient(channel, quotient.transmitted_representatives, received, quotient_log_den, Q_classes);
+		assert(std::abs(rate - quotient_rate) < 1E-12);
+
+		Q = do_full_baa_step(channel, transmitted, received, Q);
+		Q_classes = do_quotient_baa_step(channel, quotient, received, Q_classes);
+		auto expanded = expand_transmitted_distribution(quotient, Q_classes);
+		for (size_t i = 0; i < Q.size(); ++i)
+		{
+			assert(std::abs(Q[i] - expanded[i]) <= 1E-12 * Q[i]);
+		}
+	}
+}
+
+
+int main()
+{
+	// Short received codewords leave many transmitted codewords with the same subsequence counts.
+	check_quotient(10, 2, false);
+	check_quotient(12, 3, false);
+	check_quotient(10, 6, true);
+	printf("The BAA on the quotient channel follows the BAA on the whole channel.\n");
+	return 0;
+}
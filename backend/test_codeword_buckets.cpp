@@ -0,0 +1,82 @@
+#include "bit_channel.h"
+#include "bit_baa_fast.h"
+#include "transition_kernels.h"
+#include "codeword_buckets.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+int main()
+{
+	// The tests must never reject a pair with a nonzero count, and should reject a good share of the zeros.
+	size_t num_zeros = 0, num_rejected = 0;
+	for (size_t n = 0; n <= 10; ++n)
+	{
+		auto transmitted = get_sorted_bit_codewords(n);
+		auto received = get_sorted_bit_codewords_of_lengths(0, n);
+		CodewordBucketIndex received_index(received);
+		CodewordBucketIndex transmitted_index(transmitted);
+		for (const auto& trans : transmitted)
+		{
+			for (size_t k = 0; k <= n; ++k)
+			{
+				std::vector<size_t> reachable;
+				size_t run_size = received_index.collect_reachable(trans, k, reachable);
+				assert(run_size == (1ULL << k));
+				assert(reachable.size() == received_index.count_reachable(trans, k));
+				assert(std::is_sorted(reachable.begin(), reachable.end()));
+				size_t r = 0;
+				for (size_t j = 0; j < received.size(); ++j)
+				{
+					if (received[j].len != k)
+					{
+						continue;
+					}
+					bool passes = (r < reachable.size() and reachable[r] == j);
+					r += passes;
+					size_t count = count_transitions_dynamic_programming(trans, received[j]);
+					assert(passes == may_transition(codeword_signature(trans), n, codeword_signature(received[j]), k));
+					assert(passes or count == 0);
+					num_zeros += (count == 0);
+					num_rejected += not passes;
+				}
+				assert(r == reachable.size());
+			}
+		}
+		for (const auto& rec : received)
+		{
+			std::vector<size_t> sources;
+			transmitted_index.collect_sources(rec, n, sources);
+			for (size_t i = 0, s = 0; i < transmitted.size(); ++i)
+			{
+				bool passes = (s < sources.size() and sources[s] == i);
+				s += passes;
+				assert(passes or count_transitions_dynamic_programming(transmitted[i], rec) == 0);
+			}
+		}
+	}
+	printf("The weight and run tests rejected %lu of %lu impossible pairs.\n", num_rejected, num_zeros);
+	assert(num_rejected * 2 > num_zeros);
+
+	// The rows and columns of the engine are the same with and without the index.
+	Float deletion_probability = 0.3;
+	size_t in_len = 14;
+	size_t out_len = 10;
+	initialize_bit_channel(deletion_probability, in_len, out_len, true);
+	const ChannelContext& channel = default_channel_context();
+	auto transmitted = get_transmitted_codewords_symmetries(get_sorted_bit_codewords(in_len));
+	auto received = get_sorted_bit_codewords_of_lengths(0, out_len);
+	CodewordBucketIndex received_index(received);
+	CodewordBucketIndex transmitted_index(transmitted);
+	for (size_t i = 0; i < transmitted.size(); i += 31)
+	{
+		assert(compute_Pjk_row(channel, transmitted[i], received) == compute_Pjk_row(channel, transmitted[i], received, &received_index));
+	}
+	for (size_t j = 0; j < received.size(); j += 17)
+	{
+		assert(compute_Pjk_col(channel, transmitted, received[j]) == compute_Pjk_col(channel, transmitted, received[j], &transmitted_index));
+	}
+	printf("The bucketed rows and columns agree with the full ones.\n");
+	return 0;
+}
@@ -0,0 +1,112 @@
+#include "bit_channel.h"
+#include "deletion_channel_simulator.h"
+#include <cassert>
+#include <cmath>
+#include <map>
+
+
+/*
+Compares the empirical distribution of the received codewords of a single transmitted codeword to the exact transition
+	probabilities of the channel set up by initialize_bit_channel with the same parameters.
+*/
+void check_simulator(Float deletion_probability, size_t in_len, size_t out_len, bool up_to){
+	constexpr size_t num_samples = 1 << 18;
+	initialize_bit_channel(deletion_probability, in_len, out_len, up_to);
+	EfficientBitCodeWord transmitted(0xb5 & ((1ULL << in_len) - 1), in_len);
+	auto channel = make_deletion_channel_simulator(deletion_probability, in_len, out_len, up_to, 1234);
+
+	std::vector<EfficientBitCodeWord> transmitted_batch(num_samples, transmitted);
+	std::vector<EfficientBitCodeWord> received_batch(num_samples, EfficientBitCodeWord(0, 0));
+	simulate_deletion_channel_batch(channel, transmitted_batch.data(), received_batch.data(), num_samples, 0);
+
+	std::map<std::pair<size_t, uint64_t>, size_t> counts;
+	for (size_t i = 0; i < num_samples; ++i)
+	{
+		// The batch API must agree with transmitting the codewords one at a time.
+		auto single = simulate_deletion_channel(channel, transmitted, i);
+		assert(single.num == received_batch[i].num and single.len == received_batch[i].len);
+		counts[std::make_pair(received_batch[i].len, received_batch[i].num)]++;
+	}
+
+	Float tvd = 0.0;
+	for (size_t k = 0; k <= std::min(out_len, in_len); ++k)
+	{
+		if (not up_to and k != out_len)
+		{
+			continue;
+		}
+		for (uint64_t num = 0; num < (1ULL << k); ++num)
+		{
+			Float expected = get_bit_transition_prob_fast(transmitted, EfficientBitCodeWord(num, k));
+			Float empirical = ((Float) counts[std::make_pair(k, num)]) / num_samples;
+			tvd += std::abs(expected - empirical) / 2;
+		}
+	}
+	printf("deletion_probability=%.2f in_len=%lu out_len=%lu up_to=%d: TVD=%f\n", deletion_probability, in_len, out_len, up_to, tvd);
+	assert(tvd < 0.01);
+}
+
+
+int main()
+{
+	for (uint64_t mask : {0x0ULL, 0x1ULL, 0x8000000000000000ULL, 0xf0f0f0f0f0f0f0f0ULL, 0x123456789abcdefULL})
+	{
+		uint64_t word = 0xdeadbeefcafebabeULL;
+		uint64_t expected = 0;
+		size_t out_bit = 0;
+		for (size_t i = 0; i < 64; ++i)
+		{
+			if ((mask >> i) & 1)
+			{
+				expected |= ((word >> i) & 1) << (out_bit++);
+			}
+		}
+		assert(extract_bits(word, mask) == expected);
+	}
+
+	// The masks are the same at every width, and the wide extraction matches the bit by bit one.
+	for (size_t in_len : {(size_t) 8, (size_t) 64, (size_t) 100, (size_t) 200})
+	{
+		for (bool up_to : {true, false})
+		{
+			auto channel = make_deletion_channel_simulator(0.3, in_len, up_to ? in_len / 2 : in_len / 3, up_to, 99);
+			MultiWord<4> word;
+			for (size_t i = 0; i < 4; ++i)
+			{
+				word.words[i] = counter_rng(7, i, 0);
+			}
+			for (uint64_t sample = 0; sample < 256; ++sample)
+			{
+				auto mask = simulate_keep_mask<MultiWord<4> >(channel, sample);
+				assert((mask & ~low_bits_mask<MultiWord<4> >(in_len)) == MultiWord<4>(0));
+				if (in_len <= 128)
+				{
+					auto mask128 = simulate_keep_mask<unsigned __int128>(channel, sample);
+					assert((uint64_t) mask128 == mask.words[0] and (uint64_t) (mask128 >> 64) == mask.words[1]);
+				}
+				if (in_len <= 64)
+				{
+					assert(simulate_keep_mask(channel, sample) == mask.words[0]);
+				}
+				MultiWord<4> expected;
+				size_t out_bit = 0;
+				for (size_t i = 0; i < 256; ++i)
+				{
+					if (low_word(mask >> i) & 1)
+					{
+						expected = expected | (MultiWord<4>(low_word(word >> i) & 1) << (out_bit++));
+					}
+				}
+				assert(extract_word_bits(word, mask) == expected);
+				assert(simulate_deletion_channel(channel, BitCodeWord256(word & low_bits_mask<MultiWord<4> >(in_len), in_len), sample).len == out_bit);
+			}
+		}
+	}
+
+	check_simulator(0.3, 8, 8, true);
+	check_simulator(0.5, 8, 8, true);
+	check_simulator(0.3, 8, 4, true);
+	check_simulator(0.3, 8, 5, false);
+	printf("Deletion channel simulator tests passed\n");
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include "dual_bound.h"
+#include "bit_baa_fast.h"
+#include <cassert>
+#include <cmath>
+
+
+/*
+The output distribution of Q on the whole transmitted alphabet (Q_i is split evenly between t_i and its complement).
+*/
+std::vector<Float> output_distribution(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted,
+	const std::vector<EfficientBitCodeWord>& received, const std::vector<Float>& Q){
+	std::vector<Float> R(received.size(), 0.0);
+	for (size_t i = 0; i < transmitted.size(); ++i)
+	{
+		auto row = compute_Pjk_row(channel, transmitted[i], received);
+		for (size_t j = 0; j < received.size(); ++j)
+		{
+			R[j] += Q[i] * row[j];
+		}
+	}
+	for (size_t j = 0; j < received.size(); j += 2)
+	{
+		R[j] = R[j + 1] = (R[j] + R[j + 1]) / 2;
+	}
+	return R;
+}
+
+
+void check_dual_bound(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted,
+	const std::vector<EfficientBitCodeWord>& received, const std::vector<Float>& R, Float rate){
+	DualBoundOptions options;
+	options.num_maximisers = 5;
+	options.num_threads = 1;
+	options.early_exit = false;
+	auto reference = compute_dual_bound(channel, transmitted, received, R, options);
+	assert(reference.num_early_exits == 0);
+	assert(reference.maximisers.size() == 5);
+
+	// By hand.
+	std::vector<Float> divergences(transmitted.size(), 0.0);
+	for (size_t i = 0; i < transmitted.size(); ++i)
+	{
+		auto row = compute_Pjk_row(channel, transmitted[i], received);
+		for (size_t j = 0; j < received.size(); ++j)
+		{
+			if (row[j] > 0)
+			{
+				divergences[i] += row[j] * (log(row[j]) - log((R[j - (j % 2)] + R[j - (j % 2) + 1]) / 2));
+			}
+		}
+	}
+	Float bound = *std::max_element(divergences.begin(), divergences.end());
+	assert(std::abs(reference.bound - bound) <= 1E-12);
+	for (const auto& maximiser : reference.maximisers)
+	{
+		assert(std::abs(divergences[maximiser.index] - maximiser.divergence) <= 1E-12);
+		assert(maximiser.divergence <= reference.bound);
+	}
+	// The dual bound is an upper bound on the rate of every input distribution.
+	assert(reference.bound >= rate - 1E-12);
+
+	// Neither the threads nor the early exits change the result.
+	for (size_t num_threads : {1, 4})
+	{
+		options.num_threads = num_threads;
+		options.early_exit = true;
+		auto result = compute_dual_bound(channel, transmitted, received, R, options);
+		assert(result.bound == reference.bound);
+		assert(result.maximisers.size() == reference.maximisers.size());
+		for (size_t m = 0; m < result.maximisers.size(); ++m)
+		{
+			assert(result.maximisers[m].index == reference.maximisers[m].index);
+			assert(result.maximisers[m].divergence == reference.maximisers[m].divergence);
+		}
+		printf("%lu threads: bound = %f, %lu of %lu rows dropped early\n", num_threads, result.bound,
+			result.num_early_exits, transmitted.size());
+	}
+}
+
+
+void check_channel(size_t in_len, size_t out_len, bool up_to){
+	Float deletion_probability = 0.2;
+	initialize_bit_channel(deletion_probability, in_len, out_len, up_to);
+	const ChannelContext& channel = default_channel_context();
+	auto transmitted = get_transmitted_codewords_symmetries(get_sorted_bit_codewords(in_len, false));
+	auto received = get_sorted_bit_codewords(out_len, up_to);
+	printf("(%lu, %lu, %d):\n", in_len, out_len, (int) up_to);
+
+	// The uniform output distribution.
+	std::vector<Float> Q(transmitted.size(), 1.0 / transmitted.size());
+	Float uniform_rate = compute_bit_rate_efficient(channel, transmitted, received, compute_all_log_Wjk_den(channel, transmitted, received, Q), Q);
+	std::vector<Float> R(received.size(), 1.0 / received.size());
+	check_dual_bound(channel, transmitted, received, R, uniform_rate);
+
+	// The output distributions of the BAA close in on its rate.
+	Float previous_gap = INFINITY;
+	for (size_t iterations : {2, 10, 40})
+	{
+		std::vector<Float> Q_n(transmitted.size(), 1.0 / transmitted.size());
+		for (size_t iteration = 0; iteration < iterations; ++iteration)
+		{
+			Q_n = do_full_baa_step(channel, transmitted, received, Q_n);
+		}
+		auto log_den = compute_all_log_Wjk_den(channel, transmitted, received, Q_n);
+		Float rate = compute_bit_rate_efficient(channel, transmitted, received, log_den, Q_n);
+		auto R_n = output_distribution(channel, transmitted, received, Q_n);
+		check_dual_bound(channel, transmitted, received, R_n, rate);
+
+		DualBoundOptions options;
+		Float gap = compute_dual_bound(channel, transmitted, received, R_n, options).bound - rate;
+		printf("%lu iterations: rate = %f, gap = %g\n", iterations, rate, gap);
+		assert(gap >= -1E-12 and gap < previous_gap);
+		previous_gap = gap;
+	}
+}
+
+
+int main()
+{
+	// Several tiles per row, so that the rows can be dropped early.
+	setenv("BDC_TILE_COLS", "32", 1);
+	check_channel(10, 6, false);
+	check_channel(10, 6, true);
+	printf("The dual bounds are right and close in on the capacity.\n");
+	return 0;
+}
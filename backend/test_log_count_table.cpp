@@ -0,0 +1,87 @@
+#include "bit_channel.h"
+#include "bit_baa_fast.h"
+#include "log_count_table.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+int main()
+{
+	// The table holds the library's logs, and the larger counts fall back to the library.
+	for (size_t count = 0; count < 2 * LOG_COUNT_TABLE_SIZE; ++count)
+	{
+		assert(log_count((Float) count) == log((Float) count));
+	}
+	for (Float count : {12870.0, 1E9, 123456789012.0})
+	{
+		assert(log_count(count) == log(count));
+	}
+	printf("The log count table matches the library's logs.\n");
+
+	// Some of the counts from 16 to 8 bits (up to C(16, 8) = 12870) are past the table.
+	Float deletion_probability = 0.3;
+	size_t in_len = 16;
+	size_t out_len = 8;
+	initialize_bit_channel(deletion_probability, in_len, out_len, true);
+	const ChannelContext& channel = default_channel_context();
+	auto transmitted = get_transmitted_codewords_symmetries(get_sorted_bit_codewords(in_len));
+	auto received = get_sorted_bit_codewords_of_lengths(1, out_len);
+	CodewordBucketIndex received_index(received);
+
+	// The rows are the same as without the logs, and the assembled logs are the logs of the entries up to rounding (the
+	// 	cached log normalization factors are computed on their own, rather than as the logs of the factors).
+	std::vector<Float> row(received.size());
+	std::vector<Float> log_row(received.size());
+	Float max_log_error = 0.0;
+	for (size_t i = 0; i < transmitted.size(); i += 97)
+	{
+		compute_log_Pjk_row_range(channel, transmitted[i], received, 0, received.size(), &received_index, row.data(), log_row.data());
+		auto reference_row = compute_Pjk_row(channel, transmitted[i], received, &received_index);
+		for (size_t j = 0; j < received.size(); ++j)
+		{
+			assert(row[j] == reference_row[j]);
+			if (row[j] == 0)
+			{
+				assert(log_row[j] == -INFINITY);
+				continue;
+			}
+			max_log_error = std::max(max_log_error, std::abs(log_row[j] - log(row[j])) / std::max(1.0, std::abs(log(row[j]))));
+		}
+	}
+	printf("Relative error of the assembled logs: %.3e\n", max_log_error);
+	assert(max_log_error < 1E-14);
+
+	// The alphas and the rate of the passes match the ones with the library's logs.
+	std::vector<Float> Q(transmitted.size());
+	for (size_t i = 0; i < Q.size(); ++i)
+	{
+		Q[i] = (1.0 + (i * 7919) % 13) / (7.0 * Q.size());
+	}
+	auto log_dens = compute_all_log_Wjk_den(channel, transmitted, received, Q);
+	auto log_alphas = compute_all_log_alpha_k(channel, transmitted, received, Q, log_dens);
+	// The reference rate is summed in the same order as the rate, so that only the logs differ.
+	ReproducibleSum reference_rate;
+	for (size_t i = 0; i < transmitted.size(); ++i)
+	{
+		auto reference_row = compute_Pjk_row(channel, transmitted[i], received, &received_index);
+		Float reference_alpha = log_alpha_reduction(reference_row.data(), log_dens.data(), log(Q[i]), received.size(),
+			BAA_ALPHA_THRESHOLD);
+		assert(std::abs(log_alphas[i] - reference_alpha) <= 1E-12 * std::max(1.0, std::abs(reference_alpha)));
+		assert(log_alphas[i] == compute_log_alpha_k(channel, transmitted[i], received, Q[i], log_dens, &received_index));
+		Float row_rate = 0.0;
+		for (size_t j = 0; j < received.size(); ++j)
+		{
+			if (reference_row[j] >= BAA_RATE_THRESHOLD)
+			{
+				row_rate += Q[i] * reference_row[j] * (log(reference_row[j]) - log_dens[j]);
+			}
+		}
+		reference_rate.add(row_rate);
+	}
+	Float rate = compute_bit_rate_efficient(channel, transmitted, received, log_dens, Q);
+	printf("Rate: %.15f (reference %.15f)\n", rate, reference_rate.value());
+	assert(std::abs(rate - reference_rate.value()) < 1E-13);
+	printf("The passes match the ones with the library's logs.\n");
+	return 0;
+}
@@ -0,0 +1,108 @@
+#include "bit_channel.h"
+#include "monte_carlo_rate.h"
+#include <cassert>
+#include <cmath>
+
+
+Float markov_probability(const MarkovInputDistribution& Q, const EfficientBitCodeWord& word){
+	Float prob = 1.0;
+	for (size_t i = 0; i < word.len; ++i)
+	{
+		uint64_t bit = (word.num >> (word.len - 1 - i)) & 1;
+		if (i == 0)
+		{
+			prob *= bit ? Q.first_one_prob : 1 - Q.first_one_prob;
+			continue;
+		}
+		uint64_t prev = (word.num >> (word.len - i)) & 1;
+		Float flip_prob = prev ? Q.one_to_zero_prob : Q.zero_to_one_prob;
+		prob *= (bit != prev) ? flip_prob : 1 - flip_prob;
+	}
+	return prob;
+}
+
+
+int main()
+{
+	constexpr size_t in_len = 10;
+	constexpr size_t out_len = 10;
+	Float deletion_probability = 0.3;
+	initialize_bit_channel(deletion_probability, in_len, out_len, true);
+	MarkovInputDistribution Q = {0.5, 0.3, 0.3};
+
+	std::vector<BitCodeWord> all_transmitted = get_all_bit_codewords(in_len);
+	std::vector<EfficientBitCodeWord> transmitted(all_transmitted.begin(), all_transmitted.end());
+	std::vector<EfficientBitCodeWord> received;
+	for (size_t k = 0; k <= out_len; ++k)
+	{
+		for (uint64_t num = 0; num < (1ULL << k); ++num)
+		{
+			received.push_back(EfficientBitCodeWord(num, k));
+		}
+	}
+
+	// The exact rate, by enumerating all of the (t, r) pairs:
+	Float exact_rate = 0.0;
+	for (const auto& r : received)
+	{
+		Float W = 0.0;
+		Float expected_count = 0.0;
+		for (const auto& t : transmitted)
+		{
+			W += markov_probability(Q, t) * get_bit_transition_prob_fast(t, r);
+			expected_count += markov_probability(Q, t) * get_num_transition_possibilities_using_cache_fast(t, r);
+		}
+		Float dp_expected_count = compute_expected_transition_count(Q, in_len, r);
+		assert(std::abs(dp_expected_count - expected_count) <= 1E-12 * std::max(1.0, expected_count));
+		for (const auto& t : transmitted)
+		{
+			Float P = get_bit_transition_prob_fast(t, r);
+			if (P > 0)
+			{
+				exact_rate += markov_probability(Q, t) * P * (log(P) - log(W));
+			}
+		}
+	}
+
+	MonteCarloRateOptions options;
+	options.batch_size = 1024;
+	options.target_half_width = 4E-3;
+	options.seed = 17;
+	options.num_threads = 4;
+	auto estimate = estimate_rate_monte_carlo(Q, deletion_probability, in_len, out_len, true, options);
+	printf("exact rate = %f, estimated rate = %f +- %f (%lu samples)\n", exact_rate, estimate.rate, estimate.half_width,
+		estimate.num_samples);
+	fflush(stdout);
+	assert(estimate.converged);
+	// Allow for a 4 sigma deviation so that the (fixed seed) test is not brittle.
+	assert(std::abs(estimate.rate - exact_rate) <= 4 * estimate.standard_error);
+
+	// The estimate must not depend on the number of threads.
+	options.num_threads = 1;
+	auto single_threaded = estimate_rate_monte_carlo(Q, deletion_probability, in_len, out_len, true, options);
+	assert(single_threaded.rate == estimate.rate and single_threaded.num_samples == estimate.num_samples);
+
+	// Past 64 bits the wide codewords are used. Without deletions every sample is exactly the entropy of the input,
+	// 	which for uniform bits is in_len * log(2).
+	MarkovInputDistribution uniform = iid_input_distribution(0.5);
+	MonteCarloRateOptions wide_options;
+	wide_options.batch_size = 256;
+	wide_options.min_samples = 1024;
+	wide_options.max_samples = 4096;
+	wide_options.num_threads = 4;
+	for (size_t wide_len : {(size_t) 100, (size_t) 200})
+	{
+		auto lossless = estimate_rate_monte_carlo(uniform, 0.0, wide_len, wide_len, true, wide_options);
+		assert(lossless.converged and std::abs(lossless.rate - (wide_len * log(2))) <= 1E-9 * wide_len);
+		auto wide_estimate = estimate_rate_monte_carlo(Q, 0.2, wide_len, wide_len, true, wide_options);
+		printf("in_len = %lu: estimated rate = %f +- %f (%lu samples)\n", wide_len, wide_estimate.rate,
+			wide_estimate.half_width, wide_estimate.num_samples);
+		assert(wide_estimate.rate > 0 and wide_estimate.rate < wide_len * log(2));
+		wide_options.num_threads = 1;
+		assert(estimate_rate_monte_carlo(Q, 0.2, wide_len, wide_len, true, wide_options).rate == wide_estimate.rate);
+		wide_options.num_threads = 4;
+	}
+
+	printf("Monte Carlo rate tests passed\n");
+	return 0;
+}
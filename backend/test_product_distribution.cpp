@@ -0,0 +1,123 @@
+#include "product_distribution.h"
+#include "bit_baa_fast.h"
+#include "monte_carlo_rate.h"
+#include <cassert>
+#include <cmath>
+#include <random>
+
+
+/*
+A random distribution on the words of a half, supported on every sparsity'th word (at least one).
+*/
+std::vector<Float> random_half(size_t half_len, size_t sparsity, std::mt19937_64& rng){
+	std::vector<Float> Q(1ULL << half_len, 0.0);
+	std::uniform_real_distribution<Float> uniform(0.1, 1.0);
+	Float total = 0.0;
+	for (size_t u = rng() % sparsity; u < Q.size(); u += sparsity)
+	{
+		Q[u] = uniform(rng);
+		total += Q[u];
+	}
+	for (auto& q : Q)
+	{
+		q /= total;
+	}
+	return Q;
+}
+
+std::vector<Float> bernoulli_half(size_t half_len, Float one_prob){
+	std::vector<Float> Q(1ULL << half_len);
+	for (size_t u = 0; u < Q.size(); ++u)
+	{
+		size_t weight = __builtin_popcountll(u);
+		Q[u] = pow(one_prob, weight) * pow(1 - one_prob, half_len - weight);
+	}
+	return Q;
+}
+
+
+void check_against_enumeration(size_t in_len, size_t out_len, bool up_to){
+	initialize_bit_channel(0.2, in_len, out_len, up_to);
+	const ChannelContext& channel = default_channel_context();
+	auto transmitted = get_sorted_bit_codewords(in_len, false);
+	auto received = get_sorted_bit_codewords(out_len, up_to);
+	size_t n1 = (in_len + 1) / 2;
+	size_t n2 = in_len - n1;
+
+	std::mt19937_64 rng(5);
+	ProductMixture Q;
+	Q.weights = {0.7, 0.3};
+	Q.components.push_back({random_half(n1, 1, rng), random_half(n2, 3, rng)});
+	Q.components.push_back({random_half(n1, 4, rng), random_half(n2, 1, rng)});
+
+	std::vector<Float> Q_full(transmitted.size(), 0.0);
+	for (size_t i = 0; i < transmitted.size(); ++i)
+	{
+		uint64_t num = transmitted[i].num;
+		for (size_t m = 0; m < Q.components.size(); ++m)
+		{
+			Q_full[i] += Q.weights[m] * Q.components[m].prefix[num >> n2] * Q.components[m].suffix[num & ((1ULL << n2) - 1)];
+		}
+	}
+	std::vector<Float> W_full(received.size(), 0.0);
+	for (size_t i = 0; i < transmitted.size(); ++i)
+	{
+		auto row = compute_Pjk_row(channel, transmitted[i], received);
+		for (size_t j = 0; j < received.size(); ++j)
+		{
+			W_full[j] += Q_full[i] * row[j];
+		}
+	}
+
+	auto W = compute_product_output_distribution(channel, Q, received);
+	for (size_t j = 0; j < received.size(); ++j)
+	{
+		assert(std::abs(W[j] - W_full[j]) <= 1E-12 * W_full[j] + 1E-300);
+	}
+	auto rate = compute_product_rate(channel, Q, received, 1);
+	Float rate_full = compute_rate(channel, transmitted, received, Q_full);
+	assert(std::abs(rate.rate - rate_full) < 1E-10);
+	// The threads only split the rows.
+	auto rate_threads = compute_product_rate(channel, Q, received, 4);
+	assert(rate_threads.rate == rate.rate and rate_threads.num_rows == rate.num_rows);
+	printf("(%lu, %lu, %d): rate = %f (enumerated %f) from %lu rows\n", in_len, out_len, (int) up_to, rate.rate, rate_full,
+		rate.num_rows);
+}
+
+
+int main()
+{
+	check_against_enumeration(10, 5, false);
+	check_against_enumeration(11, 6, true);
+	printf("The product distributions agree with the enumeration of the transmitted codewords.\n");
+
+	// An i.i.d. input is the product of i.i.d. halves, and its expected counts are known in closed form.
+	size_t in_len = 20, out_len = 8;
+	initialize_bit_channel(0.3, in_len, out_len, false);
+	const ChannelContext& channel = default_channel_context();
+	auto received = get_sorted_bit_codewords(out_len, false);
+	ProductMixture iid;
+	iid.weights = {1.0};
+	iid.components.push_back({bernoulli_half(10, 0.3), bernoulli_half(10, 0.3)});
+	auto W = compute_product_output_distribution(channel, iid, received);
+	Float total = 0.0;
+	for (size_t j = 0; j < received.size(); ++j)
+	{
+		Float expected = channel.normalization_factor(in_len, out_len) *
+			compute_expected_transition_count(iid_input_distribution(0.3), in_len, received[j]);
+		assert(std::abs(W[j] - expected) <= 1E-12 * expected);
+		total += W[j];
+	}
+	assert(std::abs(total - 1.0) < 1E-12);
+
+	// A product of two small codes at a length where the transmitted alphabet is not enumerated.
+	std::mt19937_64 rng(9);
+	ProductMixture code;
+	code.weights = {1.0};
+	code.components.push_back({random_half(10, 64, rng), random_half(10, 64, rng)});
+	auto rate = compute_product_rate(channel, code, received);
+	assert(rate.num_rows == 256);
+	assert(rate.rate > 0 and rate.rate <= log(256.0) + 1E-12);
+	printf("(%lu, %lu): rate of a product of codes = %f nats from %lu rows\n", in_len, out_len, rate.rate, rate.num_rows);
+	return 0;
+}
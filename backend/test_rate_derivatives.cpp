@@ -0,0 +1,96 @@
+#include "batch_scheduler.h"
+#include "bit_baa_fast.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+/*
+The rate of Q on the channel of deletion probability d, in nats.
+*/
+Float rate_at(Float d, size_t in_len, size_t out_len, bool up_to, const std::vector<EfficientBitCodeWord>& transmitted,
+	const std::vector<EfficientBitCodeWord>& received, const std::vector<Float>& Q){
+	ChannelContext channel(d, in_len, out_len, up_to);
+	auto log_dens = compute_all_log_Wjk_den(channel, transmitted, received, Q);
+	return compute_bit_rate_efficient(channel, transmitted, received, log_dens, Q);
+}
+
+
+/*
+The derivatives at a fixed Q against central differences of the rate.
+*/
+void check_fixed_distribution(size_t in_len, size_t out_len, bool up_to){
+	Float d = 0.3;
+	Float h = 1E-3;
+	auto transmitted = get_transmitted_codewords_symmetries(get_sorted_bit_codewords(in_len, false));
+	auto received = get_sorted_bit_codewords(out_len, up_to);
+	ChannelContext channel(d, in_len, out_len, up_to);
+	std::vector<Float> Q(transmitted.size(), 1.0 / transmitted.size());
+	for (size_t iteration = 0; iteration < 3; ++iteration)
+	{
+		Q = do_full_baa_step(channel, transmitted, received, Q);
+	}
+
+	auto log_dens = compute_all_log_Wjk_den(channel, transmitted, received, Q);
+	auto sums = compute_bit_rate_derivative_sums(channel, transmitted, received, log_dens, Q);
+	assert(sums.size() == 3);
+	// The rate is summed exactly as compute_bit_rate_efficient sums it.
+	Float rate = compute_bit_rate_efficient(channel, transmitted, received, log_dens, Q);
+	assert(sums[0].value() == rate);
+
+	Float rate_below = rate_at(d - h, in_len, out_len, up_to, transmitted, received, Q);
+	Float rate_above = rate_at(d + h, in_len, out_len, up_to, transmitted, received, Q);
+	Float first_difference = (rate_above - rate_below) / (2 * h);
+	Float second_difference = (rate_above - 2 * rate + rate_below) / (h * h);
+	printf("(%lu, %lu, %d): rate %.9f, derivative %.9f (differences %.9f), second derivative %.6f (differences %.6f)\n",
+		in_len, out_len, (int) up_to, rate, sums[1].value(), first_difference, sums[2].value(), second_difference);
+	if (not up_to)
+	{
+		// The channel of exactly out_len kept bits does not depend on d.
+		assert(sums[1].value() == 0 and sums[2].value() == 0);
+		assert(rate_below == rate and rate_above == rate);
+		return;
+	}
+	assert(std::abs(sums[1].value() - first_difference) < 1E-5 * std::max(1.0, std::abs(first_difference)));
+	assert(std::abs(sums[2].value() - second_difference) < 1E-3 * std::max(1.0, std::abs(second_difference)));
+}
+
+
+int main()
+{
+	check_fixed_distribution(8, 5, true);
+	check_fixed_distribution(10, 7, true);
+	check_fixed_distribution(9, 6, false);
+	printf("The derivatives of the rate at a fixed distribution match its differences.\n");
+
+	// The batch scheduler returns the derivatives of the rate of its final distribution (on the quotient channel, where
+	// 	the rows of a class are the same).
+	Float d = 0.2;
+	Float h = 1E-3;
+	std::vector<BatchJob> grid = {{8, 5, d, true, 0}, {9, 6, d, true, 1}};
+	BatchOptions options;
+	options.num_threads = 2;
+	options.accuracy = 1E-4;
+	std::vector<BatchResult> results(grid.size());
+	run_batch(grid, options, [&](const BatchResult& result){
+		results[result.job.index] = result;
+	});
+	for (const auto& result : results)
+	{
+		const auto& job = result.job;
+		auto transmitted = get_transmitted_codewords_symmetries(get_sorted_bit_codewords(job.in_len, false));
+		auto received = get_sorted_bit_codewords(job.out_len, true);
+		Float rate = rate_at(d, job.in_len, job.out_len, true, transmitted, received, result.Q) / log(2.0);
+		Float rate_below = rate_at(d - h, job.in_len, job.out_len, true, transmitted, received, result.Q) / log(2.0);
+		Float rate_above = rate_at(d + h, job.in_len, job.out_len, true, transmitted, received, result.Q) / log(2.0);
+		Float first_difference = (rate_above - rate_below) / (2 * h);
+		Float second_difference = (rate_above - 2 * rate + rate_below) / (h * h);
+		printf("(%lu, %lu): derivative %.9f (differences %.9f), second derivative %.6f (differences %.6f)\n", job.in_len,
+			job.out_len, result.rate_derivative, first_difference, result.rate_second_derivative, second_difference);
+		assert(std::abs(result.rate - rate) < 1E-12);
+		assert(std::abs(result.rate_derivative - first_difference) < 1E-5 * std::abs(first_difference));
+		assert(std::abs(result.rate_second_derivative - second_difference) < 1E-3 * std::abs(second_difference));
+	}
+	printf("The scheduled runs return the derivatives of their rates.\n");
+	return 0;
+}
@@ -0,0 +1,107 @@
+#include "bit_channel.h"
+#include "bit_baa_fast.h"
+#include "reproducible_sum.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <random>
+
+
+Float sum_of(const std::vector<Float>& terms){
+	ReproducibleSum sum;
+	for (Float term : terms)
+	{
+		sum.add(term);
+	}
+	return sum.value();
+}
+
+
+int main()
+{
+	// The sum is rounded once, from the exact sum of the terms.
+	assert(sum_of({0.1, 0.2}) == 0.1 + 0.2);
+	assert(sum_of({1.0, ldexp(1.0, -80), -1.0}) == ldexp(1.0, -80));
+	// Terms more than 90 bits below the largest one are dropped.
+	assert(sum_of({1.0, 1E-300, -1.0}) == 0.0);
+	assert(sum_of({1E-300, 2E-300}) == 1E-300 + 2E-300);
+	assert(sum_of({4.9E-324, 4.9E-324}) == 2 * 4.9E-324);
+	assert(sum_of({-0.5, -0.25}) == -0.75);
+	assert(sum_of({}) == 0.0);
+	std::vector<Float> small_terms(1000000, 1E-16);
+	small_terms.push_back(1.0);
+	Float expected = (Float) (1.0L + 1000000.0L * (long double) 1E-16);
+	assert(std::abs(sum_of(small_terms) - expected) <= 2E-16);
+
+	// Neither the order of the terms nor the way they are split into merged sums changes the result.
+	std::mt19937_64 generator(5);
+	std::vector<Float> terms;
+	for (size_t i = 0; i < 100000; ++i)
+	{
+		Float magnitude = ldexp(std::uniform_real_distribution<Float>(0.5, 1.0)(generator), (int) (generator() % 200) - 150);
+		terms.push_back((generator() % 4 == 0) ? -magnitude : magnitude);
+	}
+	Float reference = sum_of(terms);
+	for (size_t trial = 0; trial < 5; ++trial)
+	{
+		std::shuffle(terms.begin(), terms.end(), generator);
+		assert(sum_of(terms) == reference);
+		std::vector<ReproducibleSum> shards(1 + trial * 3);
+		for (Float term : terms)
+		{
+			shards[generator() % shards.size()].add(term);
+		}
+		ReproducibleSum merged;
+		for (const auto& shard : shards)
+		{
+			merged.add(shard);
+		}
+		assert(merged.value() == reference);
+	}
+	printf("The reproducible sums do not depend on the order of the terms.\n");
+
+	// The denominators and the rate of the engine do not depend on the shards of the transmitted alphabet.
+	Float deletion_probability = 0.3;
+	size_t in_len = 12;
+	size_t out_len = 8;
+	initialize_bit_channel(deletion_probability, in_len, out_len, true);
+	const ChannelContext& channel = default_channel_context();
+	auto transmitted = get_transmitted_codewords_symmetries(get_sorted_bit_codewords(in_len));
+	auto received = get_sorted_bit_codewords_of_lengths(1, out_len);
+	std::vector<Float> Q(transmitted.size());
+	for (size_t i = 0; i < Q.size(); ++i)
+	{
+		Q[i] = (1.0 + (i * 7919) % 13) / (7.0 * Q.size());
+	}
+	auto log_den = compute_all_log_Wjk_den(channel, transmitted, received, Q);
+	Float rate = compute_bit_rate_efficient(channel, transmitted, received, log_den, Q);
+	for (size_t num_shards : {2, 3, 7})
+	{
+		std::vector<ReproducibleSum> den_sums(received.size());
+		ReproducibleSum rate_sum;
+		size_t shard_size = (transmitted.size() + num_shards - 1) / num_shards;
+		// The shards are merged in reverse, to make sure that the order does not matter either.
+		for (size_t start = (num_shards - 1) * shard_size; start < transmitted.size() + shard_size; start -= shard_size)
+		{
+			size_t end = std::min(transmitted.size(), start + shard_size);
+			std::vector<EfficientBitCodeWord> shard(transmitted.begin() + start, transmitted.begin() + end);
+			std::vector<Float> shard_Q(Q.begin() + start, Q.begin() + end);
+			auto shard_sums = compute_all_Wjk_den_sums(channel, shard, received, shard_Q);
+			for (size_t j = 0; j < received.size(); ++j)
+			{
+				den_sums[j].add(shard_sums[j]);
+			}
+			rate_sum.add(compute_bit_rate_sum(channel, shard, received, log_den, shard_Q));
+		}
+		assert(log_Wjk_den_from_sums(den_sums) == log_den);
+		assert(rate_sum.value() == rate);
+	}
+
+	// An incremental update from scratch is a full recomputation.
+	std::vector<Float> Q_applied(Q.size(), 0.0);
+	std::vector<ReproducibleSum> incremental_sums(received.size());
+	assert(update_Wjk_den_incremental(channel, transmitted, received, Q, Q_applied, incremental_sums, 0.0) == transmitted.size());
+	assert(log_Wjk_den_from_sums(incremental_sums) == log_den);
+	printf("The denominators and the rate are identical for every split into shards.\n");
+	return 0;
+}
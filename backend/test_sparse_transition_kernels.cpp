@@ -0,0 +1,106 @@
+#include "bit_channel.h"
+#include "bit_baa_fast.h"
+#include "transition_kernels.h"
+#include "sparse_transition_kernels.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+/*
+Checks that the sparse kernels emit exactly the nonzero counts of the dynamic program, for every pair of codewords of
+	lengths n and k (with the symmetry reduced transmitted alphabet for the columns).
+*/
+void check_sparse_kernels(size_t n, size_t k){
+	auto transmitted = get_transmitted_codewords_symmetries(get_sorted_bit_codewords(n));
+	auto received = get_sorted_bit_codewords(k);
+	size_t num_nonzeros = 0;
+
+	std::vector<SparseTransitionCount> nonzeros;
+	for (const auto& trans : transmitted)
+	{
+		std::vector<uint64_t> row(received.size(), 0);
+		nonzeros.clear();
+		enumerate_subsequence_counts(trans, k, received.data(), received.size(), nonzeros);
+		for (const auto& entry : nonzeros)
+		{
+			assert(entry.count > 0 and row[entry.index] == 0);
+			row[entry.index] = entry.count;
+		}
+		for (size_t j = 0; j < received.size(); ++j)
+		{
+			assert(row[j] == count_transitions_dynamic_programming(trans, received[j]));
+		}
+		num_nonzeros += nonzeros.size();
+	}
+
+	for (const auto& rec : received)
+	{
+		std::vector<uint64_t> col(transmitted.size(), 0);
+		nonzeros.clear();
+		enumerate_supersequence_counts(rec, n, transmitted.data(), transmitted.size(), nonzeros);
+		for (const auto& entry : nonzeros)
+		{
+			assert(entry.count > 0 and col[entry.index] == 0);
+			col[entry.index] = entry.count;
+		}
+		for (size_t i = 0; i < transmitted.size(); ++i)
+		{
+			assert(col[i] == count_transitions_dynamic_programming(transmitted[i], rec));
+		}
+		num_nonzeros -= nonzeros.size();
+	}
+	// Both kernels enumerate the nonzeros of the same table.
+	assert(num_nonzeros == 0);
+}
+
+
+int main()
+{
+	for (size_t n = 1; n <= 12; ++n)
+	{
+		for (size_t k = 0; k <= n; ++k)
+		{
+			check_sparse_kernels(n, k);
+		}
+	}
+	printf("The sparse kernels agree with the dynamic program.\n");
+
+	// The rows and columns of the engine, where the sparse kernels are picked for the lengths close to in_len.
+	Float deletion_probability = 0.2;
+	size_t in_len = 14;
+	size_t out_len = 14;
+	initialize_bit_channel(deletion_probability, in_len, out_len, true);
+	const ChannelContext& channel = default_channel_context();
+	auto transmitted = get_transmitted_codewords_symmetries(get_sorted_bit_codewords(in_len));
+	std::vector<EfficientBitCodeWord> received;
+	for (size_t k = 0; k <= out_len; ++k)
+	{
+		auto codewords = get_sorted_bit_codewords(k);
+		received.insert(received.end(), codewords.begin(), codewords.end());
+	}
+	assert(prefer_sparse_row(in_len, out_len, 1ULL << out_len));
+	assert(not prefer_sparse_row(in_len, in_len / 2, 1ULL << (in_len / 2)));
+
+	for (size_t i = 0; i < transmitted.size(); i += 97)
+	{
+		auto row = compute_Pjk_row(channel, transmitted[i], received);
+		Float total = 0.0;
+		for (size_t j = 0; j < received.size(); ++j)
+		{
+			assert(std::abs(row[j] - get_bit_transition_prob_fast(transmitted[i], received[j])) <= 1E-15);
+			total += row[j];
+		}
+		assert(std::abs(total - 1.0) < 1E-9);
+	}
+	for (size_t j = 0; j < received.size(); j += 101)
+	{
+		auto col = compute_Pjk_col(channel, transmitted, received[j]);
+		for (size_t i = 0; i < transmitted.size(); ++i)
+		{
+			assert(std::abs(col[i] - get_bit_transition_prob_fast(transmitted[i], received[j])) <= 1E-15);
+		}
+	}
+	printf("The sparse rows and columns agree with the dense ones.\n");
+	return 0;
+}
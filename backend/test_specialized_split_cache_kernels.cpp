@@ -0,0 +1,33 @@
+#include "bit_channel.h"
+#include "transition_kernels.h"
+#include <cassert>
+
+
+int main()
+{
+	// Every instantiation of the split cache combine with n <= 12 and k <= 10 counts exactly what the dynamic program
+	// 	does, on every pair of codewords (including k > n, where there is nothing to count).
+	initialize_bit_channel(0.3, 12, 10, true);
+	size_t num_pairs = 0;
+	for (size_t n = 1; n <= 12; ++n)
+	{
+		auto transmitted = get_sorted_bit_codewords(n);
+		for (size_t k = 0; k <= 10; ++k)
+		{
+			assert(transition_kernel_applicable(KERNEL_SPECIALIZED_SPLIT_CACHE, n, k));
+			TransitionCountKernel kernel = get_specialized_split_cache_kernel(n, k);
+			assert(kernel == get_transition_kernel(KERNEL_SPECIALIZED_SPLIT_CACHE, n, k));
+			auto received = get_sorted_bit_codewords(k);
+			for (const auto& trans : transmitted)
+			{
+				for (const auto& rec : received)
+				{
+					assert(kernel(trans, rec) == count_transitions_dynamic_programming(trans, rec));
+				}
+			}
+			num_pairs += transmitted.size() * received.size();
+		}
+	}
+	printf("The specialized split cache kernels agree with the dynamic program on %lu pairs.\n", num_pairs);
+	return 0;
+}
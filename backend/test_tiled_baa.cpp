@@ -0,0 +1,67 @@
+#include "bit_channel.h"
+#include "bit_baa_fast.h"
+#include "tiled_baa.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+int main()
+{
+	Float deletion_probability = 0.3;
+	size_t in_len = 12;
+	size_t out_len = 8;
+	initialize_bit_channel(deletion_probability, in_len, out_len, true);
+	const ChannelContext& channel = default_channel_context();
+	auto transmitted = get_transmitted_codewords_symmetries(get_sorted_bit_codewords(in_len));
+	auto received = get_sorted_bit_codewords_of_lengths(1, out_len);
+	std::vector<Float> Q(transmitted.size());
+	for (size_t i = 0; i < Q.size(); ++i)
+	{
+		Q[i] = (1.0 + (i * 7919) % 13) / (7.0 * Q.size());
+	}
+	CodewordBucketIndex received_index(received);
+
+	// The denominators do not depend on the tile shape, and match the column by column computation.
+	std::vector<Float> reference_den;
+	for (BaaTileShape shape : {BaaTileShape{1, 1}, BaaTileShape{37, 301}, BaaTileShape{4096, 64},
+		choose_baa_tile_shape(in_len, out_len, transmitted.size(), received.size())})
+	{
+		std::vector<ReproducibleSum> W_den_sums(received.size());
+		accumulate_baa_tiles(channel, transmitted, received, Q, NULL, W_den_sums.data(), NULL, shape, &received_index);
+		std::vector<Float> W_den;
+		for (const auto& sum : W_den_sums)
+		{
+			W_den.push_back(sum.value());
+		}
+		if (reference_den.empty())
+		{
+			reference_den = W_den;
+			for (size_t j = 0; j < received.size(); ++j)
+			{
+				Float column_den = compute_Wjk_den(channel, transmitted, received[j], Q);
+				assert(std::abs(W_den[j] - column_den) <= 1E-12 * column_den);
+			}
+		}
+		assert(W_den == reference_den);
+	}
+	printf("The tiled denominators agree with the columns for every tile shape.\n");
+
+	// The alphas are bitwise identical to compute_log_alpha_k for every tile shape.
+	auto log_den = compute_all_log_Wjk_den(channel, transmitted, received, Q);
+	std::vector<Float> reference_alphas;
+	for (size_t i = 0; i < transmitted.size(); ++i)
+	{
+		reference_alphas.push_back(compute_log_alpha_k(channel, transmitted[i], received, Q[i], log_den));
+	}
+	for (BaaTileShape shape : {BaaTileShape{1, 1}, BaaTileShape{37, 301}, BaaTileShape{4096, 64},
+		choose_baa_tile_shape(in_len, out_len, transmitted.size(), received.size())})
+	{
+		std::vector<Float> log_alphas(transmitted.size());
+		accumulate_baa_tiles(channel, transmitted, received, Q, log_den.data(), NULL, log_alphas.data(), shape, &received_index);
+		assert(log_alphas == reference_alphas);
+	}
+	assert(compute_all_log_alpha_k(channel, transmitted, received, Q, log_den) == reference_alphas);
+	printf("The tiled alphas are identical to the rows for every tile shape.\n");
+	return 0;
+}
@@ -0,0 +1,119 @@
+#include "bit_channel.h"
+#include "transition_kernels.h"
+#include "vector_kernels.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <random>
+
+
+/*
+The scalar reductions that every variant of the kernels has to reproduce bitwise: the entry i goes to the lane
+	i % VECTOR_KERNEL_LANES, and the lanes are summed in their order at the end.
+*/
+Float scalar_dot_product(const std::vector<Float>& a, const std::vector<Float>& b){
+	Float lanes[VECTOR_KERNEL_LANES] = {0.0};
+	for (size_t i = 0; i < a.size(); ++i)
+	{
+		lanes[i % VECTOR_KERNEL_LANES] += a[i] * b[i];
+	}
+	Float res = 0.0;
+	for (size_t l = 0; l < VECTOR_KERNEL_LANES; ++l)
+	{
+		res += lanes[l];
+	}
+	return res;
+}
+
+Float scalar_log_alpha_reduction(const std::vector<Float>& P, const std::vector<Float>& log_den, Float log_Q, Float threshold){
+	Float lanes[VECTOR_KERNEL_LANES] = {0.0};
+	for (size_t i = 0; i < P.size(); ++i)
+	{
+		if (P[i] >= threshold)
+		{
+			lanes[i % VECTOR_KERNEL_LANES] += P[i] * (log_Q + log(P[i]) - log_den[i]);
+		}
+	}
+	Float res = 0.0;
+	for (size_t l = 0; l < VECTOR_KERNEL_LANES; ++l)
+	{
+		res += lanes[l];
+	}
+	return res;
+}
+
+
+int main()
+{
+	printf("The vector kernels run their %s variants.\n", vector_kernel_isa());
+	std::mt19937_64 rng(11);
+	std::uniform_real_distribution<Float> uniform(0.0, 1.0);
+	Float threshold = 1E-12;
+
+	// Every tail size (len % VECTOR_KERNEL_LANES) and a few lengths past the unrolled blocks, with some of the entries
+	// 	below the threshold.
+	for (size_t len = 0; len <= 5 * VECTOR_KERNEL_LANES + 3; ++len)
+	{
+		std::vector<Float> a(len), b(len), P(len), log_den(len), log_P(len);
+		for (size_t i = 0; i < len; ++i)
+		{
+			a[i] = uniform(rng) - 0.5;
+			b[i] = uniform(rng) * 1E3;
+			P[i] = (rng() % 4 == 0) ? 1E-14 * uniform(rng) : uniform(rng);
+			log_den[i] = log(uniform(rng) + 1E-3);
+			log_P[i] = log(P[i]);
+		}
+		Float log_Q = log(uniform(rng));
+		assert(dot_product(a.data(), b.data(), len) == scalar_dot_product(a, b));
+		Float reference = scalar_log_alpha_reduction(P, log_den, log_Q, threshold);
+		assert(log_alpha_reduction(P.data(), log_den.data(), log_Q, len, threshold) == reference);
+
+		// The row fed in segments of every size gives the same lanes, with the logs taken or given.
+		for (size_t segment = 1; segment <= len; segment += 3)
+		{
+			Float lanes[VECTOR_KERNEL_LANES] = {0.0};
+			Float lanes_with_logs[VECTOR_KERNEL_LANES] = {0.0};
+			for (size_t first = 0; first < len; first += segment)
+			{
+				size_t segment_len = std::min(segment, len - first);
+				accumulate_log_alpha_lanes(P.data() + first, log_den.data() + first, log_Q, first, segment_len, threshold, lanes);
+				accumulate_log_alpha_lanes_with_logs(P.data() + first, log_P.data() + first, log_den.data() + first, log_Q,
+					first, segment_len, threshold, lanes_with_logs);
+			}
+			assert(combine_lanes(lanes) == reference);
+			assert(combine_lanes(lanes_with_logs) == reference);
+		}
+	}
+	printf("The reductions match the scalar lanes.\n");
+
+	// The row combine (the hand written gathers on AVX-512 machines) against the dynamic program, on runs of every
+	// 	size around the gather width, with the received codewords in a shuffled order.
+	size_t in_len = 14;
+	size_t out_len = 10;
+	initialize_bit_channel(0.3, in_len, out_len, true);
+	const ChannelContext& channel = default_channel_context();
+	for (size_t n : {(size_t) 7, (size_t) 12, in_len})
+	{
+		auto transmitted = get_sorted_bit_codewords(n);
+		for (size_t k = 1; k <= std::min(n, out_len); ++k)
+		{
+			auto received = get_sorted_bit_codewords(k);
+			std::shuffle(received.begin(), received.end(), rng);
+			Float normalization = channel.normalization_factor(n, k);
+			for (size_t trial = 0; trial < 20; ++trial)
+			{
+				const auto& trans = transmitted[rng() % transmitted.size()];
+				size_t count = (trial == 0) ? received.size() : std::min(received.size(), (size_t) (rng() % (4 * VECTOR_KERNEL_LANES + 1)));
+				size_t offset = rng() % (received.size() - count + 1);
+				std::vector<Float> out(count);
+				combine_split_cache_row(trans, received.data() + offset, count, normalization, out.data());
+				for (size_t j = 0; j < count; ++j)
+				{
+					assert(out[j] == normalization * count_transitions_dynamic_programming(trans, received[offset + j]));
+				}
+			}
+		}
+	}
+	printf("The row combine matches the dynamic program.\n");
+	return 0;
+}
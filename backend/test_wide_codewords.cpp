@@ -0,0 +1,126 @@
+#include "bit_words.h"
+#include "channel_context.h"
+#include "monte_carlo_rate.h"
+#include "transition_kernels.h"
+#include <cassert>
+#include <cmath>
+#include <random>
+
+
+template <typename Word>
+BasicBitCodeWord<Word> random_codeword(size_t len, std::mt19937_64& rng){
+	Word num(0);
+	for (size_t i = 0; i < len; ++i)
+	{
+		num = (num << 1) | Word(rng() & 1);
+	}
+	return BasicBitCodeWord<Word>(num, len);
+}
+
+
+template <typename Word>
+void check_word_type(){
+	constexpr size_t bits = BitWordTraits<Word>::BITS;
+	// The masks are right up to the full width (where (1 << len) - 1 is not).
+	for (size_t len : {(size_t) 0, (size_t) 1, (size_t) 31, (size_t) 32, (size_t) 63, (size_t) 64, bits - 1, bits})
+	{
+		assert(word_popcount(low_bits_mask<Word>(len)) == len);
+		assert(len == bits or (low_bits_mask<Word>(len) >> len) == Word(0));
+	}
+
+	std::mt19937_64 rng(7);
+	// The splits of a full width word at either end.
+	auto full_width = random_codeword<Word>(bits, rng);
+	assert(full_width.prefix(0).len == 0 and full_width.prefix(0).num == Word(0) and full_width.suffix(0) == full_width);
+	assert(full_width.prefix(bits) == full_width and full_width.suffix(bits).len == 0);
+
+	for (size_t trial = 0; trial < 2000; ++trial)
+	{
+		// The words that fit in 64 bits behave as the EfficientBitCodeWords do.
+		size_t n = 1 + rng() % 20;
+		size_t k = rng() % (n + 1);
+		EfficientBitCodeWord transmitted(rng() & ((1ULL << n) - 1), n);
+		EfficientBitCodeWord received(rng() & ((1ULL << k) - 1), k);
+		BasicBitCodeWord<Word> wide_transmitted(transmitted);
+		BasicBitCodeWord<Word> wide_received(received);
+		assert(count_transitions_wide(wide_transmitted, wide_received) == count_transitions_dynamic_programming(transmitted, received));
+		size_t n1 = (n + 1) / 2;
+		assert(low_word(wide_transmitted.prefix(n1).num) == (transmitted.num >> (n - n1)));
+		assert(low_word(wide_transmitted.suffix(n1).num) == (transmitted.num & ((1ULL << (n - n1)) - 1)));
+		assert(low_word((~wide_transmitted).num) == ((~transmitted).num & ((1ULL << n) - 1)));
+		assert(wide_transmitted.weight() == (size_t) __builtin_popcountll(transmitted.num));
+
+		// Long words: the split cache identity (sum over the splits of the received word of the products of the
+		// 	counts of the halves) holds across the word boundaries.
+		n = bits / 2 + rng() % (bits / 2 + 1);
+		k = rng() % (n / 3 + 1);
+		auto long_transmitted = random_codeword<Word>(n, rng);
+		auto long_received = random_codeword<Word>(k, rng);
+		n1 = (n + 1) / 2;
+		Float split_count = 0.0;
+		for (size_t k1 = 0; k1 <= k; ++k1)
+		{
+			split_count += count_transitions_wide(long_transmitted.prefix(n1), long_received.prefix(k1)) *
+				count_transitions_wide(long_transmitted.suffix(n1), long_received.suffix(k1));
+		}
+		Float count = count_transitions_wide(long_transmitted, long_received);
+		assert(std::abs(split_count - count) <= 1E-13 * count);
+		assert(~~long_transmitted == long_transmitted);
+		assert(long_transmitted.weight() + (~long_transmitted).weight() == n);
+	}
+}
+
+
+int main()
+{
+	check_word_type<uint64_t>();
+	check_word_type<unsigned __int128>();
+	check_word_type<MultiWord<2> >();
+	check_word_type<MultiWord<4> >();
+	printf("The wide codewords agree with the 64 bit ones.\n");
+
+	// The normalization factors of the exact binomials and of the log domain agree where both apply.
+	for (bool up_to : {false, true})
+	{
+		ChannelContext channel(0.3, 200, up_to ? 120 : 80, up_to, false);
+		for (size_t n = 1; n <= 200; ++n)
+		{
+			Float total = 0.0;
+			for (size_t k = 0; k <= std::min(n, channel.out_len()); ++k)
+			{
+				Float log_factor = channel.log_normalization_factor(n, k);
+				if (not up_to and k != channel.out_len())
+				{
+					continue;
+				}
+				assert(std::isfinite(log_factor));
+				if (n <= MAX_EXACT_BINOMIAL_LEN)
+				{
+					assert(log_factor == log(channel.normalization_factor(n, k)));
+				}
+				total += exp(lgamma(n + 1.0) - lgamma(k + 1.0) - lgamma(n - k + 1.0) + log_factor);
+			}
+			// Every way of receiving a codeword of every possible length adds up to 1.
+			if (up_to or n >= channel.out_len())
+			{
+				assert(std::abs(total - 1.0) < 1E-9);
+			}
+		}
+	}
+	printf("The log normalization factors sum up to 1 at every length.\n");
+
+	// For i.i.d. uniform inputs, every one of the C(n, k) ways of keeping k bits gives a given received word w.p. 2^-k.
+	MarkovInputDistribution Q = iid_input_distribution(0.5);
+	std::mt19937_64 rng(11);
+	for (size_t trial = 0; trial < 20; ++trial)
+	{
+		size_t n = 70 + rng() % 180;
+		size_t k = rng() % 60;
+		auto received = random_codeword<MultiWord<4> >(k, rng);
+		Float expected = exp(lgamma(n + 1.0) - lgamma(k + 1.0) - lgamma(n - k + 1.0) - k * log(2.0));
+		Float count = compute_expected_transition_count(Q, n, received);
+		assert(std::abs(count - expected) <= 1E-10 * expected);
+	}
+	printf("The expected transition counts of long codewords are right.\n");
+	return 0;
+}
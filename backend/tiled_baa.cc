@@ -0,0 +1,63 @@
+#include "tiled_baa.h"
+#include "bit_baa_fast.h"
+#include "vector_kernels.h"
+#include <unistd.h>
+#include <cmath>
+
+constexpr size_t DEFAULT_L2_CACHE_BYTES = 1 << 20;
+constexpr size_t DEFAULT_L3_CACHE_BYTES = 8 << 20;
+constexpr size_t MIN_TILE_ROWS = 16;
+constexpr size_t MIN_TILE_COLS = 256;
+
+
+static size_t cache_size_or(int name, size_t default_size){
+	long size = sysconf(name);
+	return (size > 0) ? (size_t) size : default_size;
+}
+
+
+static size_t tile_dimension_from_env(const char* name, size_t dimension){
+	const char* value = getenv(name);
+	if (value == NULL or value[0] == '\0')
+	{
+		return dimension;
+	}
+	size_t parsed = strtoul(value, NULL, 10);
+	if (parsed == 0)
+	{
+		fprintf(stderr, "%s must be a positive number of codewords (got %s).\n", name, value);
+		exit(1);
+	}
+	return parsed;
+}
+
+
+BaaTileShape choose_baa_tile_shape(size_t in_len, size_t max_received_len, size_t num_transmitted, size_t num_received){
+	size_t l2_bytes = cache_size_or(_SC_LEVEL2_CACHE_SIZE, DEFAULT_L2_CACHE_BYTES);
+	size_t l3_bytes = cache_size_or(_SC_LEVEL3_CACHE_SIZE, DEFAULT_L3_CACHE_BYTES);
+
+	// A received column of a tile holds its codeword, its denominator, its log denominator and its P_jk entry.
+	size_t bytes_per_col = sizeof(EfficientBitCodeWord) + sizeof(ReproducibleSum) + 2 * sizeof(Float);
+	size_t cols = (l2_bytes / 2) / bytes_per_col;
+
+	// Every transmitted row reads a row of every split cache table of its halves, i.e. about 2 ^ (k + 1) counts per half
+	// 	for the longest received length k. Half of L3 is left for these rows.
+	size_t half_len = (in_len + 1) / 2;
+	size_t max_split_len = std::min(max_received_len, half_len);
+	size_t bytes_per_row = 2 * sizeof(Int) * (2ULL << max_split_len);
+	size_t rows = (l3_bytes / 2) / bytes_per_row;
+
+	BaaTileShape shape;
+	shape.transmitted_rows = std::max(MIN_TILE_ROWS, std::min(rows, num_transmitted));
+	shape.received_cols = std::max(MIN_TILE_COLS, std::min(cols, num_received));
+	shape.transmitted_rows = tile_dimension_from_env("BDC_TILE_ROWS", shape.transmitted_rows);
+	shape.received_cols = tile_dimension_from_env("BDC_TILE_COLS", shape.received_cols);
+	return shape;
+}
+
+
+void accumulate_baa_tiles(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received,
+	const std::vector<Float>& Q, const Float* log_W_den, ReproducibleSum* W_den, Float* log_alphas, BaaTileShape shape,
+	const CodewordBucketIndex* received_index){
+	baa_tile_pass(EfficientBitBaaChannel{channel, received_index}, transmitted, received, Q, log_W_den, W_den, log_alphas, shape);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "utils.h"
+#include "bit_channel.h"
+#include "codeword_buckets.h"
+#include "reproducible_sum.h"
+
+
+/*
+A cache blocked evaluation of the BAA passes that recompute P_jk: the (transmitted x received) table is walked in tiles
+	of transmitted_rows x received_cols entries. A tile of received codewords (with its denominators) stays in L2 while
+	all of the transmitted rows of the current tile pass over it, and the rows of a tile are consecutive in the
+	transmitted alphabet, so they share the split cache table rows of their first halves.
+*/
+struct BaaTileShape
+{
+	size_t transmitted_rows;
+	size_t received_cols;
+};
+
+/*
+Picks a tile shape from the sizes of the L2 and L3 caches of this machine (sysconf, with defaults when they are not
+	reported). BDC_TILE_ROWS and BDC_TILE_COLS override the two dimensions.
+*/
+BaaTileShape choose_baa_tile_shape(size_t in_len, size_t max_received_len, size_t num_transmitted, size_t num_received);
+
+/*
+The tiled pass of the BAA engine (baa_tile_pass in baa_engine.h) on the EfficientBitCodeWord channel:
+	- If W_den is not NULL, adds Q[i] * P_ij to the sum W_den[j] for every pair (the linear denominators, not pair
+		averaged).
+	- If log_alphas is not NULL, writes sum_j P_ij * (log Q[i] + log P_ij - log_W_den[j]) to log_alphas[i] (the entries
+		with P_ij < BAA_ALPHA_THRESHOLD are skipped, as in compute_log_alpha_k).
+The results do not depend on the tile shape: the sums W_den[j] do not depend on the order of their terms, and the alphas
+	are reduced lane by lane exactly as compute_log_alpha_k does.
+*/
+void accumulate_baa_tiles(const ChannelContext& channel, const std::vector<EfficientBitCodeWord>& transmitted, const std::vector<EfficientBitCodeWord>& received,
+	const std::vector<Float>& Q, const Float* log_W_den, ReproducibleSum* W_den, Float* log_alphas, BaaTileShape shape,
+	const CodewordBucketIndex* received_index = NULL);
@@ -0,0 +1,429 @@
+#include "transition_kernels.h"
+#include <chrono>
+#include <random>
+#include <string>
+#include <cstring>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static TransitionKernelKind default_transition_kernel(size_t n, size_t k){
+	return (n <= MAX_SPECIALIZED_KERNEL_LEN and k <= MAX_SPECIALIZED_KERNEL_LEN) ? KERNEL_SPECIALIZED_SPLIT_CACHE : KERNEL_SPLIT_CACHE;
+}
+
+std::array<std::array<TransitionCountKernel, MAX_KERNEL_WORD_LEN + 1>, MAX_KERNEL_WORD_LEN + 1> _transition_count_kernels = [](){
+	std::array<std::array<TransitionCountKernel, MAX_KERNEL_WORD_LEN + 1>, MAX_KERNEL_WORD_LEN + 1> res;
+	for (size_t n = 0; n <= MAX_KERNEL_WORD_LEN; ++n)
+	{
+		for (size_t k = 0; k <= MAX_KERNEL_WORD_LEN; ++k)
+		{
+			res[n][k] = get_transition_kernel(default_transition_kernel(n, k), n, k);
+		}
+	}
+	return res;
+}();
+
+std::array<std::array<TransitionKernelKind, MAX_KERNEL_WORD_LEN + 1>, MAX_KERNEL_WORD_LEN + 1> _transition_kernel_kinds = [](){
+	std::array<std::array<TransitionKernelKind, MAX_KERNEL_WORD_LEN + 1>, MAX_KERNEL_WORD_LEN + 1> res;
+	for (size_t n = 0; n <= MAX_KERNEL_WORD_LEN; ++n)
+	{
+		for (size_t k = 0; k <= MAX_KERNEL_WORD_LEN; ++k)
+		{
+			res[n][k] = default_transition_kernel(n, k);
+		}
+	}
+	return res;
+}();
+
+static const char* TRANSITION_KERNEL_NAMES[NUM_TRANSITION_KERNELS] = {
+	"split_cache",
+	"dynamic_programming",
+	"closed_form",
+	"specialized_split_cache",
+};
+
+const char* transition_kernel_name(TransitionKernelKind kind){
+	return TRANSITION_KERNEL_NAMES[kind];
+}
+
+
+inline uint64_t low_bits(size_t len){
+	return (len >= 64) ? ~0ULL : ((1ULL << len) - 1);
+}
+
+
+TransitionCountKernel get_transition_kernel(TransitionKernelKind kind, size_t n, size_t k){
+	switch (kind)
+	{
+	case KERNEL_SPLIT_CACHE:
+		return count_transitions_split_cache;
+	case KERNEL_DYNAMIC_PROGRAMMING:
+		return count_transitions_dynamic_programming;
+	case KERNEL_CLOSED_FORM:
+		return count_transitions_closed_form;
+	case KERNEL_SPECIALIZED_SPLIT_CACHE:
+		return get_specialized_split_cache_kernel(n, k);
+	default:
+		assert(false);
+		return NULL;
+	}
+}
+
+
+size_t count_transitions_split_cache(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord& recieved){
+	return get_num_transition_possibilities_using_cache_fast(transmitted, recieved, false);
+}
+
+
+size_t count_transitions_dynamic_programming(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord& recieved){
+	size_t n = transmitted.len;
+	size_t k = recieved.len;
+	if (k > n)
+	{
+		return 0;
+	}
+	// ways[j] is the number of ways to produce the first j received bits from the transmitted bits seen so far.
+	size_t ways[MAX_KERNEL_WORD_LEN + 1] = {1};
+	for (size_t i = 0; i < n; ++i)
+	{
+		uint64_t t_bit = (transmitted.num >> (n - 1 - i)) & 1;
+		// Prefixes that cannot be completed with the remaining n - 1 - i bits are not worth updating.
+		size_t lowest = ((k + i + 1) > n) ? std::max((size_t) 1, k + i + 1 - n) : 1;
+		for (size_t j = std::min(i + 1, k); j >= lowest; --j)
+		{
+			uint64_t r_bit = (recieved.num >> (k - j)) & 1;
+			ways[j] += (t_bit == r_bit) ? ways[j-1] : 0;
+		}
+	}
+	return ways[k];
+}
+
+
+size_t count_transitions_closed_form(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord& recieved){
+	size_t n = transmitted.len;
+	size_t k = recieved.len;
+	uint64_t t = transmitted.num & low_bits(n);
+	uint64_t r = recieved.num & low_bits(k);
+	if (k > n)
+	{
+		return 0;
+	}
+	if (k == 0)
+	{
+		return 1;
+	}
+	if (k == n)
+	{
+		return t == r;
+	}
+	if (k == 1)
+	{
+		size_t ones = __builtin_popcountll(t);
+		return (r & 1) ? ones : n - ones;
+	}
+	assert(k == n - 1);
+	// Count the positions whose deletion leaves the received word.
+	size_t count = 0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		uint64_t deleted = ((t >> (i + 1)) << i) | (t & low_bits(i));
+		count += (deleted == r);
+	}
+	return count;
+}
+
+
+template <size_t (*Kernel)(const EfficientBitCodeWord&, const EfficientBitCodeWord&)>
+static void count_transitions_run_with(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord* received,
+	size_t count, Float factor, Float* out){
+	for (size_t j = 0; j < count; ++j)
+	{
+		out[j] = factor * Kernel(transmitted, received[j]);
+	}
+}
+
+void count_transitions_run(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord* received, size_t count,
+	Float factor, Float* out){
+	if (count == 0)
+	{
+		return;
+	}
+	size_t n = transmitted.len;
+	size_t k = received[0].len;
+	switch (_transition_kernel_kinds[n][k])
+	{
+	case KERNEL_SPLIT_CACHE:
+		count_transitions_run_with<count_transitions_split_cache>(transmitted, received, count, factor, out);
+		return;
+	case KERNEL_DYNAMIC_PROGRAMMING:
+		count_transitions_run_with<count_transitions_dynamic_programming>(transmitted, received, count, factor, out);
+		return;
+	case KERNEL_CLOSED_FORM:
+		count_transitions_run_with<count_transitions_closed_form>(transmitted, received, count, factor, out);
+		return;
+	default:
+	{
+		// The specialized instantiations are only known through their table entry, which is loaded once for the run.
+		TransitionCountKernel kernel = _transition_count_kernels[n][k];
+		for (size_t j = 0; j < count; ++j)
+		{
+			out[j] = factor * kernel(transmitted, received[j]);
+		}
+		return;
+	}
+	}
+}
+
+
+bool transition_kernel_applicable(TransitionKernelKind kind, size_t n, size_t k){
+	if (n > MAX_KERNEL_WORD_LEN or k > MAX_KERNEL_WORD_LEN)
+	{
+		return false;
+	}
+	switch (kind)
+	{
+	case KERNEL_SPECIALIZED_SPLIT_CACHE:
+		if (n > MAX_SPECIALIZED_KERNEL_LEN or k > MAX_SPECIALIZED_KERNEL_LEN)
+		{
+			return false;
+		}
+		return transition_kernel_applicable(KERNEL_SPLIT_CACHE, n, k);
+	case KERNEL_SPLIT_CACHE:
+	{
+		size_t n1 = (n+1) / 2;
+		size_t n2 = n - n1;
+		for (size_t k1 = 0; k1 <= std::min(k, n1); ++k1)
+		{
+			size_t k2 = k - k1;
+			if (k2 > n2)
+			{
+				continue;
+			}
+			if (n1 >= MAX_BIT_CACHE_SIZE or k1 >= MAX_BIT_CACHE_SIZE or k2 >= MAX_BIT_CACHE_SIZE)
+			{
+				return false;
+			}
+			if (cached_transition_probs[n1][k1].size() < (1ULL << (n1 + k1)) or
+				cached_transition_probs[n2][k2].size() < (1ULL << (n2 + k2)))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	case KERNEL_DYNAMIC_PROGRAMMING:
+		return true;
+	case KERNEL_CLOSED_FORM:
+		return (k > n) or (k <= 1) or (k + 1 >= n);
+	default:
+		return false;
+	}
+}
+
+
+void set_transition_kernel(size_t n, size_t k, TransitionKernelKind kind){
+	assert(n <= MAX_KERNEL_WORD_LEN and k <= MAX_KERNEL_WORD_LEN);
+	_transition_count_kernels[n][k] = get_transition_kernel(kind, n, k);
+	_transition_kernel_kinds[n][k] = kind;
+}
+
+
+#ifndef __BUILD_FLAGS_HASH__
+#define __BUILD_FLAGS_HASH__ 0
+#endif
+
+static uint64_t fnv1a_hash(const std::string& s, uint64_t hash = 0xcbf29ce484222325ULL){
+	for (char c : s)
+	{
+		hash ^= (unsigned char) c;
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+
+/*
+The tuning results are only valid on the same CPU model, and for kernels built by the same compiler with the same flags.
+The nodes of a cluster with the same CPUs share their results, and rebuilding with the same flags keeps them.
+*/
+static std::string get_autotune_filename(){
+	std::string machine;
+	FILE* cpuinfo = fopen("/proc/cpuinfo", "r");
+	if (cpuinfo != NULL)
+	{
+		char line[512];
+		while (fgets(line, sizeof(line), cpuinfo))
+		{
+			if (!strncmp(line, "model name", strlen("model name")))
+			{
+				machine += line;
+				break;
+			}
+		}
+		fclose(cpuinfo);
+	}
+	// The makefile passes a hash of the compiler command and its flags.
+	std::string build = std::string(__VERSION__) + " " + std::to_string(__BUILD_FLAGS_HASH__);
+
+	char key[64];
+	snprintf(key, sizeof(key), "kernels_%016lx_%016lx", fnv1a_hash(machine), fnv1a_hash(build));
+	const std::string BASE_PATH = __SOURCE_PATH__;
+	return BASE_PATH + "/autotune/" + key;
+}
+
+
+static void load_autotune_file(const std::string& filename,
+	std::array<std::array<bool, MAX_KERNEL_WORD_LEN + 1>, MAX_KERNEL_WORD_LEN + 1>& tuned){
+	FILE* tune_file = fopen(filename.data(), "r");
+	if (tune_file == NULL)
+	{
+		return;
+	}
+	size_t n, k;
+	char name[64];
+	while (fscanf(tune_file, "%lu %lu %63s", &n, &k, name) == 3)
+	{
+		for (size_t kind = 0; kind < NUM_TRANSITION_KERNELS; ++kind)
+		{
+			if (!strcmp(name, TRANSITION_KERNEL_NAMES[kind]) and
+				transition_kernel_applicable((TransitionKernelKind) kind, n, k))
+			{
+				set_transition_kernel(n, k, (TransitionKernelKind) kind);
+				tuned[n][k] = true;
+			}
+		}
+	}
+	fclose(tune_file);
+}
+
+
+static void save_autotune_file(const std::string& filename,
+	const std::array<std::array<bool, MAX_KERNEL_WORD_LEN + 1>, MAX_KERNEL_WORD_LEN + 1>& tuned){
+	const std::string BASE_PATH = __SOURCE_PATH__;
+	mkdir((BASE_PATH + "/autotune").data(), 0755);
+	// Several slaves may tune at once, so write a private file and atomically move it into place.
+	std::string tmp_filename = filename + ".tmp." + std::to_string(getpid());
+	FILE* tune_file = fopen(tmp_filename.data(), "w");
+	if (tune_file == NULL)
+	{
+		return;
+	}
+	for (size_t n = 0; n <= MAX_KERNEL_WORD_LEN; ++n)
+	{
+		for (size_t k = 0; k <= MAX_KERNEL_WORD_LEN; ++k)
+		{
+			if (tuned[n][k])
+			{
+				fprintf(tune_file, "%lu %lu %s\n", n, k, TRANSITION_KERNEL_NAMES[_transition_kernel_kinds[n][k]]);
+			}
+		}
+	}
+	fclose(tune_file);
+	rename(tmp_filename.data(), filename.data());
+}
+
+
+/*
+Times the kernel on the given sample and returns the fastest of a few repetitions in nanoseconds.
+*/
+static Float time_kernel(TransitionCountKernel kernel, const std::vector<EfficientBitCodeWord>& transmitted,
+	const std::vector<EfficientBitCodeWord>& received){
+	constexpr size_t NUM_REPETITIONS = 5;
+	Float best = -1.0;
+	volatile size_t sink = 0;
+	for (size_t rep = 0; rep < NUM_REPETITIONS; ++rep)
+	{
+		size_t total = 0;
+		auto t0 = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < transmitted.size(); ++i)
+		{
+			total += kernel(transmitted[i], received[i]);
+		}
+		auto t1 = std::chrono::steady_clock::now();
+		sink = sink + total;
+		Float elapsed = std::chrono::duration<Float, std::nano>(t1 - t0).count();
+		if (best < 0 or elapsed < best)
+		{
+			best = elapsed;
+		}
+	}
+	return best;
+}
+
+
+static void tune_bucket(size_t n, size_t k, std::mt19937_64& rng, bool verbose){
+	constexpr size_t SAMPLE_SIZE = 512;
+	std::vector<EfficientBitCodeWord> transmitted, received;
+	transmitted.reserve(SAMPLE_SIZE); received.reserve(SAMPLE_SIZE);
+	for (size_t i = 0; i < SAMPLE_SIZE; ++i)
+	{
+		transmitted.push_back(EfficientBitCodeWord(rng() & low_bits(n), n));
+		received.push_back(EfficientBitCodeWord(rng() & low_bits(k), k));
+	}
+
+	TransitionKernelKind best_kind = KERNEL_SPLIT_CACHE;
+	Float best_time = -1.0;
+	for (size_t kind = 0; kind < NUM_TRANSITION_KERNELS; ++kind)
+	{
+		if (not transition_kernel_applicable((TransitionKernelKind) kind, n, k))
+		{
+			continue;
+		}
+		TransitionCountKernel kernel = get_transition_kernel((TransitionKernelKind) kind, n, k);
+		bool agrees = true;
+		for (size_t i = 0; i < SAMPLE_SIZE; ++i)
+		{
+			agrees &= (kernel(transmitted[i], received[i]) == count_transitions_dynamic_programming(transmitted[i], received[i]));
+		}
+		if (not agrees)
+		{
+			fprintf(stderr, "Warning: the %s kernel disagrees with the dynamic program on n=%lu, k=%lu. Not using it.\n",
+				TRANSITION_KERNEL_NAMES[kind], n, k);
+			continue;
+		}
+		Float elapsed = time_kernel(kernel, transmitted, received);
+		if (verbose)
+		{
+			printf("n=%lu\tk=%lu\t%s: %.1f ns per pair\n", n, k, TRANSITION_KERNEL_NAMES[kind], elapsed / SAMPLE_SIZE);
+		}
+		if (best_time < 0 or elapsed < best_time)
+		{
+			best_time = elapsed;
+			best_kind = (TransitionKernelKind) kind;
+		}
+	}
+	set_transition_kernel(n, k, best_kind);
+}
+
+
+void autotune_transition_kernels(size_t in_len, size_t out_len, bool up_to, bool verbose){
+	const char* autotune_env = getenv("BDC_AUTOTUNE");
+	if ((autotune_env != NULL and !strcmp(autotune_env, "0")) or in_len > MAX_KERNEL_WORD_LEN)
+	{
+		return;
+	}
+
+	std::array<std::array<bool, MAX_KERNEL_WORD_LEN + 1>, MAX_KERNEL_WORD_LEN + 1> tuned;
+	for (auto& row : tuned)
+	{
+		row.fill(false);
+	}
+	std::string filename = get_autotune_filename();
+	load_autotune_file(filename, tuned);
+
+	bool tuned_new_buckets = false;
+	std::mt19937_64 rng(0x5eed);
+	for (size_t k = (up_to ? 0 : out_len); k <= std::min(out_len, MAX_KERNEL_WORD_LEN); ++k)
+	{
+		if (tuned[in_len][k])
+		{
+			continue;
+		}
+		tune_bucket(in_len, k, rng, verbose);
+		tuned[in_len][k] = true;
+		tuned_new_buckets = true;
+	}
+	if (tuned_new_buckets)
+	{
+		save_autotune_file(filename, tuned);
+	}
+}
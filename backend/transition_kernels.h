@@ -0,0 +1,72 @@
+#pragma once
+#include "bit_channel.h"
+#include <array>
+
+
+/*
+A kernel (TransitionCountKernel, bit_channel.inl) counts the number of ways the transmitted codeword can be transformed
+	into the received one (the same quantity as get_num_transition_possibilities).
+*/
+enum TransitionKernelKind
+{
+	// Combines the cached counts of the two halves of the transmitted codeword (get_num_transition_possibilities_using_cache_fast).
+	KERNEL_SPLIT_CACHE,
+	// The O(n * k) dynamic program, evaluated directly on the bits of the codewords. Needs no cache tables.
+	KERNEL_DYNAMIC_PROGRAMMING,
+	// Closed form counts for k in {0, 1, n - 1, n} and k > n.
+	KERNEL_CLOSED_FORM,
+	// The split cache combine instantiated for the specific (n, k), for n, k <= MAX_SPECIALIZED_KERNEL_LEN.
+	KERNEL_SPECIALIZED_SPLIT_CACHE,
+	NUM_TRANSITION_KERNELS
+};
+
+constexpr size_t MAX_SPECIALIZED_KERNEL_LEN = 32;
+
+const char* transition_kernel_name(TransitionKernelKind kind);
+
+size_t count_transitions_split_cache(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord& recieved);
+size_t count_transitions_dynamic_programming(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord& recieved);
+size_t count_transitions_closed_form(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord& recieved);
+
+/*
+Writes factor * count_transitions(transmitted, received[j]) to out[j] for a run of count received codewords of the same
+	length. The kernel of the bucket is resolved once for the run, so that the pair loop makes direct calls.
+*/
+void count_transitions_run(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord* received, size_t count,
+	Float factor, Float* out);
+
+/*
+Returns the instantiation of the split cache combine for transmitted words of length n and received words of length k
+	(see specialized_split_cache_kernels.cc).
+*/
+TransitionCountKernel get_specialized_split_cache_kernel(size_t n, size_t k);
+
+/*
+Returns the function that implements the given kernel on the (n, k) bucket.
+*/
+TransitionCountKernel get_transition_kernel(TransitionKernelKind kind, size_t n, size_t k);
+
+/*
+Returns whether the given kernel can count the transitions from words of length n to words of length k.
+The split cache kernel is only applicable if the required cache tables were loaded.
+*/
+bool transition_kernel_applicable(TransitionKernelKind kind, size_t n, size_t k);
+
+/*
+The kind of the kernel in _transition_count_kernels for every (transmitted length, received length) bucket.
+Every bucket starts out with the split cache kernel (its specialized instantiation where there is one), which is what
+	get_bit_transition_prob_fast always used.
+*/
+extern std::array<std::array<TransitionKernelKind, MAX_KERNEL_WORD_LEN + 1>, MAX_KERNEL_WORD_LEN + 1> _transition_kernel_kinds;
+
+void set_transition_kernel(size_t n, size_t k, TransitionKernelKind kind);
+
+/*
+Times every applicable kernel on a sample of pairs of each (in_len, received length) bucket of the channel and dispatches
+	every bucket to the fastest one. The candidates are checked against the dynamic program on the sample before they are timed.
+The decisions are cached in the autotune folder, in a file keyed by the machine and the build, so only the first
+	slave to run a given channel on a node pays for the tuning.
+Setting the environment variable BDC_AUTOTUNE=0 keeps the split cache kernel everywhere.
+Must be called after initialize_bit_channel.
+*/
+void autotune_transition_kernels(size_t in_len, size_t out_len, bool up_to, bool verbose = false);
@@ -0,0 +1,313 @@
+#include "vector_kernels.h"
+#include "interval_arithmetic.h"
+#include "log_count_table.h"
+#include <immintrin.h>
+#include <cstring>
+
+#define BDC_MULTIVERSIONED __attribute__((target_clones("default", "avx2", "avx512f")))
+
+// The row combine accumulates the counts of this many received codewords at a time.
+constexpr size_t COMBINE_CHUNK_SIZE = 256;
+
+
+const char* vector_kernel_isa(){
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+	{
+		return "avx512f";
+	}
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return "avx2";
+	}
+	return "default";
+}
+
+
+Float combine_lanes(const Float lanes[VECTOR_KERNEL_LANES]){
+	Float res = 0.0;
+	for (size_t l = 0; l < VECTOR_KERNEL_LANES; ++l)
+	{
+		res += lanes[l];
+	}
+	return res;
+}
+
+
+BDC_MULTIVERSIONED
+Float dot_product(const Float* a, const Float* b, size_t len){
+	Float lanes[VECTOR_KERNEL_LANES] = {0.0};
+	size_t i = 0;
+	for (; i + VECTOR_KERNEL_LANES <= len; i += VECTOR_KERNEL_LANES)
+	{
+		for (size_t l = 0; l < VECTOR_KERNEL_LANES; ++l)
+		{
+			lanes[l] += a[i + l] * b[i + l];
+		}
+	}
+	for (size_t l = 0; i + l < len; ++l)
+	{
+		lanes[l] += a[i + l] * b[i + l];
+	}
+	return combine_lanes(lanes);
+}
+
+
+Float log_alpha_reduction(const Float* P, const Float* log_den, Float log_Q, size_t len, Float threshold){
+	Float lanes[VECTOR_KERNEL_LANES] = {0.0};
+	accumulate_log_alpha_lanes(P, log_den, log_Q, 0, len, threshold, lanes);
+	return combine_lanes(lanes);
+}
+
+
+BDC_MULTIVERSIONED
+void accumulate_log_alpha_lanes(const Float* P, const Float* log_den, Float log_Q, size_t first, size_t len,
+	Float threshold, Float lanes[VECTOR_KERNEL_LANES]){
+	// The entry j always goes to the lane j % VECTOR_KERNEL_LANES, so splitting a row into segments does not change
+	// 	the order of the additions of any lane.
+	size_t head = std::min(len, (VECTOR_KERNEL_LANES - first % VECTOR_KERNEL_LANES) % VECTOR_KERNEL_LANES);
+	for (size_t i = 0; i < head; ++i)
+	{
+		if (P[i] >= threshold)
+		{
+			lanes[(first + i) % VECTOR_KERNEL_LANES] += P[i] * (log_Q + log(P[i]) - log_den[i]);
+		}
+	}
+	Float log_P[VECTOR_KERNEL_LANES];
+	for (size_t i = head; i < len; i += VECTOR_KERNEL_LANES)
+	{
+		size_t num_lanes = std::min(VECTOR_KERNEL_LANES, len - i);
+		// The logs are library calls, everything around them is done lane-wise.
+		for (size_t l = 0; l < num_lanes; ++l)
+		{
+			log_P[l] = (P[i + l] >= threshold) ? log(P[i + l]) : 0.0;
+		}
+		for (size_t l = 0; l < num_lanes; ++l)
+		{
+			Float term = P[i + l] * (log_Q + log_P[l] - log_den[i + l]);
+			lanes[l] += (P[i + l] >= threshold) ? term : 0.0;
+		}
+	}
+}
+
+
+BDC_MULTIVERSIONED
+void accumulate_log_alpha_lanes_with_logs(const Float* P, const Float* log_P, const Float* log_den, Float log_Q, size_t first,
+	size_t len, Float threshold, Float lanes[VECTOR_KERNEL_LANES]){
+	// The same lanes as accumulate_log_alpha_lanes, with no library calls left in the loop.
+	size_t head = std::min(len, (VECTOR_KERNEL_LANES - first % VECTOR_KERNEL_LANES) % VECTOR_KERNEL_LANES);
+	for (size_t i = 0; i < head; ++i)
+	{
+		if (P[i] >= threshold)
+		{
+			lanes[(first + i) % VECTOR_KERNEL_LANES] += P[i] * (log_Q + log_P[i] - log_den[i]);
+		}
+	}
+	for (size_t i = head; i < len; i += VECTOR_KERNEL_LANES)
+	{
+		size_t num_lanes = std::min(VECTOR_KERNEL_LANES, len - i);
+		for (size_t l = 0; l < num_lanes; ++l)
+		{
+			Float term = P[i + l] * (log_Q + log_P[i + l] - log_den[i + l]);
+			lanes[l] += (P[i + l] >= threshold) ? term : 0.0;
+		}
+	}
+}
+
+
+BDC_MULTIVERSIONED
+void counts_to_log_probs(Float factor, Float log_factor, Float* P, Float* log_P, size_t len){
+	for (size_t i = 0; i < len; ++i)
+	{
+		log_P[i] = log_factor + log_count(P[i]);
+		P[i] = factor * P[i];
+	}
+}
+
+
+BDC_MULTIVERSIONED
+void scaled_add(Float a, const Float* x, Float* y, size_t len){
+	for (size_t i = 0; i < len; ++i)
+	{
+		y[i] += a * x[i];
+	}
+}
+
+
+BDC_MULTIVERSIONED
+void accumulate_interval_den(Float Q_lo, Float Q_hi, const Float* counts, Float* den_lo, Float* den_hi, size_t len){
+	for (size_t j = 0; j < len; ++j)
+	{
+		den_lo[j] = std::max(0.0, round_down(den_lo[j] + round_down(Q_lo * counts[j])));
+		den_hi[j] = round_up(den_hi[j] + round_up(Q_hi * counts[j]));
+	}
+}
+
+
+BDC_MULTIVERSIONED
+void accumulate_interval_divergence(const Float* counts, const Float* A_lo, const Float* A_hi, size_t len, Float* lo, Float* hi){
+	Float lanes_lo[VECTOR_KERNEL_LANES] = {0.0};
+	Float lanes_hi[VECTOR_KERNEL_LANES] = {0.0};
+	Float log_counts[VECTOR_KERNEL_LANES];
+	for (size_t i = 0; i < len; i += VECTOR_KERNEL_LANES)
+	{
+		size_t num_lanes = std::min(VECTOR_KERNEL_LANES, len - i);
+		// The logs come from the table of log_count (which are the library's logs), everything around them is done
+		// 	lane-wise.
+		for (size_t l = 0; l < num_lanes; ++l)
+		{
+			log_counts[l] = (counts[i + l] > 0) ? log_count(counts[i + l]) : 0.0;
+		}
+		for (size_t l = 0; l < num_lanes; ++l)
+		{
+			Float count = counts[i + l];
+			// The log is pushed out by two ulps (see interval_log).
+			Float term_lo = round_down(count * round_down(round_down(round_down(log_counts[l])) + A_lo[i + l]));
+			Float term_hi = round_up(count * round_up(round_up(round_up(log_counts[l])) + A_hi[i + l]));
+			lanes_lo[l] = (count > 0) ? round_down(lanes_lo[l] + term_lo) : lanes_lo[l];
+			lanes_hi[l] = (count > 0) ? round_up(lanes_hi[l] + term_hi) : lanes_hi[l];
+		}
+	}
+	for (size_t l = 0; l < VECTOR_KERNEL_LANES; ++l)
+	{
+		*lo = round_down(*lo + lanes_lo[l]);
+		*hi = round_up(*hi + lanes_hi[l]);
+	}
+}
+
+
+BDC_MULTIVERSIONED
+void exp_normalize(Float* x, size_t len){
+	if (len == 0)
+	{
+		return;
+	}
+	Float max_x = x[0];
+	for (size_t i = 1; i < len; ++i)
+	{
+		max_x = std::max(max_x, x[i]);
+	}
+	for (size_t i = 0; i < len; ++i)
+	{
+		x[i] = exp(x[i] - max_x);
+	}
+	Float lanes[VECTOR_KERNEL_LANES] = {0.0};
+	for (size_t i = 0; i < len; i += VECTOR_KERNEL_LANES)
+	{
+		for (size_t l = 0; l < std::min(VECTOR_KERNEL_LANES, len - i); ++l)
+		{
+			lanes[l] += x[i + l];
+		}
+	}
+	Float total = combine_lanes(lanes);
+	for (size_t i = 0; i < len; ++i)
+	{
+		x[i] /= total;
+	}
+}
+
+
+BDC_MULTIVERSIONED
+static void combine_split_cache_row_generic(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord* received,
+	size_t count, Float normalization, Float* out){
+	size_t n = transmitted.len;
+	size_t k = (count > 0) ? received[0].len : 0;
+	size_t n1 = (n+1) / 2;
+	size_t n2 = n - n1;
+	uint64_t trans_num1 = transmitted.num >> n2;
+	uint64_t trans_num2 = transmitted.num & ((1ULL << n2) - 1);
+	size_t lowest = (k > n2) ? k - n2 : 0;
+	size_t highest = std::min(k, n1);
+
+	uint64_t counts[COMBINE_CHUNK_SIZE];
+	for (size_t chunk = 0; chunk < count; chunk += COMBINE_CHUNK_SIZE)
+	{
+		size_t chunk_size = std::min(COMBINE_CHUNK_SIZE, count - chunk);
+		for (size_t j = 0; j < chunk_size; ++j)
+		{
+			counts[j] = 0;
+		}
+		for (size_t k1 = lowest; k1 <= highest; ++k1)
+		{
+			size_t k2 = k - k1;
+			// The rows of the two tables that belong to the halves of the transmitted codeword:
+			const Int* row1 = cached_transition_probs[n1][k1].data() + (trans_num1 << k1);
+			const Int* row2 = cached_transition_probs[n2][k2].data() + (trans_num2 << k2);
+			uint64_t mask2 = (1ULL << k2) - 1;
+			for (size_t j = 0; j < chunk_size; ++j)
+			{
+				uint64_t rec_num = received[chunk + j].num;
+				counts[j] += ((uint64_t) row1[rec_num >> k2]) * row2[rec_num & mask2];
+			}
+		}
+		for (size_t j = 0; j < chunk_size; ++j)
+		{
+			out[chunk + j] = normalization * counts[j];
+		}
+	}
+}
+
+
+/*
+The AVX-512 row combine: the compiler does not emit gathers for the table lookups, so they are written out by hand.
+Eight received codewords are handled at a time (their nums are gathered out of the array of codewords), and the
+	counts are converted exactly as in the generic variant.
+*/
+// GCC 12 reports the undefined placeholder operands inside its own AVX-512 intrinsics as uninitialized.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f")))
+static void combine_split_cache_row_avx512(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord* received,
+	size_t count, Float normalization, Float* out){
+	static_assert(sizeof(EfficientBitCodeWord) == 2 * sizeof(uint64_t), "The nums are gathered with a stride of 16 bytes");
+	size_t n = transmitted.len;
+	size_t k = (count > 0) ? received[0].len : 0;
+	size_t n1 = (n+1) / 2;
+	size_t n2 = n - n1;
+	uint64_t trans_num1 = transmitted.num >> n2;
+	uint64_t trans_num2 = transmitted.num & ((1ULL << n2) - 1);
+	size_t lowest = (k > n2) ? k - n2 : 0;
+	size_t highest = std::min(k, n1);
+
+	const __m512i num_offsets = _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14);
+	uint64_t counts[VECTOR_KERNEL_LANES];
+	size_t j = 0;
+	for (; j + VECTOR_KERNEL_LANES <= count; j += VECTOR_KERNEL_LANES)
+	{
+		__m512i rec_nums = _mm512_i64gather_epi64(num_offsets, (const long long*) &received[j].num, 8);
+		__m512i acc = _mm512_setzero_si512();
+		for (size_t k1 = lowest; k1 <= highest; ++k1)
+		{
+			size_t k2 = k - k1;
+			const Int* row1 = cached_transition_probs[n1][k1].data() + (trans_num1 << k1);
+			const Int* row2 = cached_transition_probs[n2][k2].data() + (trans_num2 << k2);
+			__m512i index1 = _mm512_srli_epi64(rec_nums, k2);
+			__m512i index2 = _mm512_and_si512(rec_nums, _mm512_set1_epi64((1ULL << k2) - 1));
+			__m512i count1 = _mm512_cvtepu32_epi64(_mm512_i64gather_epi32(index1, (const int*) row1, sizeof(Int)));
+			__m512i count2 = _mm512_cvtepu32_epi64(_mm512_i64gather_epi32(index2, (const int*) row2, sizeof(Int)));
+			acc = _mm512_add_epi64(acc, _mm512_mul_epu32(count1, count2));
+		}
+		_mm512_storeu_si512(counts, acc);
+		for (size_t l = 0; l < VECTOR_KERNEL_LANES; ++l)
+		{
+			out[j + l] = normalization * counts[l];
+		}
+	}
+	if (j < count)
+	{
+		combine_split_cache_row_generic(transmitted, received + j, count - j, normalization, out + j);
+	}
+}
+#pragma GCC diagnostic pop
+
+
+void combine_split_cache_row(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord* received, size_t count,
+	Float normalization, Float* out){
+	static const bool use_avx512 = !strcmp(vector_kernel_isa(), "avx512f");
+	if (use_avx512)
+	{
+		combine_split_cache_row_avx512(transmitted, received, count, normalization, out);
+	} else{
+		combine_split_cache_row_generic(transmitted, received, count, normalization, out);
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "utils.h"
+#include "bit_channel.h"
+
+
+/*
+The hot loops of the BAA passes, compiled for several instruction sets (generic x86-64, AVX2 and AVX-512) in a single
+	binary. The loader picks the variant for the node it runs on (by CPUID, through GCC's target_clones), so the same
+	build runs at full width on every node.
+The reductions keep VECTOR_KERNEL_LANES independent partial sums, combined in a fixed order at the end, so all of the
+	variants return bitwise identical results (the makefile builds with -ffp-contract=off, so that the AVX-512 variants
+	do not fuse the multiply-adds either).
+*/
+constexpr size_t VECTOR_KERNEL_LANES = 8;
+
+/*
+The instruction set of the variants selected on this machine ("avx512f", "avx2" or "default").
+*/
+const char* vector_kernel_isa();
+
+/*
+Returns sum_i a[i] * b[i].
+*/
+Float dot_product(const Float* a, const Float* b, size_t len);
+
+/*
+Returns sum_j P[j] * (log_Q + log(P[j]) - log_den[j]) over the entries with P[j] >= threshold (the log of alpha_k).
+*/
+Float log_alpha_reduction(const Float* P, const Float* log_den, Float log_Q, size_t len, Float threshold);
+
+/*
+Adds the terms of log_alpha_reduction for the entries [first, first + len) of a row (P and log_den point at the entry
+	first) to the partial sums in lanes. Feeding a row to it in consecutive segments and combining the lanes at the end
+	gives exactly the result of log_alpha_reduction on the whole row.
+*/
+void accumulate_log_alpha_lanes(const Float* P, const Float* log_den, Float log_Q, size_t first, size_t len,
+	Float threshold, Float lanes[VECTOR_KERNEL_LANES]);
+
+/*
+accumulate_log_alpha_lanes with the logs of the entries of the row given in log_P (see counts_to_log_probs), rather than
+	taken by the kernel.
+*/
+void accumulate_log_alpha_lanes_with_logs(const Float* P, const Float* log_P, const Float* log_den, Float log_Q, size_t first,
+	size_t len, Float threshold, Float lanes[VECTOR_KERNEL_LANES]);
+
+/*
+Turns the exact transition counts of a run of received codewords of the same length into their probabilities (in place)
+	and the logs of the probabilities: P[j] = factor * P[j] and log_P[j] = log_factor + log_count(P[j]) (see
+	log_count_table.h), where log_factor is the log of the normalization factor of the run.
+*/
+void counts_to_log_probs(Float factor, Float log_factor, Float* P, Float* log_P, size_t len);
+
+/*
+Sums the partial sums of a reduction in their fixed order.
+*/
+Float combine_lanes(const Float lanes[VECTOR_KERNEL_LANES]);
+
+/*
+y += a * x.
+*/
+void scaled_add(Float a, const Float* x, Float* y, size_t len);
+
+/*
+The certified passes (see certified_rate.h), with outward rounding (see interval_arithmetic.h). The counts are exact.
+Adds [Q_lo, Q_hi] * counts[j] to the interval [den_lo[j], den_hi[j]] for every j.
+*/
+void accumulate_interval_den(Float Q_lo, Float Q_hi, const Float* counts, Float* den_lo, Float* den_hi, size_t len);
+
+/*
+Adds sum_j counts[j] * (log(counts[j]) + [A_lo[j], A_hi[j]]) over the entries with counts[j] > 0 to the interval [*lo, *hi].
+*/
+void accumulate_interval_divergence(const Float* counts, const Float* A_lo, const Float* A_hi, size_t len, Float* lo, Float* hi);
+
+/*
+Replaces x by exp(x - max(x)) / sum(exp(x - max(x))), i.e. normalizes log weights into a distribution.
+*/
+void exp_normalize(Float* x, size_t len);
+
+/*
+Computes the transition probabilities from the transmitted codeword to count received codewords that all have the
+	same length k, by combining the split cache tables, and writes them multiplied by normalization into out.
+The cache tables of all of the splits of (transmitted.len, k) must be loaded.
+On AVX-512 machines the table lookups are done with explicit gathers (the counts are exact, so the result is the same).
+*/
+void combine_split_cache_row(const EfficientBitCodeWord& transmitted, const EfficientBitCodeWord* received, size_t count,
+	Float normalization, Float* out);
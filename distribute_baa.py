@@ -9,6 +9,7 @@ import sys, os, time
 
 import communicate_with_cpp
 import backend
+import result_store
 
 import copy
 import logging
@@ -36,10 +37,24 @@ class ExperimentDetails:
 	# The required accuracy of the BAA algorithm (affects the number of iterations until it is considered converged)
 	accuracy: float = 0.05
 	verbose: bool = False
+	# Collect hardware performance counters around the hot kernels of the backend (see backend/perf_counters.h)
+	perf_stats: bool = False
+	# When positive, the denominators are only updated with the entries of Q whose relative change exceeds this tolerance,
+	# with a full recomputation every full_recompute_period iterations to bound the drift.
+	incremental_tolerance: float = 0.0
+	full_recompute_period: int = 10
+	# NUMA placement of the workers on multi-socket nodes: 'off', 'replicate' (bind every worker and its own copy of the
+	# cache tables to the node of its shard) or 'interleave' (bind the worker, interleave the tables over all of the nodes).
+	numa_policy: str = 'off'
+	# How the backend's tables get huge pages: 'madvise' (transparent huge pages), 'hugetlb' (the reserved pool) or 'off'.
+	huge_pages: str = 'madvise'
 
 	def log_file(self):
 		return os.path.join(self.experiment_path, 'log.txt')
 
+	def perf_stats_file(self):
+		return os.path.join(self.experiment_path, 'perf_stats.txt')
+
 	def trans_filename(self):
 		return os.path.join(self.experiment_path, 'transmitted.codewords')
 
@@ -49,18 +64,27 @@ class ExperimentDetails:
 	def current_Q_filename(self):
 		return os.path.join(self.experiment_path, 'current_Q.arr')
 
-	def log_den_fn(self, i: int):
-		return os.path.join(self.experiment_path, f'log_den_{i}.arr')
+	def den_sums_fn(self, i: int):
+		return os.path.join(self.experiment_path, f'den_sums_{i}.sums')
 
 	def alpha_fn(self, i: int):
 		return os.path.join(self.experiment_path, f'alpha_{i}.arr')
 
 	def rate_fn(self, i: int):
-		return os.path.join(self.experiment_path, f'rate_{i}.arr')
+		return os.path.join(self.experiment_path, f'rate_{i}.sums')
+
+	def rate_all_fn(self):
+		return os.path.join(self.experiment_path, f'rate_all.arr')
 
 	def log_den_all_fn(self):
 		return os.path.join(self.experiment_path, f'log_den_all.arr')
 
+	def Q_applied_fn(self, i: int):
+		return os.path.join(self.experiment_path, f'Q_applied_{i}.arr')
+
+	def dens_state_fn(self, i: int):
+		return os.path.join(self.experiment_path, f'dens_state_{i}.sums')
+
 
 
 def prep_for_baa_run(cd: ChannelDetails, ed: ExperimentDetails):
@@ -70,31 +94,52 @@ def prep_for_baa_run(cd: ChannelDetails, ed: ExperimentDetails):
 	if not os.path.isdir(ed.experiment_path):
 		os.mkdir(ed.experiment_path)
 	logging.basicConfig(filename=ed.log_file(), level=logging.INFO, filemode='a', format='%(relativeCreated)6d %(threadName)s %(message)s')
+	if ed.perf_stats:
+		# The backend workers inherit the environment and append their per-region counters to this file.
+		os.environ['BDC_PERF_STATS'] = ed.perf_stats_file()
+	os.environ['BDC_NUMA_POLICY'] = ed.numa_policy
+	os.environ['BDC_HUGE_PAGES'] = ed.huge_pages
+	plan = backend.plan_resources(cd.in_len, cd.max_out_len, cd.up_to, ed.num_processors)
+	logging.info(f'Resource plan: {plan}')
 	backend.generate_codewords(False, cd.in_len, ed.trans_filename(), 1)
 	backend.generate_codewords(cd.up_to, cd.max_out_len, ed.rec_filename(), 0)
 
-def backend_compute_log_dens(params):
-	return np.reshape(backend.compute_log_dens(*params), (-1, 1))
+def backend_compute_den_sums(params):
+	return backend.compute_den_sums(*params)
 
-def log_sum(arrs):
-	arr = np.concatenate(arrs, axis=1)
-	base_lines = np.reshape(np.max(arr, axis=1), (-1, 1))
-	exp_arr = np.exp(arr - base_lines)
-	return np.log(np.sum(exp_arr, axis=1)) + np.ravel(base_lines)
+def backend_compute_den_sums_incremental(params):
+	return backend.compute_den_sums_incremental(*params)
 
-def compute_log_dens(cd: ChannelDetails, ed: ExperimentDetails):
+def compute_log_dens(cd: ChannelDetails, ed: ExperimentDetails, full_recompute: bool = True):
 	"""
 	Distributes the computation of the logs of the denominators needed for completing a step of the BAA algorithm.
+	In incremental mode, unless full_recompute is set, every worker only updates its previous denominators.
+	The workers return exact partial sums, which are merged by the backend, so the result does not depend on the number of
+	processors.
 	"""
 	jump_size = int(np.ceil(cd.input_alphabet_size() / ed.num_processors))
+	shards = list(enumerate(range(0, cd.input_alphabet_size(), jump_size)))
 	with Pool(ed.num_processors) as worker_pool:
-		log_dens = log_sum(worker_pool.map(backend_compute_log_dens, [
+		if ed.incremental_tolerance > 0:
+			if full_recompute:
+				# Without a state the backend applies every row, which resets the accumulated drift.
+				for i, _ in shards:
+					for fn in [ed.Q_applied_fn(i), ed.dens_state_fn(i)]:
+						if os.path.exists(fn):
+							os.remove(fn)
+			den_sums_fns = worker_pool.map(backend_compute_den_sums_incremental, [
 									(ed.trans_filename(), ed.rec_filename(), start, start+jump_size, ed.current_Q_filename(),
-										cd.deletion_probability, ed.log_den_fn(i), cd.in_len, cd.max_out_len, cd.up_to)
-									for i, start in enumerate(range(0, cd.input_alphabet_size(), jump_size))
-									]))
-	communicate_with_cpp.save_1d_array(log_dens, ed.log_den_all_fn())
-	return log_dens
+										cd.deletion_probability, ed.den_sums_fn(i), cd.in_len, cd.max_out_len, cd.up_to,
+										ed.Q_applied_fn(i), ed.dens_state_fn(i), ed.incremental_tolerance, i)
+									for i, start in shards
+									])
+		else:
+			den_sums_fns = worker_pool.map(backend_compute_den_sums, [
+									(ed.trans_filename(), ed.rec_filename(), start, start+jump_size, ed.current_Q_filename(),
+										cd.deletion_probability, ed.den_sums_fn(i), cd.in_len, cd.max_out_len, cd.up_to, i)
+									for i, start in shards
+									])
+	return backend.merge_sums(den_sums_fns, ed.log_den_all_fn(), True)
 
 
 def backend_compute_alphas(params):
@@ -109,57 +154,105 @@ def compute_alphas(cd: ChannelDetails, ed: ExperimentDetails):
 		alphas = np.concatenate(worker_pool.map(backend_compute_alphas, [
 									(ed.trans_filename(), ed.rec_filename(), start, start+jump_size, ed.current_Q_filename(),
 										cd.deletion_probability, ed.alpha_fn(i), cd.in_len, cd.max_out_len, cd.up_to, 
-										ed.log_den_all_fn())
+										ed.log_den_all_fn(), i)
 									for i, start in enumerate(range(0, cd.input_alphabet_size(), jump_size))
 									]), axis=0)
 	return alphas
 
-def do_baa_step(initial_Q: np.ndarray, cd: ChannelDetails, ed: ExperimentDetails):
+def do_baa_step(initial_Q: np.ndarray, cd: ChannelDetails, ed: ExperimentDetails, full_recompute: bool = True):
 	communicate_with_cpp.save_1d_array(initial_Q, ed.current_Q_filename())
-	log_dens = compute_log_dens(cd, ed)
+	log_dens = compute_log_dens(cd, ed, full_recompute)
 	alphas = compute_alphas(cd, ed)
 	alphas -= np.max(alphas)
 	next_Q = np.exp(alphas)
 	return next_Q / np.sum(next_Q)
 
-def backend_compute_rate(params):
-	return backend.compute_rate(*params)
+def backend_compute_rate_sum(params):
+	return backend.compute_rate_sum(*params)
 
 
-def compute_rate(current_Q: np.ndarray, cd: ChannelDetails, ed: ExperimentDetails):
+def compute_rate_and_derivatives(current_Q: np.ndarray, cd: ChannelDetails, ed: ExperimentDetails):
 	"""
 	Distributes the backend to compute the log_dens and then use them to compute the rate with the distributed backend as well.
+	Returns the rate and its first and second derivatives by the deletion probability at the fixed Q (in nats), see
+		compute_bit_rate_derivative_sums in the backend.
 	"""
 	communicate_with_cpp.save_1d_array(current_Q, ed.current_Q_filename())
 	log_dens = compute_log_dens(cd, ed)
 
 	jump_size = int(np.ceil(cd.input_alphabet_size() / ed.num_processors))
 	with Pool(ed.num_processors) as worker_pool:
-		rate = np.sum(worker_pool.map(backend_compute_rate, [
+		rate_fns = worker_pool.map(backend_compute_rate_sum, [
 									(ed.trans_filename(), ed.rec_filename(), start, start+jump_size, ed.current_Q_filename(),
 										cd.deletion_probability, ed.rate_fn(i), cd.in_len, cd.max_out_len, cd.up_to, 
-										ed.log_den_all_fn())
+										ed.log_den_all_fn(), i)
 									for i, start in enumerate(range(0, cd.input_alphabet_size(), jump_size))
-									]))
-	return rate
+									])
+	return backend.merge_sums(rate_fns, ed.rate_all_fn(), False)
 
 
-def run_full_baa_algorithm(initial_Q: np.ndarray, cd: ChannelDetails, ed: ExperimentDetails, tqdm=lambda x: x):
+def compute_rate(current_Q: np.ndarray, cd: ChannelDetails, ed: ExperimentDetails):
+	return compute_rate_and_derivatives(current_Q, cd, ed)[0]
+
+
+def run_full_baa_algorithm(initial_Q: np.ndarray, cd: ChannelDetails, ed: ExperimentDetails, tqdm=lambda x: x,
+	iteration_stats: list = None):
 	"""
 	Runs the BAA algorithm, starting from some given initial distribution and continuing until the BAA bound
 		shows that we are at most ed.accuracy from optimal.
 	Returns the best distribution we found, how tightly the BAA bound connects it to the capacity and its rate.
+	If iteration_stats is given, a dictionary with the distance and the runtime of every iteration is appended to it.
 	"""
 	prep_for_baa_run(cd, ed)
 	current_Q = copy.copy(initial_Q)
 	t0 = time.time()
+	force_full_recompute = False
 	for i in tqdm(it.count()):
-		next_Q = do_baa_step(current_Q, cd, ed)
+		full_recompute = force_full_recompute or (i % ed.full_recompute_period) == 0
+		next_Q = do_baa_step(current_Q, cd, ed, full_recompute=full_recompute)
 		arr = np.log2(next_Q / current_Q)
 		arr[np.isnan(arr)] = 0
 		distance = np.max(arr)
 		if ed.verbose:
 			print(f'Iteration Index: {i},\tDistance: {distance},\tRuntime: {time.time() - t0}')
+		if iteration_stats is not None:
+			iteration_stats.append({'iteration': i, 'distance': float(distance), 'runtime': time.time() - t0})
 		current_Q = next_Q
-		if distance < ed.accuracy:
+		# The denominators of the incremental steps may have drifted, so only the distance of a step with fully
+		# recomputed denominators certifies the accuracy.
+		force_full_recompute = distance < ed.accuracy
+		if force_full_recompute and full_recompute:
 			return current_Q, distance, compute_rate(current_Q, cd, ed) / np.log(2), i
+
+
+# A warm start from a stored distribution is mixed with this much of the uniform distribution, as the BAA can never
+# revive the codewords that the neighbouring configuration pushed down to 0.
+WARM_START_UNIFORM_WEIGHT = 1E-6
+
+def run_baa_with_store(cd: ChannelDetails, ed: ExperimentDetails, store: result_store.ResultStore,
+	initial_Q: np.ndarray = None, tqdm=lambda x: x):
+	"""
+	Same as run_full_baa_algorithm, but returns the stored result if the configuration was already run (to at least
+		ed.accuracy by the current engine), and stores the new results otherwise.
+	Without an initial distribution, the run starts from the stored result of the nearest configuration with the same
+		in_len (see ResultStore.nearest_neighbour), or from the uniform distribution if there is none.
+	"""
+	stored = store.find(cd.in_len, cd.max_out_len, cd.deletion_probability, cd.up_to, ed.accuracy)
+	if stored is not None:
+		logging.info(f'Reusing the stored result of {cd}')
+		return stored.Q, stored.distance, stored.rate, stored.num_iterations
+
+	seed_key = None
+	if initial_Q is None:
+		seed_key = store.nearest_neighbour(cd.in_len, cd.max_out_len, cd.deletion_probability, cd.up_to)
+		initial_Q = np.ones(cd.input_alphabet_size()) / cd.input_alphabet_size()
+		if seed_key is not None:
+			logging.info(f'Warm starting {cd} from the stored result {seed_key}')
+			initial_Q = (1 - WARM_START_UNIFORM_WEIGHT) * store.load(seed_key).Q + WARM_START_UNIFORM_WEIGHT * initial_Q
+	iteration_stats = []
+	Q, distance, rate, num_iterations = run_full_baa_algorithm(initial_Q, cd, ed, tqdm, iteration_stats)
+	store.save(result_store.StoredResult(in_len=cd.in_len, max_out_len=cd.max_out_len,
+		deletion_probability=cd.deletion_probability, up_to=cd.up_to, accuracy=ed.accuracy,
+		symmetry_mode=backend.TRANSMITTED_SYMMETRIES, engine_version=backend.ENGINE_VERSION, rate=float(rate),
+		distance=float(distance), num_iterations=num_iterations, iteration_stats=iteration_stats, seeded_from=seed_key, Q=Q))
+	return Q, distance, rate, num_iterations
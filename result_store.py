@@ -0,0 +1,134 @@
+#!/usr/bin/python
+
+from dataclasses import dataclass, asdict
+import hashlib
+import json
+import os
+import shutil
+import tempfile
+import numpy as np
+
+import communicate_with_cpp
+import backend
+
+
+@dataclass
+class StoredResult:
+	in_len: int
+	max_out_len: int
+	deletion_probability: float
+	up_to: bool
+	accuracy: float
+	symmetry_mode: str
+	engine_version: int
+	# The bound that the BAA gives: the capacity is at most rate + distance (in bits).
+	rate: float
+	distance: float
+	num_iterations: int
+	# A dictionary per iteration (see run_full_baa_algorithm).
+	iteration_stats: list
+	# The key of the stored result that the run was seeded from, if any.
+	seeded_from: str = None
+	Q: np.ndarray = None
+
+
+def result_key(in_len: int, max_out_len: int, deletion_probability: float, up_to: bool, accuracy: float,
+	symmetry_mode: str = backend.TRANSMITTED_SYMMETRIES, engine_version: int = backend.ENGINE_VERSION):
+	"""
+	The content address of a BAA result: a hash of everything that determines it.
+	The floats are hashed through their exact (hex) representation.
+	"""
+	description = json.dumps([int(in_len), int(max_out_len), float(deletion_probability).hex(), bool(up_to),
+		float(accuracy).hex(), symmetry_mode, int(engine_version)])
+	return hashlib.sha256(description.encode('utf-8')).hexdigest()
+
+
+class ResultStore:
+	"""
+	A local store of converged BAA runs, in a folder per result named by its key:
+		<path>/<key>/result.json holds the configuration, the bound and the per-iteration stats,
+		<path>/<key>/Q.arr holds the converged distribution (in the format of communicate_with_cpp).
+	Results are written to a temporary folder and renamed into place, so concurrent drivers never see half a result.
+	"""
+	def __init__(self, path: str):
+		self.path = path
+		os.makedirs(path, exist_ok=True)
+
+	def _result_path(self, key: str):
+		return os.path.join(self.path, key)
+
+	def _load_metadata(self, key: str):
+		try:
+			with open(os.path.join(self._result_path(key), 'result.json')) as f_in:
+				return json.load(f_in)
+		except (FileNotFoundError, json.JSONDecodeError):
+			return None
+
+	def _all_metadata(self):
+		for key in sorted(os.listdir(self.path)):
+			metadata = self._load_metadata(key)
+			if metadata is not None:
+				yield key, metadata
+
+	def load(self, key: str):
+		"""
+		Returns the stored result with the given key (including its Q), or None.
+		"""
+		metadata = self._load_metadata(key)
+		if metadata is None:
+			return None
+		result = StoredResult(**metadata)
+		result.Q = communicate_with_cpp.load_1d_array(os.path.join(self._result_path(key), 'Q.arr'))
+		return result
+
+	def save(self, result: StoredResult):
+		"""
+		Stores the result under its key (replacing an earlier result with the same key) and returns the key.
+		"""
+		key = result_key(result.in_len, result.max_out_len, result.deletion_probability, result.up_to, result.accuracy,
+			result.symmetry_mode, result.engine_version)
+		metadata = asdict(result)
+		del metadata['Q']
+		temp_path = tempfile.mkdtemp(dir=self.path, prefix='.tmp_')
+		communicate_with_cpp.save_1d_array(result.Q, os.path.join(temp_path, 'Q.arr'))
+		with open(os.path.join(temp_path, 'result.json'), 'w') as f_out:
+			json.dump(metadata, f_out, indent='\t')
+		if os.path.isdir(self._result_path(key)):
+			shutil.rmtree(self._result_path(key))
+		os.rename(temp_path, self._result_path(key))
+		return key
+
+	def find(self, in_len: int, max_out_len: int, deletion_probability: float, up_to: bool, accuracy: float):
+		"""
+		Returns the stored result of the configuration, or one that was run to a tighter accuracy (by the current engine),
+			or None.
+		"""
+		result = self.load(result_key(in_len, max_out_len, deletion_probability, up_to, accuracy))
+		if result is not None:
+			return result
+		for key, metadata in self._all_metadata():
+			if (metadata['in_len'], metadata['max_out_len'], metadata['deletion_probability'], metadata['up_to']) == \
+					(in_len, max_out_len, deletion_probability, up_to) and \
+					metadata['accuracy'] <= accuracy and metadata['distance'] < accuracy and \
+					metadata['symmetry_mode'] == backend.TRANSMITTED_SYMMETRIES and \
+					metadata['engine_version'] == backend.ENGINE_VERSION:
+				return self.load(key)
+		return None
+
+	def nearest_neighbour(self, in_len: int, max_out_len: int, deletion_probability: float, up_to: bool):
+		"""
+		Returns the key of the stored result whose Q is the best starting point for the configuration, or None.
+		The distributions are over the transmitted codewords, so only results with the same in_len (and symmetry mode)
+			can seed a run, and as in find, only the results of the current engine are used. Among them the closest in
+			the deletion probability wins, and the ties are broken by the received length and up_to.
+		"""
+		best_key, best_distance = None, None
+		for key, metadata in self._all_metadata():
+			if metadata['in_len'] != in_len or metadata['symmetry_mode'] != backend.TRANSMITTED_SYMMETRIES or \
+					metadata['engine_version'] != backend.ENGINE_VERSION:
+				continue
+			distance = (abs(metadata['deletion_probability'] - deletion_probability),
+				abs(metadata['max_out_len'] - max_out_len), metadata['up_to'] != up_to, metadata['accuracy'])
+			if best_distance is None or distance < best_distance:
+				best_key, best_distance = key, distance
+		return best_key